@@ -0,0 +1,52 @@
+/*
+    Minimal timing helpers for the benchmark programs in this directory.
+
+    Built only with -DSCL2_BUILD_BENCHMARKS=ON, nothing here is installed.
+    Every program prints one line per case: the best of `runs` wall clock
+    times, which is steadier than the mean on a busy machine.
+*/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+namespace scl2::bench {
+
+// keeps the optimizer from dropping a result, pass something derived from it
+inline void keep(size_t value)
+{
+    static volatile size_t sink;
+    sink = value;
+}
+
+// best of `runs` calls of `f`, in milliseconds
+template <typename F>
+double best_ms(int runs, F&& f)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - start;
+        best = std::min(best, took.count());
+    }
+    return best;
+}
+
+inline void report(const char* name, double bytes, double ms)
+{
+    std::printf("%-40s %10.2f ms  %8.1f MB/s\n", name, ms, bytes / 1e6 / (ms / 1e3));
+}
+
+// runs from argv[1], 7 if not given
+inline int runs(int argc, char** argv)
+{
+    return argc > 1 ? std::max(1, std::atoi(argv[1])) : 7;
+}
+
+} // namespace scl2::bench
@@ -0,0 +1,63 @@
+/*
+    json_parser / json_exporter number paths.
+
+    2M random doubles and 2M integers of mixed width, parsed from one JSON
+    array, then the doubles exported again. The last line counts the
+    doubles that survive export and parse bit for bit.
+
+    usage: bench_json_numbers [runs]
+*/
+#include "bench.hpp"
+
+#include "json.hpp"
+
+#include <bit>
+#include <cmath>
+#include <random>
+
+using namespace scl2;
+
+int main(int argc, char** argv)
+{
+    const int runs = bench::runs(argc, argv);
+    constexpr size_t count = 2'000'000;
+
+    std::mt19937_64 rng(42);
+    std::vector<json_value> doubles, integers;
+    std::vector<double> expected;
+    doubles.reserve(count);
+    integers.reserve(count);
+    expected.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        // any finite double, from subnormals to huge exponents
+        double d;
+        do d = std::bit_cast<double>(rng()); while (!std::isfinite(d));
+        doubles.push_back(json_value(d));
+        expected.push_back(d);
+        // 1 to 19 digits, both signs
+        int64_t v = static_cast<int64_t>(rng() >> (rng() % 63));
+        integers.push_back(json_value((rng() & 1) ? v : -v));
+    }
+    const json double_doc(json_value(std::move(doubles)));
+    const json integer_doc(json_value(std::move(integers)));
+
+    std::string double_text = double_doc.toCompatString();
+    const std::string integer_text = integer_doc.toCompatString();
+
+    double ms = bench::best_ms(runs, [&] { bench::keep(json::fromString(double_text).size()); });
+    bench::report("parse 2M random doubles", static_cast<double>(double_text.size()), ms);
+
+    ms = bench::best_ms(runs, [&] { bench::keep(json::fromString(integer_text).size()); });
+    bench::report("parse 2M mixed-width integers", static_cast<double>(integer_text.size()), ms);
+
+    ms = bench::best_ms(runs, [&] { double_text = double_doc.toCompatString(); });
+    bench::report("export 2M random doubles", static_cast<double>(double_text.size()), ms);
+
+    const json parsed = json::fromString(double_text);
+    size_t exact = 0;
+    for (size_t i = 0; i < count; ++i) {
+        exact += std::bit_cast<uint64_t>(parsed[i].as_double()) == std::bit_cast<uint64_t>(expected[i]);
+    }
+    std::printf("exact double round trip                  %zu / %zu\n", exact, count);
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*
+    json_parser: scalar vs structural (two-stage) parse mode.
+
+    Parses the same generated documents, pretty-printed and compact, once
+    per mode. The structural mode pays for its index on small inputs and
+    wins on whitespace-heavy ones, which is why `automatic` only switches
+    to it from json_parser::structural_threshold bytes up.
+
+    usage: bench_json_parse [runs]
+*/
+#include "bench.hpp"
+
+#include "json.hpp"
+
+#include <random>
+
+using namespace scl2;
+
+// records of mixed strings, numbers, booleans and nested arrays
+static json make_document(size_t records)
+{
+    std::mt19937_64 rng(42);
+    std::vector<json_value> list;
+    list.reserve(records);
+    for (size_t i = 0; i < records; ++i) {
+        std::map<std::string, json_value> record;
+        record.emplace("id", json_value(static_cast<int64_t>(i)));
+        record.emplace("name", json_value("user \"" + std::to_string(rng() % 100000) + "\" of the bench"));
+        record.emplace("score", json_value(static_cast<double>(rng() % 1000000) / 997.0));
+        record.emplace("active", json_value((rng() & 1) != 0));
+        std::vector<json_value> tags;
+        for (int t = 0; t < 4; ++t) tags.push_back(json_value("tag" + std::to_string(rng() % 50)));
+        record.emplace("tags", json_value(std::move(tags)));
+        list.push_back(json_value(std::move(record)));
+    }
+    return json(json_value(std::move(list)));
+}
+
+int main(int argc, char** argv)
+{
+    const int runs = bench::runs(argc, argv);
+
+    for (size_t records : {1000, 100000}) {
+        json doc = make_document(records);
+        const std::string pretty = doc.toString();
+        const std::string compact = doc.toCompatString();
+
+        for (const std::string* text : {&pretty, &compact}) {
+            const char* style = text == &pretty ? "pretty" : "compact";
+            for (json_parse_mode mode : {json_parse_mode::scalar, json_parse_mode::structural}) {
+                const char* mode_name = mode == json_parse_mode::scalar ? "scalar" : "structural";
+                double ms = bench::best_ms(runs, [&] {
+                    json parsed = json::fromString(*text, mode);
+                    bench::keep(parsed.size());
+                });
+                const std::string name = std::to_string(records) + " records, " + style + ", " + mode_name;
+                bench::report(name.c_str(), static_cast<double>(text->size()), ms);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+/*
+    xml::document::deserialize() on generated documents of about 0.2, 0.8
+    and 8 MB: nested records with attributes, text, entity references and
+    comments. The old recursive parser copied the rest of the input at
+    every node, so its time grew with the square of the size.
+
+    usage: bench_xml_parse [runs]
+*/
+#include "bench.hpp"
+
+#include "xml.hpp"
+
+#include <random>
+
+static std::string make_document(size_t records)
+{
+    std::mt19937 rng(42);
+    std::string text = "<?xml version=\"1.0\"?>\n<catalog xmlns:x=\"urn:bench\">\n";
+    for (size_t i = 0; i < records; ++i) {
+        text += "  <book id=\"b" + std::to_string(i) + "\" x:lang=\"en\">\n";
+        text += "    <title>Volume " + std::to_string(rng() % 10000) + " &amp; notes</title>\n";
+        text += "    <!-- reviewed -->\n";
+        text += "    <price currency=\"EUR\">" + std::to_string(rng() % 100) + ".99</price>\n";
+        text += "    <tags><tag>a</tag><tag>b &lt; c</tag><tag/></tags>\n";
+        text += "  </book>\n";
+    }
+    text += "</catalog>\n";
+    return text;
+}
+
+using namespace scl2;
+
+int main(int argc, char** argv)
+{
+    const int runs = bench::runs(argc, argv);
+
+    for (size_t records : {1000, 4000, 40000}) {
+        const std::string text = make_document(records);
+        double ms = bench::best_ms(runs, [&] {
+            xml::document doc;
+            doc.deserialize(text);
+            bench::keep(doc.getRootNode().getChildNodes().size());
+        });
+        const std::string name = std::to_string(records) + " records";
+        bench::report(name.c_str(), static_cast<double>(text.size()), ms);
+    }
+    return 0;
+}
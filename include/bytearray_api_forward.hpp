@@ -93,28 +93,32 @@ T gload(scl2::bytearray& data);
 // And decode it only in one line.
 
 namespace gdp_detail {
-    // 前向声明，用于递归
+    // 基础定义：没有 value_type 的类型不是容器
+    // (the element checks must not be instantiated for them, or types that only
+    // have dump()/load() fail to compile)
     template <typename T>
-    struct has_gdump_recursive;
+    struct has_gdump_recursive {
+        static constexpr bool value = false;
+    };
 
     template <typename T>
-    struct has_gload_recursive;
+    struct has_gload_recursive {
+        static constexpr bool value = false;
+    };
 
-    // 基础定义：判断 T 是否为容器且其元素是否满足 dump/load 约束
+    // 容器：判断其元素是否满足 dump/load 约束
     template <typename T>
-    struct has_gdump_recursive {
-        static constexpr bool value = requires {
-            typename T::value_type;
-        } && (::scl2::has_gdump<typename T::value_type> || 
-              has_gdump_recursive<typename T::value_type>::value);
+    requires requires { typename T::value_type; }
+    struct has_gdump_recursive<T> {
+        static constexpr bool value = ::scl2::has_gdump<typename T::value_type> || 
+              has_gdump_recursive<typename T::value_type>::value;
     };
 
     template <typename T>
-    struct has_gload_recursive {
-        static constexpr bool value = requires {
-            typename T::value_type;
-        } && (::scl2::has_gload<typename T::value_type> || 
-              has_gload_recursive<typename T::value_type>::value);
+    requires requires { typename T::value_type; }
+    struct has_gload_recursive<T> {
+        static constexpr bool value = ::scl2::has_gload<typename T::value_type> || 
+              has_gload_recursive<typename T::value_type>::value;
     };
 }
 
@@ -23,6 +23,8 @@
 #pragma once
 
 #include "xml.hpp"
+#include "xml_query.hpp"
+#include "xml_writer.hpp"
 #include "uri.hpp"
 
 namespace html
@@ -127,9 +129,16 @@ public:
     // Note: this overwrites previous body if any
     void addHtmlBody(::html::body &&bdy);
 
+    // path queries (xml_query.hpp) over <head> and <body>, which are the
+    // children of the document node here: "/body/div", "//a[@href]".
+    // Keep the query for repeated lookups, it indexes on first use.
+    xml::query query() const;
+    std::vector<const xml::node*> select(std::string_view path) const; // one-off, no index
+
     // parsing and serializing
     void deserialize(const std::string& html_text);
     std::string serialize() const;
+    void serialize(xml::sink& out) const; // streamed in chunks, see xml_writer.hpp
 
     void clear(); // clear entire document to default state
     void reset(); // reset entire document to invalid state
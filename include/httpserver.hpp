@@ -8,17 +8,24 @@
     Note that this is an individual link target and is not included in the main
     network library by default.
     You don't need to link network module separately when using http server module.
+
+    On Linux, run() serves with a tcp::multi_server instead of tick(): one
+    event loop per core, each with its own connections. Route handlers then
+    run concurrently on those threads and must be thread safe.
 */
 
 #pragma once
 
 #include "tcpserver.hpp"
+#include "tcpmultiserver.hpp"
 #include "http.hpp"
 
 #include <functional>
 #include <map>
+#include <optional>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace network::http {
 
@@ -40,7 +47,7 @@ public:
     void start();
     void start(uint16_t port);
     
-    /// @brief Stop the HTTP server
+    /// @brief Stop the HTTP server. Thread safe while run() is serving.
     void stop();
 
     /// @brief Register a route handler for a specific path and method
@@ -53,6 +60,17 @@ public:
     /// @return Number of new clients accepted, or -1 if not running
     int tick();
 
+#if defined(__linux__)
+    /// @brief Serve on several event loop threads until stop(), instead of start() and tick().
+    /// A stop() from another thread ends run() as soon as it has begun starting the
+    /// event loops, even before they run; a stop() that returns before that is not kept.
+    /// @param opts Reactor count (default: one per core), distribution, CPU pinning and per loop options
+    void run(const tcp::multi_server::options& opts = {});
+
+    /// @brief Thread safe. Counters of each event loop of run().
+    std::vector<tcp::event_server::statistics> stats() const;
+#endif
+
     uint16_t port() const;
     network_address address() const;
 
@@ -60,9 +78,18 @@ private:
     /// @brief Handle incoming data from a TCP client
     void handleClient(tcp::client_id id);
 
+    /// @brief Answer the first request in `buffer` once it is complete, and remove it from `buffer`.
+    /// @return The serialized response, std::nullopt while the request is incomplete
+    std::optional<std::string> respond(std::string& buffer) const;
+
     tcp::server m_tcp_server;
     std::map<std::pair<http_method, std::string>, route_handler> m_routes;
     std::map<tcp::client_id, std::string> m_client_buffers; // Partial HTTP requests
+#if defined(__linux__)
+    // last, so it is destroyed first: ~multi_server joins the reactor threads
+    // while the routes they respond() with are still alive
+    tcp::multi_server m_multi_server;
+#endif
 };
 
 } // namespace network::http
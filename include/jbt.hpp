@@ -0,0 +1,156 @@
+/*
+    jbt - compact binary JSON for SharedCppLib2
+
+    A binary encoding of json_value that can be queried in place: a cached
+    blob (or a memory-mapped file) is wrapped in a jbt_view and read without
+    being parsed or copied.
+
+    - containers are length-prefixed and carry an offset table, so the n-th
+      array element is found in O(1),
+    - object members are stored sorted by key, lookups are a binary search,
+    - integers are zigzag varints, strings are varint length + raw bytes.
+
+    Layout (all fixed-size fields little endian):
+
+        document  := "JBT" 0x01, u32 payload size, value
+        value     := tag (1 byte) + payload
+          null / false / true      tag 0 / 1 / 2
+          integer                  tag 3, zigzag LEB128
+          floating                 tag 4, IEEE 754 double
+          string                   tag 5, LEB128 length, bytes
+          array                    tag 6, u32 body size, u32 count, u32 offset[count], elements
+          object                   tag 7, u32 body size, u32 count, u32 offset[count], members
+          bytearray / data URI     tag 8 / 9, LEB128 length, bytes (SCL2_JSON_ENABLE_EXTENSIONS)
+        member    := LEB128 key length, key bytes, value
+
+    Offsets are relative to the container's tag byte, the body size counts
+    everything after the body size field. Members are sorted bytewise by key.
+
+    With SCL2_JSON_ENABLE_EXTENSIONS, json::dump()/json::load() use this
+    format, so gdump()/gload() work on json values.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.1
+    cpp_generation: cxx17 - cxx23
+    standalone_dependency: json
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "json.hpp"
+
+namespace scl2 {
+
+/*
+    One value inside jbt data. Only a pointer into the data plus the end of
+    the enclosing range, valid as long as the data is.
+
+    Every access is bounds-checked, malformed data throws std::runtime_error
+    instead of reading outside the buffer.
+*/
+class jbt_value {
+public:
+    jbt_value() = default; // invalid value
+
+    bool valid() const { return p_ != nullptr; }
+    explicit operator bool() const { return valid(); }
+
+    json_value_type type() const;
+
+    bool is_null() const { return type() == json_value_type::null; }
+    bool is_bool() const { return type() == json_value_type::boolean; }
+    bool is_int() const { return type() == json_value_type::integer; }
+    bool is_double() const { return type() == json_value_type::floating; }
+    bool is_number() const { return is_int() || is_double(); }
+    bool is_string() const { return type() == json_value_type::string; }
+    bool is_array() const { return type() == json_value_type::array; }
+    bool is_object() const { return type() == json_value_type::object; }
+
+    bool as_bool() const;
+    int64_t as_int() const;
+    double as_double() const;           // integers are converted
+    std::string_view as_string() const; // points into the data
+
+    // array & object: element count; string: length; other: 0.
+    size_t size() const;
+
+    // for array, O(1)
+    jbt_value operator[](size_t index) const;
+    jbt_value at(size_t index) const { return operator[](index); }
+
+    // for object, binary search
+    jbt_value find(std::string_view key) const; // invalid value if missing
+    bool has_key(std::string_view key) const { return find(key).valid(); }
+    jbt_value operator[](std::string_view key) const;
+    jbt_value at(std::string_view key) const { return operator[](key); }
+
+    // object members in key order
+    std::string_view key_at(size_t index) const;
+    jbt_value value_at(size_t index) const;
+
+    jbt_value at_path(const json_pointer& pointer) const;
+
+    json_value to_value() const;
+
+private:
+    friend class jbt_view;
+
+    jbt_value(const uint8_t* p, const uint8_t* end) : p_(p), end_(end) {}
+
+    uint8_t tag() const;
+    const uint8_t* containerEnd() const; // also validates the container header
+    jbt_value child(size_t index) const; // element or member entry, no range check on index
+
+    const uint8_t* p_ = nullptr;   // tag byte
+    const uint8_t* end_ = nullptr; // end of the enclosing range
+};
+
+/*
+    A jbt document in memory that is not owned: a cached blob, a bytearray,
+    a memory-mapped file. Only the header is checked on construction.
+*/
+class jbt_view {
+public:
+    jbt_view() = default;
+
+    /// @brief View the document at `data`. Throws if the header is invalid or the data is truncated.
+    /// Data after the document is allowed and ignored.
+    jbt_view(const void* data, size_t size);
+    explicit jbt_view(std::string_view data) : jbt_view(data.data(), data.size()) {}
+
+    static bool is_jbt(const void* data, size_t size);
+
+    jbt_value root() const { return root_; }
+    jbt_value operator[](std::string_view key) const { return root_[key]; }
+    jbt_value operator[](size_t index) const { return root_[index]; }
+    jbt_value at_path(const json_pointer& pointer) const { return root_.at_path(pointer); }
+
+    // header + payload
+    size_t byte_size() const { return size_; }
+
+    static constexpr size_t header_size = 8;
+
+private:
+    jbt_value root_;
+    size_t size_ = 0;
+};
+
+class jbt {
+public:
+    /// @brief Encode `value` as a jbt document.
+    static std::string encode(const json_value& value);
+
+    /// @brief Append the encoding of `value` to `out`.
+    static void encode(const json_value& value, std::string& out);
+
+    /// @brief Decode a whole document back into a json tree.
+    static json decode(const void* data, size_t size);
+    static json decode(std::string_view data) { return decode(data.data(), data.size()); }
+};
+
+} // namespace scl2
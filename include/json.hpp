@@ -10,16 +10,19 @@
     Even if they are enabled, they are still within standard JSON format. It just
     make it easier to use in some cases.
 
-    Also check jbt if you want some even more compact storage of json data.
+    Also check jbt (jbt.hpp) if you want some even more compact storage of json data.
 
     [SCL_STANDALONE_MODULE]
-    version: 1.9.0
+    version: 1.17.1
     cpp_generation: cxx17 - cxx23
+    standalone_dependency: output_sink
 */
 
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <variant>
 #include <vector>
 #include <map>
@@ -27,6 +30,9 @@
 #include <stdexcept>
 #include <type_traits>
 #include <filesystem>
+#include <iosfwd>
+
+#include "output_sink.hpp"
 
 #ifdef __cpp_lib_generator
     #include <generator>
@@ -54,6 +60,7 @@ class json_value;
 class json;
 class json_parser;
 class json_exporter;
+class json_cursor;
 
 typedef std::vector<json_value> json_array;
 typedef std::map<std::string, json_value> json_object;
@@ -75,6 +82,13 @@ enum class json_value_type : uint8_t {
 // so we can only use 6 bytes, for up to 63 types, which is quite enough for any future
 // use in json. we won't need more.
 
+// How json_parser walks the input.
+enum class json_parse_mode : uint8_t {
+    scalar = 0,      // classic recursive descent, one character at a time
+    structural = 1,  // two-stage: vectorized structural index first, then build the tree from it
+    automatic = 2,   // structural for inputs of json_parser::structural_threshold bytes and up
+};
+
 // abstract pointer layer.
 class json_pointer {
 public:
@@ -84,17 +98,67 @@ public:
     json_value& apply(json_value& root) const;
     bool contains(const json_value& root) const;
 
+    // resolve against raw JSON text without parsing it, see json_cursor
+    json_cursor apply(const json_cursor& root) const;
+    bool contains(const json_cursor& root) const;
+
     std::string to_string() const;
 
+    // unescaped reference tokens, one per path segment
+    const std::vector<std::string>& segments() const { return tokens; }
+
+    // every segment parsed as an array index once, at construction:
+    // npos if it is not a number, index_overflow (past any array size) if it overflows
+    const std::vector<size_t>& indices() const { return token_indices; }
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    static constexpr size_t index_overflow = npos - 1;
+
 private:
     void split_tokens();
     std::string unescape_segment(std::string segment) const;
-    json_value& apply_impl(const json_value& current, size_t depth) const;
     json_value& apply_impl(json_value& current, size_t depth) const;
-    bool contains_impl(const json_value& current, size_t depth) const;
 
     std::string pointer_str;
     std::vector<std::string> tokens;
+    std::vector<size_t> token_indices;
+};
+
+/*
+    Many pointers evaluated against one document in a single traversal.
+
+    The pointers are merged into a prefix tree when they are added, so a
+    shared prefix such as "/request/headers" is resolved once for all the
+    pointers below it. Missing targets are reported as nullptr instead of
+    throwing.
+*/
+class json_pointer_set {
+public:
+    json_pointer_set();
+    json_pointer_set(const std::vector<std::string>& pointers);
+
+    /// @brief Add a pointer. Returns its slot in the results of resolve().
+    size_t add(const json_pointer& pointer);
+
+    size_t size() const { return pointer_count; }
+
+    /// @brief results[i] becomes the target of the i-th pointer, or nullptr if it does not exist.
+    /// The results are valid as long as the document is not modified.
+    void resolve(const json_value& root, std::vector<const json_value*>& results) const;
+    std::vector<const json_value*> resolve(const json_value& root) const;
+
+private:
+    struct node {
+        std::string key;
+        size_t index = json_pointer::npos; // key as array index
+        std::vector<size_t> children;      // positions in nodes
+        std::vector<size_t> targets;       // pointers that end here
+    };
+
+    void resolveNode(const node& n, const json_value& value, std::vector<const json_value*>& results) const;
+
+    std::vector<node> nodes; // nodes[0] is the document root
+    size_t pointer_count = 0;
 };
 
 class json_value {
@@ -260,8 +324,8 @@ public:
     json(json_value&& v);
 
     // static factory functions
-    static json fromString(const std::string& str);
-    static json fromFile(const std::filesystem::path& path);
+    static json fromString(const std::string& str, json_parse_mode mode = json_parse_mode::automatic);
+    static json fromFile(const std::filesystem::path& path, json_parse_mode mode = json_parse_mode::automatic);
     static json fromString(const std::wstring& wstr) { return fromString(json_value::json_wtoa(wstr)); }
 
     std::string toString() const;
@@ -271,6 +335,12 @@ public:
     // This uses the default format. If you want anything else, do it yourself.
     std::string toFile(const std::filesystem::path& path) const;
 
+#ifdef SCL2_JSON_ENABLE_EXTENSIONS
+    // binary (jbt) form, makes json work with gdump()/gload(). Implemented in jbt.cpp.
+    scl2::bytearray dump() const;
+    void load(scl2::bytearray& data); // reads one document at the read cursor
+#endif
+
     inline json_value& value() { return *this; }
     inline const json_value& value() const { return *this; }
 
@@ -278,21 +348,35 @@ private:
     // this class has no secrets
 };
 
+#ifdef SCL2_JSON_ENABLE_EXTENSIONS
+scl2_check_generic_dump_load(json)
+#endif
+
 /*
     This class is automatically called by json static factory,
     and user better not use it directly.
 */
 class json_parser {
+    friend class json_cursor;
+    friend class json_reader;
+    friend class json_bind_reader;
 public:
     void parseFromString(const std::string& str_input);
     json&& getResult();
 
+    // Below this size the index pass costs more than it saves.
+    static constexpr size_t structural_threshold = 16 * 1024;
+
+    json_parse_mode parseMode = json_parse_mode::automatic;
+
 private:
     // helper functions
     void skipWhitespace();
     char peek() const;
 
     std::string parseJsonString();
+    void skipJsonString(); // validated like parseJsonString(), nothing decoded
+    void scanJsonString(std::string* out);
     json_value parseJsonValue();
     
     json_value parseNull();
@@ -304,6 +388,14 @@ private:
 
     std::pair<std::string, json_value> getNextObject();
 
+    // structural mode (stage 1 builds the index, stage 2 consumes it)
+    bool buildStructuralIndex();
+    char nextStructural(const char* error_message);
+    char peekStructural() const;
+    json_value parseIndexedValue();
+    json_value parseIndexedObject();
+    json_value parseIndexedArray();
+
     // assert functions
     void jexpect(char c, const char* error_message) const;
     void jexpect(const char* expected, const char* error_message) const;
@@ -311,13 +403,29 @@ private:
     void jinbound() const;
     void jinbound(const char* error_message) const;
     bool jisdigit(char c) const;
+    void jatomend() const;
 
-    std::string json_str;
+    std::string_view json_str; // only valid during parseFromString()
     size_t pos;
     json result_root;
+
+    std::vector<uint32_t> structural_index; // offsets of structurals, strings and scalar atoms
+    size_t index_pos = 0;
 };
 
 
+/*
+    Destination of json_exporter::exportTo(), the sinks shared with xml::writer.
+
+    The exporter hands over its output in chunks of at most about
+    json_exporter::sink_chunk_size bytes (longer string values are passed
+    through in one piece), so a document never has to exist as a whole in memory.
+*/
+using json_sink = output_sink;
+using json_string_sink = string_sink;
+using json_ostream_sink = ostream_sink;
+using json_fd_sink = fd_sink;
+
 class json_exporter {
 public:
 
@@ -336,6 +444,15 @@ public:
     std::string exportToString(const json& j);
     std::string exportToCompatString(const json& j);
 
+    /// @brief Stream `value` into `sink` in chunks of about sink_chunk_size bytes.
+    void exportTo(const json_value& value, json_sink& out);
+
+    static constexpr size_t sink_chunk_size = 64 * 1024;
+
+    // the exporter's string escaping (no quotes added) and double formatting, for code writing JSON itself
+    static void appendEscaped(std::string& out, std::string_view str, bool escapeNonAscii = false);
+    static void appendDouble(std::string& out, double d); // shortest round-trip form, null for NaN/infinity
+
     // just let user directly set these flags if needed.
     // We aren't multi-threading anyway.
     bool isCompat = false;
@@ -346,7 +463,7 @@ public:
 private:
 
     void exportValue(const json_value& value, size_t indentLevel);
-    std::string escapeJsonString(const std::string& str);
+    void escapeJsonString(std::string_view str);
 
     void exportKey(const std::string& key, size_t indentLevel);
 
@@ -359,14 +476,103 @@ private:
 
     void jindent(size_t indentLevel);
     void jnline();
-    std::string jquote(const std::string& str);
+    void jquote(std::string_view str);
+
+    // output, buffered in result_str and handed to the sink (if any) when it gets large
+    void jwrite(const char* data, size_t size);
+    void jwrite(std::string_view str) { jwrite(str.data(), str.size()); }
+    void jput(char c);
+    void jflush();
 
     size_t indentLevel = 0;
     std::string result_str;
+    json_sink* sink = nullptr;
 };
 
 
 
+/*
+    Lazy, read-only view of raw JSON text.
+
+    A cursor is just the text and the offset of one value in it. Navigating
+    (find, at, json_pointer) scans forward and skips every value that is not
+    on the way by bracket matching, without decoding or allocating anything.
+    Only the values you finally read with as_*() or to_value() are parsed.
+
+    The text must outlive every cursor created from it. Malformed input is
+    only reported when the cursor runs into it.
+*/
+class json_cursor {
+public:
+    json_cursor() = default; // invalid cursor
+    explicit json_cursor(std::string_view text);
+
+    bool valid() const { return pos != npos; }
+    explicit operator bool() const { return valid(); }
+
+    json_value_type type() const;
+    bool is_null() const { return type() == json_value_type::null; }
+    bool is_bool() const { return type() == json_value_type::boolean; }
+    bool is_int() const { return type() == json_value_type::integer; }
+    bool is_double() const { return type() == json_value_type::floating; }
+    bool is_string() const { return type() == json_value_type::string; }
+    bool is_array() const { return type() == json_value_type::array; }
+    bool is_object() const { return type() == json_value_type::object; }
+
+    // decode this value only
+    bool as_bool() const;
+    int64_t as_int() const;
+    double as_double() const; // integers are converted
+    std::string as_string() const;
+    json_value to_value() const;
+
+    // the raw text of this value, strings include their quotes
+    std::string_view raw() const;
+
+    // for object: invalid cursor if the key is missing, first one on duplicates
+    json_cursor find(std::string_view key) const;
+    bool has_key(std::string_view key) const { return find(key).valid(); }
+    json_cursor operator[](std::string_view key) const; // throws if missing
+
+    // for array: invalid cursor if out of range
+    json_cursor at(size_t index) const;
+    json_cursor operator[](size_t index) const; // throws if out of range
+
+    json_cursor at_path(const json_pointer& pointer) const;
+
+    // array & object: element count (walks the container);
+    // string: raw length between the quotes, escapes not decoded; other: 0.
+    size_t size() const;
+
+#ifdef __cpp_lib_generator
+    std::generator<json_cursor> array_elements() const;
+    std::generator<std::pair<std::string, json_cursor>> object_members() const;
+#endif
+
+private:
+    static constexpr size_t npos = std::string_view::npos;
+
+    json_cursor(std::string_view text, size_t pos) : text(text), pos(pos) {}
+
+    void jexpect(json_value_type expected, const char* error_message) const;
+    size_t skipWhitespace(size_t p) const;
+    size_t skipString(size_t p) const;
+    size_t skipValue(size_t p) const;
+    size_t firstItem(char close) const; // first value/key of this container, npos if empty
+    size_t nextItem(size_t value_end, char close) const;
+    bool keyEquals(size_t quote, size_t end, std::string_view key) const;
+    std::string decodeString(size_t quote) const;
+
+    std::string_view text;
+    size_t pos = npos;
+};
 
+namespace json_detail {
+    // Stage 1 of json_parse_mode::structural, shared with json_document.
+    // Fills `index` with the offsets of {}[]:, outside strings, the opening quote of every
+    // string and the first byte of every scalar. Returns false when the input has to go
+    // through the scalar parser instead (larger than 4 GiB, or comments when enabled).
+    bool build_structural_index(std::string_view text, std::vector<uint32_t>& index);
+} // namespace json_detail
 
 } // namespace scl2
\ No newline at end of file
@@ -0,0 +1,347 @@
+/*
+    Json Binding for SharedCppLib2
+
+    Reads JSON text straight into your structs and writes them back, without
+    building a json_value tree in between. Describe the fields once:
+
+        struct address { std::string city; int zip = 0; };
+        struct person {
+            std::string name;
+            int age = 0;
+            std::vector<address> addresses;
+            std::optional<std::string> email;
+        };
+
+        SCL2_JSON_BINDING(address, SCL2_JSON_FIELD(address, city), SCL2_JSON_FIELD(address, zip))
+        SCL2_JSON_BINDING(person,
+            SCL2_JSON_FIELD(person, name),
+            SCL2_JSON_FIELD(person, age),
+            scl2::json_field("addr", &person::addresses), // different key
+            SCL2_JSON_FIELD(person, email))
+
+        person p = scl2::json_bind::parse<person>(text);
+        std::string out = scl2::json_bind::to_string(p);
+
+    The field list is a constexpr tuple of (key, member pointer) pairs, so the
+    parser dispatches every key to a direct member write; keys that arrive in
+    declaration order are matched with a single comparison.
+
+    Supported member types: bool, integers (range checked), floating point,
+    std::string, std::optional, std::vector, std::map<std::string, T>,
+    json_value (any JSON) and other bound types. Unknown keys are skipped,
+    missing keys keep the member's default value, and of duplicate keys the
+    first one wins (as in json_parser).
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: json
+*/
+
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+
+namespace scl2 {
+
+template<typename Class, typename Member>
+struct json_field {
+    using class_type = Class;
+    using member_type = Member;
+
+    constexpr json_field(std::string_view name, Member Class::* member) : name(name), member(member) {}
+
+    std::string_view name;
+    Member Class::* member;
+};
+
+// Specialize with `static constexpr auto fields = std::make_tuple(json_field(...), ...);`,
+// or use SCL2_JSON_BINDING.
+template<typename T>
+struct json_binding;
+
+template<typename T>
+concept json_bound = requires { json_binding<T>::fields; };
+
+#define SCL2_JSON_FIELD(TYPE, MEMBER) ::scl2::json_field(#MEMBER, &TYPE::MEMBER)
+
+#define SCL2_JSON_BINDING(TYPE, ...) \
+    template<> struct scl2::json_binding<TYPE> { \
+        static constexpr auto fields = std::make_tuple(__VA_ARGS__); \
+    };
+
+/*
+    Token level access used by the binding templates, works directly on the
+    input text. Error messages are the ones of json_parser.
+*/
+class json_bind_reader {
+public:
+    explicit json_bind_reader(std::string_view text);
+
+    /// @brief Consume `null` if it is next.
+    bool readNull();
+    bool readBool();
+    int64_t readInt();
+    uint64_t readUInt();
+    double readDouble(); // integers are accepted
+    void readString(std::string& out);
+
+    /// @brief Key of the next member, a view into the input unless it has escapes (then it is decoded into `scratch`).
+    std::string_view readKey(std::string& scratch);
+
+    // containers: begin returns false for an empty one, next is called after each member/element
+    bool beginObject();
+    bool nextMember();
+    bool beginArray();
+    bool nextElement();
+
+    void skipValue();
+    json_value readValue(); // any JSON value as a tree
+
+    /// @brief Only whitespace may follow the value.
+    void finish();
+
+private:
+    char peekToken(); // after skipping whitespace, throws at the end of input
+    size_t numberEnd(bool& integer) const;
+
+    json_parser parser; // holds the text and the position
+};
+
+// Writes compact JSON.
+class json_bind_writer {
+public:
+    explicit json_bind_writer(std::string& out) : out(out) {}
+
+    void writeNull() { out += "null"; }
+    void writeBool(bool b) { out += b ? "true" : "false"; }
+    void writeInt(int64_t i);
+    void writeUInt(uint64_t u);
+    void writeDouble(double d); // shortest round-trip form, null for NaN/infinity
+    void writeString(std::string_view str);
+    void writeKey(std::string_view key) { writeString(key); out += ':'; }
+    void writeValue(const json_value& value);
+    void put(char c) { out += c; }
+
+private:
+    std::string& out;
+};
+
+namespace json_bind_detail {
+
+template<typename T> struct is_optional : std::false_type {};
+template<typename T> struct is_optional<std::optional<T>> : std::true_type {};
+
+template<typename T> struct is_vector : std::false_type {};
+template<typename T, typename A> struct is_vector<std::vector<T, A>> : std::true_type {};
+
+template<typename T> struct is_string_map : std::false_type {};
+template<typename T, typename C, typename A> struct is_string_map<std::map<std::string, T, C, A>> : std::true_type {};
+
+template<typename T>
+void read(json_bind_reader& r, T& out);
+
+template<typename T>
+void write(json_bind_writer& w, const T& value);
+
+// one entry per field: read the value into the member
+template<typename T, size_t I>
+void readField(json_bind_reader& r, T& obj)
+{
+    const auto& field = std::get<I>(json_binding<T>::fields);
+    read(r, obj.*(field.member));
+}
+
+template<typename T, size_t... I>
+void readObject(json_bind_reader& r, T& obj, std::index_sequence<I...>)
+{
+    static constexpr size_t count = sizeof...(I);
+    static constexpr std::array<std::string_view, count> names = { std::get<I>(json_binding<T>::fields).name... };
+    static constexpr std::array<void(*)(json_bind_reader&, T&), count> readers = { &readField<T, I>... };
+
+    if (!r.beginObject()) return;
+    std::string scratch;
+    std::array<bool, count> seen{}; // the first of duplicate keys wins, like in json_parser
+    size_t hint = 0; // members usually come in declaration order
+    do {
+        const std::string_view key = r.readKey(scratch);
+        size_t found = count;
+        for (size_t n = 0; n < count; ++n) {
+            const size_t i = hint + n < count ? hint + n : hint + n - count;
+            if (names[i] == key) { found = i; break; }
+        }
+        if (found == count || seen[found]) {
+            r.skipValue();
+            continue;
+        }
+        seen[found] = true;
+        try {
+            readers[found](r, obj);
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error(std::string(key) + ": " + e.what());
+        }
+        hint = found + 1 < count ? found + 1 : 0;
+    } while (r.nextMember());
+}
+
+template<typename T, size_t... I>
+void writeObject(json_bind_writer& w, const T& obj, std::index_sequence<I...>)
+{
+    w.put('{');
+    bool first = true;
+    auto one = [&](const auto& field) {
+        const auto& member = obj.*(field.member);
+        if constexpr (is_optional<std::remove_cvref_t<decltype(member)>>::value) {
+            if (!member) return; // absent optionals are left out
+        }
+        if (!first) w.put(',');
+        first = false;
+        w.writeKey(field.name);
+        write(w, member);
+    };
+    (one(std::get<I>(json_binding<T>::fields)), ...);
+    w.put('}');
+}
+
+template<typename T>
+void read(json_bind_reader& r, T& out)
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        out = r.readBool();
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        const int64_t v = r.readInt();
+        if (v < std::numeric_limits<T>::min() || v > std::numeric_limits<T>::max())
+            throw std::runtime_error("Invalid JSON number: out of range");
+        out = static_cast<T>(v);
+    } else if constexpr (std::is_integral_v<T>) {
+        const uint64_t v = r.readUInt();
+        if (v > std::numeric_limits<T>::max())
+            throw std::runtime_error("Invalid JSON number: out of range");
+        out = static_cast<T>(v);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        out = static_cast<T>(r.readDouble());
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        r.readString(out);
+    } else if constexpr (is_optional<T>::value) {
+        if (r.readNull()) {
+            out.reset();
+        } else {
+            read(r, out.emplace());
+        }
+    } else if constexpr (is_vector<T>::value) {
+        out.clear();
+        if (!r.beginArray()) return;
+        do {
+            read(r, out.emplace_back());
+        } while (r.nextElement());
+    } else if constexpr (is_string_map<T>::value) {
+        out.clear();
+        if (!r.beginObject()) return;
+        std::string scratch;
+        do {
+            const std::string_view key = r.readKey(scratch);
+            auto [it, inserted] = out.try_emplace(std::string(key));
+            if (inserted) read(r, it->second);
+            else r.skipValue(); // duplicate key, the first one wins
+        } while (r.nextMember());
+    } else if constexpr (std::is_base_of_v<json_value, T>) {
+        out = T(r.readValue());
+    } else if constexpr (json_bound<T>) {
+        readObject(r, out, std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<decltype(json_binding<T>::fields)>>>());
+    } else {
+        static_assert(sizeof(T) == 0, "json_bind: unsupported member type, add a json_binding for it");
+    }
+}
+
+template<typename T>
+void write(json_bind_writer& w, const T& value)
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        w.writeBool(value);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        w.writeInt(value);
+    } else if constexpr (std::is_integral_v<T>) {
+        w.writeUInt(value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        w.writeDouble(static_cast<double>(value));
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        w.writeString(value);
+    } else if constexpr (is_optional<T>::value) {
+        if (value) write(w, *value);
+        else w.writeNull();
+    } else if constexpr (is_vector<T>::value) {
+        w.put('[');
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (i != 0) w.put(',');
+            write(w, value[i]);
+        }
+        w.put(']');
+    } else if constexpr (is_string_map<T>::value) {
+        w.put('{');
+        bool first = true;
+        for (const auto& [key, item] : value) {
+            if (!first) w.put(',');
+            first = false;
+            w.writeKey(key);
+            write(w, item);
+        }
+        w.put('}');
+    } else if constexpr (std::is_base_of_v<json_value, T>) {
+        w.writeValue(value);
+    } else if constexpr (json_bound<T>) {
+        writeObject(w, value, std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<decltype(json_binding<T>::fields)>>>());
+    } else {
+        static_assert(sizeof(T) == 0, "json_bind: unsupported member type, add a json_binding for it");
+    }
+}
+
+} // namespace json_bind_detail
+
+class json_bind {
+public:
+    /// @brief Parse `text` into a new T.
+    template<typename T>
+    static T parse(std::string_view text) {
+        T value{};
+        parse_into(text, value);
+        return value;
+    }
+
+    /// @brief Parse `text` into an existing object; members not present in the text are left untouched.
+    template<typename T>
+    static void parse_into(std::string_view text, T& value) {
+        json_bind_reader reader(text);
+        json_bind_detail::read(reader, value);
+        reader.finish();
+    }
+
+    /// @brief Compact JSON for `value`.
+    template<typename T>
+    static std::string to_string(const T& value) {
+        std::string out;
+        append_to(value, out);
+        return out;
+    }
+
+    template<typename T>
+    static void append_to(const T& value, std::string& out) {
+        json_bind_writer writer(out);
+        json_bind_detail::write(writer, value);
+    }
+};
+
+} // namespace scl2
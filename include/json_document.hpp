@@ -0,0 +1,199 @@
+/*
+    Json Document for SharedCppLib2
+
+    A read-only, arena backed alternative to json_value for large documents.
+
+    json_value keeps every array in its own std::vector and every object in a
+    std::map, so a parsed document is one heap allocation per node and per key.
+    json_document instead places all nodes in a few large arena blocks:
+
+    - array elements and object members are contiguous,
+    - objects keep their members in document order, larger ones carry a sorted
+      index for binary search,
+    - strings without escapes are string_views into the source text, only the
+      escaped ones are decoded into the arena,
+    - destroying or clearing a document frees a handful of blocks, no matter
+      how many nodes it holds.
+
+    Use json when you want to edit values, json_document when you only read them.
+    `to_json()` converts a document (or any node) into the classic model.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.1
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: json
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "json.hpp"
+
+namespace scl2 {
+
+class json_node;
+struct json_member;
+class json_document;
+
+/*
+    Bump allocator used by json_document.
+    Memory is only given back all at once, by release() or the destructor.
+*/
+class json_arena {
+public:
+    explicit json_arena(size_t block_size = 16 * 1024);
+    json_arena(json_arena&& other) noexcept;
+    json_arena& operator=(json_arena&& other) noexcept;
+    json_arena(const json_arena&) = delete;
+    json_arena& operator=(const json_arena&) = delete;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    template<typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "json_arena never runs destructors");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    /// @brief Copy `str` into the arena.
+    std::string_view store(std::string_view str);
+
+    /// @brief Make sure the next `size` bytes come from a single block.
+    void reserve(size_t size);
+
+    /// @brief Drop every block. Cost depends on the block count only.
+    void release();
+
+    size_t used() const { return used_; }         // bytes handed out
+    size_t reserved() const { return reserved_; } // bytes held in blocks
+
+private:
+    struct block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    void grow(size_t min_size);
+
+    std::vector<block> blocks_;
+    std::byte* cur_ = nullptr;
+    size_t left_ = 0;
+    size_t block_size_;
+    size_t used_ = 0;
+    size_t reserved_ = 0;
+};
+
+/*
+    One value inside a json_document. 16 bytes, trivially copyable.
+    Nodes are only handed out by reference and stay valid as long as their document.
+*/
+class json_node {
+public:
+    json_node() = default;
+
+    json_value_type type() const { return type_; }
+
+    bool is_null() const { return type_ == json_value_type::null; }
+    bool is_bool() const { return type_ == json_value_type::boolean; }
+    bool is_int() const { return type_ == json_value_type::integer; }
+    bool is_double() const { return type_ == json_value_type::floating; }
+    bool is_number() const { return is_int() || is_double(); }
+    bool is_string() const { return type_ == json_value_type::string; }
+    bool is_array() const { return type_ == json_value_type::array; }
+    bool is_object() const { return type_ == json_value_type::object; }
+
+    bool as_bool() const;
+    int64_t as_int() const;
+    double as_double() const;   // integers are converted
+    std::string_view as_string() const;
+
+    // for array
+    std::span<const json_node> elements() const;
+    const json_node& operator[](size_t index) const;
+    const json_node& at(size_t index) const { return operator[](index); }
+
+    // for object, members are in document order
+    std::span<const json_member> members() const;
+    const json_node* find(std::string_view key) const; // nullptr if missing, first one on duplicates
+    bool has_key(std::string_view key) const { return find(key) != nullptr; }
+    bool contains(std::string_view key) const { return has_key(key); }
+    const json_node& operator[](std::string_view key) const;
+    const json_node& at(std::string_view key) const { return operator[](key); }
+
+    // array & object: element count; string: length; other: 0.
+    size_t size() const;
+    bool empty() const;
+
+    json_value to_value() const;
+
+    // Objects above this many members get a sorted index for find().
+    static constexpr size_t indexed_object_size = 8;
+
+private:
+    friend class json_document;
+
+    const uint32_t* sorted_index() const; // only for objects larger than indexed_object_size
+
+    json_value_type type_ = json_value_type::null;
+    uint32_t size_ = 0;
+    union {
+        bool boolean;
+        int64_t integer;
+        double floating;
+        const char* string;
+        const json_node* elements;
+        const json_member* members;
+    } data_ = {};
+};
+
+struct json_member {
+    std::string_view key;
+    json_node value;
+};
+
+class json_document {
+public:
+    json_document() = default;
+    json_document(json_document&&) noexcept = default;
+    json_document& operator=(json_document&&) noexcept = default;
+    json_document(const json_document&) = delete;
+    json_document& operator=(const json_document&) = delete;
+
+    /// @brief Parse `text`. Unescaped strings point into it, so it must outlive the document.
+    static json_document parse(std::string_view text);
+
+    /// @brief Parse and keep `text` inside the document.
+    static json_document parse(std::string&& text);
+    static json_document parse(const char* text) { return parse(std::string_view(text)); }
+
+    static json_document fromFile(const std::filesystem::path& path);
+
+    const json_node& root() const { return root_; }
+    const json_node& operator[](std::string_view key) const { return root_[key]; }
+    const json_node& operator[](size_t index) const { return root_[index]; }
+    const json_node& at_path(const json_pointer& pointer) const;
+
+    json to_json() const;
+
+    /// @brief Reset to a null document and free the arena at once.
+    void clear();
+
+    size_t arena_bytes() const { return arena_.reserved(); }
+
+private:
+    class builder;
+
+    json_arena arena_;
+    std::unique_ptr<std::string> owned_; // heap allocated, so views into it survive moves
+    json_node root_;
+};
+
+} // namespace scl2
@@ -0,0 +1,170 @@
+/*
+    Json Reader for SharedCppLib2
+
+    Incremental, event based (pull) JSON parsing for input that does not fit
+    in one string: chunked HTTP bodies, JSON-lines logs, gigabyte files.
+
+    Feed the input in chunks of any size with feed(), and pull events with
+    next() until it asks for more input. Only the unconsumed tail of the input
+    is buffered, so memory stays bounded by the chunk size plus the largest
+    single string or number, whatever the size of the document.
+
+    Several top-level values in a row (JSON lines) are accepted; depth() is 0
+    after the last event of each of them.
+
+    json_sax_handler offers the same events as callbacks, json_subtree_collector
+    builds json_value trees only for the paths you ask for.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.1
+    cpp_generation: cxx17 - cxx23
+    standalone_dependency: json
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.hpp"
+
+namespace scl2 {
+
+enum class json_event : uint8_t {
+    need_input = 0,   // everything fed so far is consumed, feed() more or finish()
+    start_object = 1,
+    end_object = 2,
+    start_array = 3,
+    end_array = 4,
+    key = 5,          // key() holds the member name
+    value = 6,        // value() holds a scalar
+    end_of_input = 7, // finish() was called and the input is complete
+};
+
+class json_sax_handler {
+public:
+    virtual ~json_sax_handler() = default;
+
+    virtual void on_start_object() {}
+    virtual void on_end_object() {}
+    virtual void on_start_array() {}
+    virtual void on_end_array() {}
+    virtual void on_key(const std::string& key) { (void)key; }
+    virtual void on_value(const json_value& value) { (void)value; }
+};
+
+class json_reader {
+public:
+    json_reader() = default;
+
+    /// @brief Append a chunk of input. Chunks may split tokens anywhere.
+    void feed(std::string_view chunk);
+
+    /// @brief Mark the end of the input, pending numbers/literals at the end are completed.
+    void finish();
+
+    /// @brief Next event, need_input when the buffered input runs out. Throws on malformed input.
+    json_event next();
+
+    /// @brief Pull every available event into `handler`. Returns false once the input is complete.
+    bool dispatch(json_sax_handler& handler);
+
+    /// @brief Right after start_object/start_array: drop the whole container without decoding it.
+    /// The next event returned is the matching end_object/end_array.
+    void skip();
+
+    const std::string& key() const { return key_; }
+    const json_value& value() const { return value_; }
+
+    // number of open containers
+    size_t depth() const { return frames_.size(); }
+
+    // json pointer of the value the last event belongs to ("" for a top-level value)
+    std::string path() const;
+
+    // like path() == pattern, but "*" segments in the pattern match any key or index.
+    // With `prefix`, also true when the current path is a prefix of the pattern.
+    bool path_matches(const json_pointer& pattern, bool prefix = false) const;
+
+    size_t buffered() const { return buffer_.size() - offset_; }
+
+    void reset();
+
+private:
+    enum class expect : uint8_t {
+        value,
+        value_or_end, // after '['
+        key,
+        key_or_end,   // after '{'
+        colon,
+        comma_or_end,
+    };
+
+    struct frame {
+        bool object;
+        size_t index;    // current element of an array
+        std::string key; // current member of an object
+    };
+
+    json_event nextEvent();
+    json_event beginValue(char c);
+    json_event closeContainer();
+    void afterValue();
+    size_t pathLength() const;
+
+    // token scanning, return false if the token is not complete yet
+    bool scanString(size_t& length);
+    bool scanAtom(size_t& length);
+
+    std::string buffer_;
+    size_t offset_ = 0;      // consumed bytes in buffer_
+    size_t string_scan_ = 0; // resume point of an incomplete string, relative to offset_
+    bool finished_ = false;
+
+    std::vector<frame> frames_;
+    expect expect_ = expect::value;
+    bool last_start_ = false; // last event opened a container
+    size_t skip_depth_ = 0;   // non-zero while skip() is in progress
+
+    json_parser parser_; // decodes single string/number/literal tokens
+    std::string key_;
+    json_value value_;
+};
+
+/*
+    Builds json_value subtrees for selected paths only, everything else is
+    skipped without being decoded.
+
+    Patterns are json pointers in which a "*" segment matches any key or
+    index, "" matches every top-level value of a JSON-lines stream. Matched
+    subtrees are passed to the callback and then dropped, so memory only
+    depends on the size of a single match.
+*/
+class json_subtree_collector {
+public:
+    using callback = std::function<void(const std::string& path, json_value&& value)>;
+
+    json_subtree_collector(const std::vector<std::string>& patterns, callback on_match);
+
+    /// @brief Pull every available event from `reader`. Returns need_input or end_of_input.
+    json_event consume(json_reader& reader);
+
+private:
+    bool matches(const json_reader& reader) const;
+    bool matchesBelow(const json_reader& reader) const;
+    json_value* addChild(json_value&& child); // nullptr on a duplicate key
+
+    std::vector<json_pointer> patterns_;
+    callback on_match_;
+
+    json_value root_;
+    std::vector<json_value*> stack_; // containers being built, empty when not building
+    std::string root_path_;
+    std::string key_;
+    bool skipping_ = false; // a duplicate member inside a match is being skipped
+};
+
+} // namespace scl2
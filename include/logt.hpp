@@ -33,9 +33,17 @@
 #include <map>
 #include <initializer_list>
 #include <new>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <tuple>
+#include <cstring>
+#include <type_traits>
+#include <span>
 // what a long list of includes
 
 #include "basics.hpp" // for disable_copy, disable_move
+#include "logt_filesink.hpp"
 
 // Enable wide character support if UNICODE is defined
 #ifdef UNICODE
@@ -58,6 +66,13 @@
     #define LOGT_MAX_CHANNEL 16
 #endif
 
+// Compile-time minimum log level (value of LogLevel, 0 = Debug ... 4 = Fatal).
+// Statements below it are compiled out by the LOGT_DEBUG/LOGT_INFO/... macros
+// and turned into null streams by logt_sig, e.g. -DLOGT_MIN_LEVEL=1 for release builds.
+#ifndef LOGT_MIN_LEVEL
+    #define LOGT_MIN_LEVEL 0
+#endif
+
 enum class LogLevel : int8_t {
     Quiet = -1, // For not logging anything (filter only)
     Debug =  0,
@@ -70,9 +85,16 @@ enum class LogLevel : int8_t {
     Inherit = 16, // Inherit from global settings, for channel
 };
 
+// What the ring buffer eventbus does when every slot is occupied
+enum class LogOverflow : int8_t {
+    Block      = 0, // Wait for the worker to free a slot (no message is lost)
+    DropNewest = 1, // Discard the message being pushed
+    DropOldest = 2, // Discard the oldest queued message to make room
+};
+
 struct logt_channel {
     enum class ChannelType {
-        invalid = -1, stdcout = 0, file = 1, custom_ostream = 2
+        invalid = -1, stdcout = 0, file = 1, custom_ostream = 2, file_sink = 3
     };
 
     logt_channel() : type(ChannelType::invalid), enabled(false) {}
@@ -87,6 +109,7 @@ struct logt_channel {
     union {
         std::ofstream fileobj;
         std::ostream* ostream;
+        logt_filesink* sink; // owned
     };
 
     void open(); // reserved
@@ -114,17 +137,195 @@ struct logt_message {
     logt_message(std::string msg, LogLevel level, logt_channelinfo channels);
 };
 
+class logt_site;
+
+// A block of log records formatted in place by one thread, handed to the worker as a whole
+struct logt_chunk {
+    struct record {
+        LogLevel level;
+        logt_channelinfo channels;
+        std::chrono::system_clock::time_point timestamp;
+        size_t offset; // into data
+        size_t length;
+        const logt_site* site; // deferred record: data holds the signature (or prefix), then raw arguments for site->decode
+        size_t prefix;         // deferred record: length of the signature (or prefix)
+        int prefix_flags;      // deferred record: logt::prefix_flags() to format the signature with, -1 if data holds the prefix itself
+    };
+
+    std::thread::id owner; // the thread that wrote the records
+    std::string data;
+    std::vector<record> records;
+
+    inline bool empty() const { return records.empty(); }
+    inline void clear() { data.clear(); records.clear(); } // keeps the capacity for reuse
+    inline std::string_view content(const record& r) const { return std::string_view(data).substr(r.offset, r.length); }
+};
+
+/*
+    Per-thread staging buffers (see logt::useStaging).
+
+    A logt_sso formats into the calling thread's record buffer without any lock,
+    the finished record is then copied into the thread's current chunk under the
+    chunk mutex. Full or stale chunks are handed to the worker in one step and
+    come back through a free list once they are written, so with the default
+    formatter the steady state allocates nothing.
+*/
+class logt_staging {
+public:
+    struct buffer; // per-thread state, lives in logt.cpp
+
+    static void configure(bool enabled, size_t chunk_size, std::chrono::milliseconds flush_interval);
+
+    inline static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    inline static std::chrono::milliseconds flush_interval() {
+        return std::chrono::milliseconds(flush_interval_ms_.load(std::memory_order_relaxed));
+    }
+
+    /// @brief Start a record in the current thread's record buffer.
+    /// @return The stream to format into, or nullptr if this thread is already
+    ///         writing a record (logging from inside operator<<), use a private stream then.
+    static std::ostream* begin_record();
+
+    /// @brief Start a deferred (binary) record in the current thread's record buffer.
+    /// Works whether or not staging is enabled for regular records.
+    /// @return The buffer to append the raw arguments to, or nullptr on nested logging.
+    static std::string* begin_binary();
+
+    /// @brief Finish the record started by begin_record() or begin_binary() on this thread
+    /// and copy it into the current chunk.
+    static void end_record(LogLevel level, logt_channelinfo channels,
+                           const logt_site* site = nullptr, size_t prefix = 0, int prefix_flags = -1);
+
+    /// @brief Whether some thread holds staged records the worker has not taken yet.
+    /// The worker only wakes up on its own (every flush_interval) while this is true.
+    inline static bool pending() { return pending_.load() != 0; }
+
+    /// @brief Take the pending chunks of all threads (worker side).
+    /// @param force Take every non-empty chunk instead of only the stale ones, used on shutdown
+    static void collect(std::vector<std::unique_ptr<logt_chunk>>& out, bool force);
+
+    static std::unique_ptr<logt_chunk> acquire_chunk();
+    static void recycle(std::unique_ptr<logt_chunk> chunk);
+
+private:
+    static buffer& local();
+
+    static std::atomic<bool> enabled_;
+    static std::atomic<size_t> pending_; // non-empty per-thread chunks
+    static std::atomic<size_t> chunk_size_;
+    static std::atomic<int64_t> flush_interval_ms_;
+
+    static std::mutex registry_mutex_;
+    static std::vector<buffer*> registry_;
+
+    static std::mutex pool_mutex_;
+    static std::vector<std::unique_ptr<logt_chunk>> pool_;
+    static constexpr size_t pool_limit = 64;
+};
+
+/*
+    Bounded multi-producer/single-consumer ring of preallocated message slots.
+
+    Every slot carries a sequence number, so producers only compete on one CAS
+    of the enqueue position and never take a lock. The pop side is also safe to
+    call from producers, which is how LogOverflow::DropOldest evicts messages.
+*/
+class logt_ringbuffer {
+public:
+    logt_ringbuffer() = default;
+
+    disable_copy_move(logt_ringbuffer)
+
+    /// @brief (Re)allocate the slots. Not thread-safe, call it before any push.
+    /// @param capacity Number of slots, rounded up to a power of two
+    void reset(size_t capacity);
+
+    /// @brief Move a message into a free slot.
+    /// @return false if the ring is full, `message` is left untouched in that case
+    bool try_push(logt_message& message);
+
+    /// @brief Move the oldest message out of the ring.
+    /// @return false if the ring is empty
+    bool try_pop(logt_message& result);
+
+    bool empty() const;
+    bool full() const;
+    inline size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct slot {
+        std::atomic<size_t> sequence;
+        logt_message message;
+    };
+
+    std::unique_ptr<slot[]> slots_;
+    size_t mask_ = 0;
+
+    // keep the two cursors on separate cache lines
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
 class logt_eventbus {
 public:
-    static void push(const std::string& s, LogLevel level, logt_channelinfo channel);
+    enum class Backend {
+        queue = 0, // mutex guarded std::queue, unbounded (default)
+        ring = 1,  // lock-free bounded logt_ringbuffer
+    };
+
+    static void push(std::string s, LogLevel level, logt_channelinfo channel);
+    static void push_chunk(std::unique_ptr<logt_chunk> chunk);
     static bool pop(logt_message& result);
+
+    /// @brief Wait for work, then move up to `max_count` messages and every pending chunk out of the bus.
+    /// @param timeout Stop waiting after this long, zero waits until something arrives
+    /// @return false once stopped and fully drained
+    static bool pop_batch(std::vector<logt_message>& result, std::vector<std::unique_ptr<logt_chunk>>& chunks,
+                          std::chrono::milliseconds timeout = {}, size_t max_count = default_batch);
     static void stop();
 
+    /// @brief End the worker's current wait in pop_batch() (or make the next one return at once),
+    /// so it picks a new timeout. Used when staged records start piling up.
+    static void wake();
+
+    /// @brief Stop accepting chunks and move the pending ones out (worker side, after the last pop_batch).
+    /// Chunks pushed later are counted in dropped().
+    static void finish(std::vector<std::unique_ptr<logt_chunk>>& chunks);
+
+    /// @brief Switch to the ring buffer backend. Only allowed before the first push.
+    /// @param capacity Number of preallocated slots (rounded up to a power of two)
+    /// @param policy What producers do when the ring is full
+    /// @return false if messages were already pushed or capacity is 0
+    static bool configure_ring(size_t capacity, LogOverflow policy = LogOverflow::Block);
+
+    inline static Backend backend() { return backend_.load(std::memory_order_relaxed); }
+
+    /// @brief Number of messages discarded by the overflow policy, or staged after shutdown, so far.
+    inline static uint64_t dropped() { return dropped_.load(std::memory_order_relaxed); }
+
+    static constexpr size_t default_batch = 256;
+
 private:
+    static void push_ring(logt_message& message);
+    static size_t drain_ring(std::vector<logt_message>& result, size_t max_count);
+
     static std::mutex mutex_;
     static std::condition_variable cond_;
     static std::queue<logt_message> queue_;
+    static std::vector<std::unique_ptr<logt_chunk>> chunks_;
     static std::atomic<bool> stopped_;
+    static bool finished_; // guarded by mutex_
+    static bool woken_;    // guarded by mutex_, see wake()
+
+    // ring backend state
+    static std::atomic<Backend> backend_;
+    static logt_ringbuffer ring_;
+    static LogOverflow policy_;
+    static std::atomic<bool> used_;
+    static std::atomic<bool> consumer_waiting_;
+    static std::atomic<int> blocked_producers_;
+    static std::condition_variable space_cond_;
+    static std::atomic<uint64_t> dropped_;
 };
 
 
@@ -165,10 +366,13 @@ typedef std::function<bool(logt_message&)> preprocessor_t;
 
 class logt_sso {
 public:
+    /// @brief Null stream, swallows everything (used for filtered out levels).
+    logt_sso() : level_(LogLevel::Quiet), active_(false) {}
     logt_sso(LogLevel level, const logt_format& formatter, const logt_channelinfo& channels, const std::string& signature = "");
     ~logt_sso();
-     
-    enable_move_only(logt_sso) // 禁止拷贝，支持移动
+
+    // 禁止拷贝和移动, logt_sig::log() returns a prvalue (guaranteed copy elision)
+    disable_copy_move(logt_sso)
     
     // Serialize support (serialize() member function returning std::string)
     template<typename T>
@@ -177,7 +381,8 @@ public:
         { t.serialize() } -> std::convertible_to<std::string>;  // 返回 std::string
     }
     logt_sso& operator<<(const T& value) {
-        ss_ << value.serialize();
+        if (!active_) return *this;
+        *os_ << value.serialize();
         return *this;
     }
 
@@ -189,40 +394,159 @@ public:
         { t.serialize() } -> std::same_as<std::string>;
     }) && requires(T t, std::stringstream& test_ss) { test_ss << t; }
     logt_sso& operator<<(const T& value) {
-        ss_ << value;
+        if (!active_) return *this;
+        *os_ << value;
         return *this;
     }
 
 #ifdef LOGT_WCHAR_SUPPORT
     logt_sso& operator<<(const std::wstring& value) {
+        if (!active_) return *this;
         // 宽字符串转多字节字符串
         std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-        ss_ << converter.to_bytes(value);
+        *os_ << converter.to_bytes(value);
         return *this;
     }
 #endif
     
 private:
-    std::string default_formatter(const logt_format::formatSettings& settings, const logt_format::formatInfo& info);
-
-private:
-    std::stringstream ss_;
+    std::optional<std::stringstream> ss_; // unused when the record is staged
+    std::ostream* os_ = nullptr;          // ss_ or the thread's staging stream
     LogLevel level_;
     logt_channelinfo channels;
+    bool staged_ = false;
+    bool active_ = true;                  // false for null streams
 };
 
 
+/*
+    Deferred (binary) logging
+
+    LOGT_DEFER only copies the raw argument bytes into the thread's staging chunk;
+    the worker runs std::format later. Every call site owns a static logt_site with
+    the format string, which learns how to decode its arguments on first use. Level and signature belong to each call: the record starts with the sig's
+    name and the worker builds the same prefix logt_sig::log() writes. Only a custom
+    formatFunc still runs on the calling thread.
+
+    Arguments must be trivially copyable or strings. Strings are copied with a
+    length prefix, everything else bytewise, so nothing an argument points to is
+    kept: pointers, spans and other views are rejected, and a struct holding a
+    pointer must not be passed either (the pointee may be gone when it is decoded).
+*/
+class logt_site {
+public:
+    typedef std::string (*decode_func)(std::string_view format, const char* data, size_t size);
+
+    logt_site(std::string_view format, const char* file = "", int line = 0);
+
+    disable_copy_move(logt_site)
+
+    const std::string_view format;
+    const char* const file;
+    const int line;
+
+    std::atomic<decode_func> decode{nullptr};
+};
+
+// the type an argument is recorded as: decayed, and every C string (literals,
+// char arrays, char*) as const char*, so encoding never has to drop a const
+template<typename T>
+using logt_deferred_t = std::conditional_t<std::is_same_v<std::decay_t<T>, char*>, const char*, std::decay_t<T>>;
+
+template<typename T>
+inline constexpr bool logt_is_deferred_string_v =
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> || std::is_same_v<T, const char*>;
+
+// trivially copyable, but only refers to data owned elsewhere
+template<typename T>
+inline constexpr bool logt_is_deferred_view_v = std::is_pointer_v<T> || std::is_member_pointer_v<T>;
+
+template<typename T, size_t N>
+inline constexpr bool logt_is_deferred_view_v<std::span<T, N>> = true;
+
+template<typename C, typename Tr>
+inline constexpr bool logt_is_deferred_view_v<std::basic_string_view<C, Tr>> = true;
+
+template<typename T>
+inline constexpr bool logt_is_deferred_view_v<std::reference_wrapper<T>> = true;
+
+template<typename T>
+concept logt_deferrable = logt_is_deferred_string_v<logt_deferred_t<T>>
+    || (std::is_trivially_copyable_v<logt_deferred_t<T>> && !logt_is_deferred_view_v<logt_deferred_t<T>>);
+
+template<typename T>
+struct logt_deferred_arg {
+    typedef T stored;
+
+    static void encode(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static stored decode(const char*& p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+};
+
+template<typename T>
+requires logt_is_deferred_string_v<T>
+struct logt_deferred_arg<T> {
+    typedef std::string_view stored;
+
+    static void encode(std::string& out, const T& value) {
+        std::string_view str;
+        if constexpr (std::is_pointer_v<T>) {
+            str = value ? std::string_view(value) : std::string_view("(null)"); // never dereference a null C string
+        } else {
+            str = value;
+        }
+        uint32_t size = static_cast<uint32_t>(str.size());
+        out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.append(str.data(), size);
+    }
+
+    static stored decode(const char*& p) {
+        uint32_t size;
+        std::memcpy(&size, p, sizeof(size));
+        std::string_view value(p + sizeof(size), size);
+        p += sizeof(size) + size;
+        return value;
+    }
+};
+
+template<typename... Args>
+std::string logt_decode(std::string_view format, const char* data, size_t size) {
+    (void)size;
+    const char* p = data;
+    // braced initialization decodes the arguments left to right
+    std::tuple<typename logt_deferred_arg<Args>::stored...> values{ logt_deferred_arg<Args>::decode(p)... };
+    return std::apply([&](const auto&... v) {
+        return std::vformat(format, std::make_format_args(v...));
+    }, values);
+}
+
 class logt_sig {
 public:
     logt_sig(const std::string& name);
     
     const std::string& name() const { return name_; }
 
-    logt_sso info()  const { return logt_sso(LogLevel::Info,  formatter, channels, name_); }
-    logt_sso warn()  const { return logt_sso(LogLevel::Warn,  formatter, channels, name_); }
-    logt_sso error() const { return logt_sso(LogLevel::Error, formatter, channels, name_); }
-    logt_sso fatal() const { return logt_sso(LogLevel::Fatal, formatter, channels, name_); }
-    logt_sso debug() const { return logt_sso(LogLevel::Debug, formatter, channels, name_); }
+    /// @brief Message stream at `level`, a null stream if no channel would accept it.
+    /// LogLevel::Inherit logs at the global filter level.
+    inline logt_sso log(LogLevel level) const;
+
+    logt_sso info()  const { return log(LogLevel::Info);  }
+    logt_sso warn()  const { return log(LogLevel::Warn);  }
+    logt_sso error() const { return log(LogLevel::Error); }
+    logt_sso fatal() const { return log(LogLevel::Fatal); }
+    logt_sso debug() const { return log(LogLevel::Debug); }
+
+    /// @brief Write a deferred record for `site` at `level`, see LOGT_DEFER.
+    /// The format string is only used to check the arguments at compile time.
+    template<logt_deferrable... Args>
+    void defer(logt_site& site, LogLevel level, std::format_string<const Args&...> format, const Args&... args) const;
 
     bool setFormatter(logt_format::format_func formatter_);
     bool setChannel(int channelid, bool enable);
@@ -246,6 +570,16 @@ public:
     /// @return An integer identifier for the added log file
     static int addfile(const std::filesystem::path& filename, bool default_enable = true);
 
+    /// @brief Add a high throughput file channel: batched writev(), fsync policy and rotation.
+    /// @param filename The path to the log file (opened in append mode)
+    /// @param options fsync policy, rotation limits and the rotated-file callback
+    /// @param default_enable Whether logging to this file is enabled by default
+    /// @return An integer identifier for the added channel, -1 if no slot is left
+    static int addfilesink(const std::filesystem::path& filename, logt_filesink::options options = {}, bool default_enable = true);
+
+    /// @brief Write counters of a channel added by addfilesink(), all zero for other channels.
+    static logt_filesink::stats channelStats(int channel_id);
+
     /// @brief Add an output stream to the logging system.
     /// @param os The output stream
     /// @param default_enable Whether logging to this stream is enabled by default
@@ -263,14 +597,23 @@ public:
 
     /// @brief Set the global log filter level, by default is `LogLevel::Info`.
     /// @param level The minimum log level to output
-    inline static void setFilterLevel(LogLevel level) { filter_level_ = level; }
+    inline static void setFilterLevel(LogLevel level) { filter_level_.store(level, std::memory_order_relaxed); update_min_level(); }
 
     /// @brief Set per-channel log filter level.
     /// @param channel_id The channel ID (returned by addfile/addostream)
     /// @param level The minimum log level, or LogLevel::Inherit to use global
     inline static void setChannelFilter(int channel_id, LogLevel level) {
-        if (channel_id > 0 && channel_id < LOGT_MAX_CHANNEL)
+        if (channel_id > 0 && channel_id < LOGT_MAX_CHANNEL) {
             channels_[channel_id].filter = level;
+            update_min_level();
+        }
+    }
+
+    /// @brief Whether a message at `level` could pass the filter of any channel.
+    /// A single relaxed load, used to skip filtered out statements early.
+    inline static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= LOGT_MIN_LEVEL
+            && level >= min_level_.load(std::memory_order_relaxed);
     }
 
     // 静态关闭方法
@@ -280,6 +623,27 @@ public:
     /// @brief Shutdown the logging system then close the application.
     static void exit(int exitcode);
 
+    /// @brief Use the lock-free ring buffer instead of the mutex guarded queue.
+    /// Must be called during initialization, before anything is logged.
+    /// @param capacity Number of preallocated message slots (rounded up to a power of two)
+    /// @param policy What to do when the ring is full, see `LogOverflow`
+    /// @return false if logging has already started or capacity is 0
+    inline static bool useRingBuffer(size_t capacity, LogOverflow policy = LogOverflow::Block) {
+        return logt_eventbus::configure_ring(capacity, policy);
+    }
+
+    /// @brief Number of messages discarded by the ring buffer overflow policy.
+    inline static uint64_t droppedMessages() { return logt_eventbus::dropped(); }
+
+    /// @brief Format log records in place into per-thread chunks and hand whole chunks to the worker.
+    /// @param enabled Whether new records go to the staging buffers
+    /// @param chunk_size A chunk is handed off once it holds this many bytes
+    /// @param flush_interval Maximum time a record waits in a chunk before the worker picks it up
+    inline static void useStaging(bool enabled, size_t chunk_size = 64 * 1024,
+                                  std::chrono::milliseconds flush_interval = std::chrono::milliseconds(20)) {
+        logt_staging::configure(enabled, chunk_size, flush_interval);
+    }
+
     /// @brief Install preprocessor function to process log messages.
     /// @param preprocessor A function that takes a logt_message reference and returns a bool.
     static void install_preprocessor(preprocessor_t preprocessor);
@@ -298,6 +662,20 @@ public:
         return super_timestamp_enabled_; 
     }
 
+    /// @brief Take message timestamps from the coarse clock (CLOCK_REALTIME_COARSE on Linux,
+    /// a few milliseconds resolution but much cheaper to read). Other platforms keep system_clock.
+    /// @param enabled Whether to use the coarse clock
+    inline static void enableCoarseTimestamp(bool enabled) {
+        coarse_timestamp_enabled_ = enabled;
+    }
+
+    inline static bool isCoarseTimestampEnabled() {
+        return coarse_timestamp_enabled_;
+    }
+
+    /// @brief Current time as used for message timestamps (honors enableCoarseTimestamp).
+    static std::chrono::system_clock::time_point now();
+
     /// @brief Format a system_clock timestamp.
     /// @param tp a time point from system_clock. You can use something like `std::chrono::system_clock::now()`.
     /// @return The formatted timestamp string.
@@ -313,10 +691,27 @@ private:
     static void worker_thread();
     static void ensure_worker_started();
 
+    static void update_min_level();
+    static bool channel_accepts(const logt_channel& channel, LogLevel level);
+
     static void write_message(const logt_message& message);
+    static void write_chunk(const logt_chunk& chunk, logt_message& scratch);
+    static void flush_sinks();
+
+    /// @brief The level a message is written with: LogLevel::Inherit takes the global filter level.
+    inline static LogLevel effective_level(LogLevel level) {
+        return level == LogLevel::Inherit ? filter_level_.load(std::memory_order_relaxed) : level;
+    }
+
+    static int prefix_flags(const logt_format::formatSettings& settings);
+    static void format_prefix(std::string& out, int flags, LogLevel level, std::string_view signature, std::string_view tag);
+    static const std::string& cached_prefix(const logt_format::formatSettings& settings, LogLevel level,
+                                            const std::string& signature);
+    static std::string thread_tag(std::thread::id thread);
 
     // 静态成员
-    static LogLevel filter_level_;
+    static std::atomic<LogLevel> filter_level_;
+    static std::atomic<LogLevel> min_level_; // lowest level any channel accepts
 
     static logt_channel channels_[LOGT_MAX_CHANNEL];
     static logt_channelinfo channelinfo_;  // track registered channels
@@ -327,10 +722,13 @@ private:
     static std::mutex thread_mutex_;
     static std::unordered_map<std::thread::id, std::string> thread_names_;
     
+    static std::atomic<uint64_t> thread_names_generation_; // bumped by claim(), invalidates cached tags
+
     static std::thread worker_;
     static std::once_flag worker_flag_;
 
     static std::atomic<bool> super_timestamp_enabled_;
+    static std::atomic<bool> coarse_timestamp_enabled_;
 
     static const char* level_labels_[];
 
@@ -338,6 +736,45 @@ private:
 };
 
 
+logt_sso logt_sig::log(LogLevel level) const {
+    level = logt::effective_level(level); // Inherit has no label of its own
+    if (!logt::enabled(level)) return logt_sso();
+    return logt_sso(level, formatter, channels, name_);
+}
+
+template<logt_deferrable... Args>
+void logt_sig::defer(logt_site& site, LogLevel level, std::format_string<const Args&...>, const Args&... args) const {
+    level = logt::effective_level(level);
+    if (!logt::enabled(level)) return;
+
+    logt_site::decode_func decoder = &logt_decode<logt_deferred_t<Args>...>;
+    if (site.decode.load(std::memory_order_relaxed) == nullptr) {
+        site.decode.store(decoder, std::memory_order_relaxed); // same value for every call of a site
+    }
+
+    logt::ensure_worker_started();
+
+    if (std::string* out = logt_staging::begin_binary()) {
+        // the worker builds the prefix from the signature, a custom formatter has to run here
+        int prefix_flags = -1;
+        if (formatter.formatFunc) {
+            *out += formatter.formatFunc(formatter.settings, logt_format::formatInfo{level, name_});
+        } else {
+            *out += name_;
+            prefix_flags = logt::prefix_flags(formatter.settings);
+        }
+        size_t prefix = out->size();
+        (logt_deferred_arg<logt_deferred_t<Args>>::encode(*out, args), ...);
+        logt_staging::end_record(level, channels, &site, prefix, prefix_flags);
+    } else {
+        // nested logging on this thread, format right away
+        std::string raw;
+        (logt_deferred_arg<logt_deferred_t<Args>>::encode(raw, args), ...);
+        logt_sso(level, formatter, channels, name_) << decoder(site.format, raw.data(), raw.size());
+    }
+}
+
+
 class logt_guard {
 public:
     logt_guard() = default;
@@ -384,6 +821,29 @@ public: \
 
 
 
+// 延迟格式化日志：调用线程只拷贝参数的原始字节，由工作线程完成 std::format
+// 使用示例：LOGT_DEFER(logt, LogLevel::Debug, "packet {} size {}", id, size);
+#define LOGT_DEFER(Sig, Level, Format, ...) \
+    do { \
+        const ::LogLevel logt_level_ = (Level); \
+        if (::logt::enabled(logt_level_)) { \
+            static ::logt_site logt_site_(Format, __FILE__, __LINE__); \
+            (Sig).defer(logt_site_, logt_level_, Format __VA_OPT__(,) __VA_ARGS__); \
+        } \
+    } while (0)
+
+// 按级别提前过滤的日志宏：被过滤时右侧的 << 参数不会被求值
+// 使用示例：LOGT_DEBUG(logt) << "state: " << expensive_dump();
+#define LOGT_AT(Sig, Level) \
+    if (!::logt::enabled(Level)) {} else (Sig).log(Level)
+
+#define LOGT_DEBUG(Sig) LOGT_AT(Sig, LogLevel::Debug)
+#define LOGT_INFO(Sig)  LOGT_AT(Sig, LogLevel::Info)
+#define LOGT_WARN(Sig)  LOGT_AT(Sig, LogLevel::Warn)
+#define LOGT_ERROR(Sig) LOGT_AT(Sig, LogLevel::Error)
+#define LOGT_FATAL(Sig) LOGT_AT(Sig, LogLevel::Fatal)
+
+
 // 简化日志输出的宏定义
 // 使用示例：logt.fatal() << LOGT_LINEINFO << " Failed to allocate memory";
 #define LOGT_LINEINFO std::format("{}:{} {}", __FILE__, __LINE__, __FUNCTION__)
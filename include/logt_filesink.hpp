@@ -0,0 +1,110 @@
+/*
+    logt_filesink - high throughput file channel for logt
+
+    The worker appends the lines of a whole batch into a few large blocks and
+    hands them to the kernel with a single writev() per batch, instead of one
+    flushed std::ofstream write per message.
+
+    Also takes care of fsync policy and size/time based rotation. Rotated files
+    are passed to a user callback on a background thread (compression, upload...).
+
+    Use it through `logt::addfilesink()`.
+*/
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+#include "basics.hpp" // for disable_copy_move
+
+class logt_filesink {
+public:
+    enum class FsyncPolicy {
+        never = 0,       // leave it to the OS
+        every_flush = 1, // after every batch written
+        interval = 2,    // at most once per options::fsync_interval
+    };
+
+    struct options {
+        FsyncPolicy fsync = FsyncPolicy::never;
+        std::chrono::milliseconds fsync_interval = std::chrono::milliseconds(1000);
+
+        uint64_t max_bytes = 0;                    // rotate before the file grows past this size, 0 disables
+        std::chrono::seconds max_age = std::chrono::seconds(0); // rotate files older than this, 0 disables
+
+        // Called on a background thread with the path of every rotated file, e.g. to compress it.
+        std::function<void(const std::filesystem::path&)> on_rotate;
+    };
+
+    struct stats {
+        uint64_t messages = 0;  // lines written
+        uint64_t bytes = 0;     // bytes written
+        uint64_t writes = 0;    // write system calls
+        uint64_t fsyncs = 0;
+        uint64_t rotations = 0;
+        uint64_t errors = 0;    // failed writes/opens/renames
+    };
+
+    logt_filesink(const std::filesystem::path& path, options opt);
+    ~logt_filesink();
+
+    disable_copy_move(logt_filesink)
+
+    bool is_open() const { return fd_ >= 0; }
+    const std::filesystem::path& path() const { return path_; }
+
+    /// @brief Queue one line (`prefix` + `content` + newline). Both are copied.
+    void append(std::string_view prefix, std::string_view content);
+
+    /// @brief Write everything queued with a single writev() (split only past IOV_MAX).
+    void flush();
+
+    /// @brief Flush, close the file and wait for pending rotation callbacks.
+    void close();
+
+    stats statistics() const;
+
+private:
+    bool open();
+    void rotate();
+    void sync(bool force);
+    void hand_off(std::filesystem::path rotated);
+    void background_thread();
+
+    static constexpr size_t block_size = 64 * 1024;
+
+    std::filesystem::path path_;
+    options opt_;
+    int fd_ = -1;
+
+    uint64_t file_size_ = 0;
+    uint64_t pending_size_ = 0;
+    std::chrono::system_clock::time_point opened_at_;
+    std::chrono::steady_clock::time_point last_sync_;
+
+    std::vector<std::string> blocks_; // keep their capacity between batches
+    size_t used_blocks_ = 0;
+
+    std::atomic<uint64_t> messages_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> writes_{0};
+    std::atomic<uint64_t> fsyncs_{0};
+    std::atomic<uint64_t> rotations_{0};
+    std::atomic<uint64_t> errors_{0};
+
+    // rotation hand-off
+    std::thread background_;
+    std::mutex bg_mutex_;
+    std::condition_variable bg_cond_;
+    std::deque<std::filesystem::path> rotated_;
+    bool bg_stop_ = false;
+};
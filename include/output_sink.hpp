@@ -0,0 +1,66 @@
+/*
+    Output sinks for SharedCppLib2
+
+    Destinations for the streaming serializers (json_exporter::exportTo(),
+    xml::writer). They hand over their output in chunks of about 64 KiB, so a
+    document never has to exist as a whole in memory; a single long value may
+    come in one larger piece.
+
+    For other destinations, derive from output_sink and implement write()
+    and optionally flush().
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx17 - cxx23
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+namespace scl2 {
+
+class output_sink {
+public:
+    virtual ~output_sink() = default;
+
+    /// @brief Consume `size` bytes. Throw to abort the output.
+    virtual void write(const char* data, size_t size) = 0;
+
+    /// @brief Called once the producer is done, or asked to flush.
+    virtual void flush() {}
+};
+
+class string_sink : public output_sink {
+public:
+    explicit string_sink(std::string& out) : out(out) {}
+    void write(const char* data, size_t size) override { out.append(data, size); }
+
+private:
+    std::string& out;
+};
+
+// Throws std::runtime_error once the stream fails.
+class ostream_sink : public output_sink {
+public:
+    explicit ostream_sink(std::ostream& os) : os(os) {}
+    void write(const char* data, size_t size) override;
+    void flush() override;
+
+private:
+    std::ostream& os;
+};
+
+// Writes to a file descriptor (a socket, a pipe...), retrying partial writes. Does not close it.
+class fd_sink : public output_sink {
+public:
+    explicit fd_sink(int fd) : fd(fd) {}
+    void write(const char* data, size_t size) override;
+
+private:
+    int fd;
+};
+
+} // namespace scl2
@@ -0,0 +1,263 @@
+/*
+    Event-driven TCP server module as part of the network library.
+
+    tcp::server polls: every tick() tries one accept(), and reading a client
+    means asking select() about that single socket, so one pass over N
+    clients costs N system calls even when nothing happens. event_server
+    waits for readiness instead, with epoll in edge-triggered mode on
+    non-blocking sockets:
+
+    - one epoll_wait() returns up to options::max_events ready sockets,
+    - a readable listening socket is accepted from until EAGAIN, at most
+      options::accept_batch connections per turn,
+    - a readable connection is read until EAGAIN into one buffer shared by
+      all connections, and every chunk goes to the data callback right away,
+    - send() writes directly and only queues what the socket did not take.
+      The rest goes out when epoll reports the socket writable again.
+
+    A connection that has nothing to send holds no buffer: its socket, its
+    epoll registration and a small connection object, so tens of thousands
+    of idle keep-alive connections are cheap. With options::idle_timeout
+    set, connections idle for longer are closed, they are kept in a list
+    ordered by last activity so only expired ones are looked at.
+
+    Callbacks run on the thread calling poll() or run(), and so do all
+    connection functions. post() runs a function on that thread from any
+    other thread. stop() may be called from a callback, and from another
+    thread while run() is active.
+
+    One event_server is one event loop on one thread. tcp::multi_server
+    (tcpmultiserver.hpp) runs several of them, each listening on the same
+    port with options::reuse_port or taking sockets accepted elsewhere
+    through adopt().
+
+    Linux only, this header declares nothing on other platforms.
+*/
+
+#pragma once
+
+#include "network.hpp"
+#include "tcp.hpp"
+
+#if defined(__linux__)
+
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+
+namespace network::tcp {
+
+typedef int client_id;
+
+class event_server;
+
+// One accepted connection, owned by its event_server.
+// References stay valid until the close callback has returned.
+class connection
+{
+public:
+    connection(const connection&) = delete;
+    connection& operator=(const connection&) = delete;
+
+    client_id id() const { return m_id; }
+    socket_t socket() const { return m_socket; }
+    const sockaddr_in& peer() const { return m_addr; }
+    network_address address() const; // peer address
+    event_server& server() const { return m_server; } // the event loop this connection belongs to
+
+    /// @brief Send now as far as the socket takes it, queue the rest.
+    /// @return false if the connection is closed or failed
+    bool send(const char* data, size_t size);
+    bool send(std::string_view data) { return send(data.data(), data.size()); }
+    bool send(const scl2::bytearray& data) { return send(reinterpret_cast<const char*>(data.data()), data.size()); }
+
+    size_t pending() const { return m_output.size() - m_output_pos; } // queued bytes, not sent yet
+
+    void close(); // once the queued output is sent
+    void abort(); // now, dropping queued output
+    bool closing() const { return m_close_after_write || m_closed; }
+
+    // free for the application, e.g. the protocol state of this connection
+    std::any& context() { return m_context; }
+
+private:
+    friend class event_server;
+
+    connection(event_server& srv, socket_t socket, client_id id, const sockaddr_in& addr);
+
+    bool flush(); // write queued output, false on error
+
+    event_server& m_server;
+    socket_t m_socket;
+    client_id m_id;
+    sockaddr_in m_addr;
+
+    std::string m_output;    // queued output, from m_output_pos on
+    size_t m_output_pos = 0;
+    bool m_close_after_write = false;
+    bool m_closed = false;   // socket closed, waiting to be freed
+    bool m_reading = false;  // in the read-ready list
+
+    // idle list, least recently active first
+    std::chrono::steady_clock::time_point m_last_active;
+    connection* m_idle_prev = nullptr;
+    connection* m_idle_next = nullptr;
+
+    std::any m_context;
+};
+
+class event_server
+{
+public:
+    struct options {
+        int backlog = SOMAXCONN;
+        int max_events = 256;      // ready sockets taken per epoll_wait()
+        int accept_batch = 64;     // connections accepted per turn before others get a chance
+        size_t read_size = 64 * 1024;   // size of the shared read buffer
+        size_t read_budget = 1 << 20;   // bytes read from one connection per turn
+        bool no_delay = true;      // TCP_NODELAY on accepted sockets
+        std::chrono::milliseconds idle_timeout{0}; // close connections idle this long, 0: never
+        bool reuse_port = false;   // SO_REUSEPORT: several servers listen on one port, the kernel spreads connections
+    };
+
+    // Counters of one event loop. Only that loop writes them, stats() may be read from any thread.
+    struct statistics {
+        uint64_t accepted = 0;      // sockets accepted from the listening socket
+        uint64_t opened = 0;        // connections served, accepted here or adopt()ed
+        uint64_t closed = 0;
+        uint64_t bytes_read = 0;
+        uint64_t bytes_written = 0;
+        uint64_t wakeups = 0;       // epoll_wait() calls
+        uint64_t events = 0;        // readiness events handled
+
+        uint64_t connections() const { return opened - closed; }
+    };
+
+    using connect_handler = std::function<void(connection&)>;
+    using data_handler = std::function<void(connection&, std::string_view)>;
+    using close_handler = std::function<void(connection&)>;
+    using drain_handler = std::function<void(connection&)>;
+    using accept_handler = std::function<bool(socket_t, const sockaddr_in&)>;
+
+    event_server();
+    event_server(uint16_t port);
+    event_server(network_address address, uint16_t port);
+    ~event_server(); // stop()s, run() must have returned
+
+    event_server(const event_server&) = delete;
+    event_server& operator=(const event_server&) = delete;
+
+    options& config() { return m_options; } // change before start()
+
+    void onConnect(connect_handler handler) { m_on_connect = std::move(handler); }
+    void onData(data_handler handler) { m_on_data = std::move(handler); } // the view is valid during the call only
+    void onClose(close_handler handler) { m_on_close = std::move(handler); }
+    void onDrain(drain_handler handler) { m_on_drain = std::move(handler); } // queued output has been sent
+    // Sees every accepted socket first. Returning true takes it over, e.g. to adopt() it elsewhere.
+    void onAccept(accept_handler handler) { m_on_accept = std::move(handler); }
+
+    /// @brief Bind and listen. Port 0 picks a free port, see port().
+    void start();
+    void start(uint16_t port);
+
+    /// @brief Start without a listening socket, connections only come from adopt().
+    void open();
+
+    /// @brief Serve an accepted, non-blocking socket. Event loop thread only.
+    /// @return The new connection, nullptr if it could not be registered (the socket is closed then)
+    connection* adopt(socket_t socket, const sockaddr_in& addr);
+
+    /// @brief Makes run() return. Inside poll() the turn is finished first, otherwise closes everything now.
+    /// Thread safe while run() is active.
+    void stop();
+
+    /// @brief Wait up to `timeout_ms` (-1: no limit) for events and handle them.
+    /// @return Number of events handled, or -1 if not running
+    int poll(int timeout_ms = -1);
+
+    /// @brief poll() until stop(), then close every connection and the listening socket.
+    void run();
+
+    /// @brief Thread safe. Run `fn` on the event loop thread.
+    void post(std::function<void()> fn);
+
+    bool running() const { return m_running; }
+    uint16_t port() const;
+    network_address address() const;
+
+    size_t connections() const { return m_connections.size(); }
+    connection* find(client_id id); // nullptr if not connected
+
+    statistics stats() const; // thread safe
+
+private:
+    friend class connection;
+
+    void openLoop();
+    void acceptBatch();
+    void readBatch(connection& c);
+    void writable(connection& c);
+    void closeConnection(connection& c);
+    void touch(connection& c);  // move to the end of the idle list
+    void unlink(connection& c); // remove from the idle list
+    void expireIdle();
+    int turn(int timeout_ms); // one poll(), see there
+    int waitTimeout(int timeout_ms) const;
+    void runPosted();
+    void closeAll();
+
+    network_address m_address;
+    uint16_t m_port;
+    options m_options;
+
+    socket_t m_listen_socket = invalid_socket;
+    int m_epoll = -1;
+    int m_wake = -1; // eventfd for post() and stop()
+    bool m_running = false;
+    std::atomic<bool> m_in_run = false;
+    std::atomic<bool> m_in_poll = false;
+    std::atomic<bool> m_stop_requested = false;
+
+    std::unordered_map<client_id, std::unique_ptr<connection>> m_connections;
+    client_id m_next_client_id = 1;
+
+    std::vector<epoll_event> m_events;
+    std::vector<char> m_read_buffer;            // shared by all connections
+    bool m_accept_pending = false;              // accept_batch was used up
+    std::vector<connection*> m_read_pending;    // read_budget was used up
+    std::vector<std::unique_ptr<connection>> m_closed; // freed after the current turn
+
+    connection* m_idle_head = nullptr;
+    connection* m_idle_tail = nullptr;
+
+    std::mutex m_post_mutex;
+    std::vector<std::function<void()>> m_posted;
+
+    // statistics, written by the loop thread only
+    struct counters {
+        std::atomic<uint64_t> accepted{0}, opened{0}, closed{0};
+        std::atomic<uint64_t> bytes_read{0}, bytes_written{0};
+        std::atomic<uint64_t> wakeups{0}, events{0};
+    };
+    counters m_stats;
+
+    connect_handler m_on_connect;
+    data_handler m_on_data;
+    close_handler m_on_close;
+    drain_handler m_on_drain;
+    accept_handler m_on_accept;
+};
+
+} // namespace network::tcp
+
+#endif // __linux__
@@ -0,0 +1,122 @@
+/*
+    Multi-reactor TCP server module as part of the network library.
+
+    A tcp::event_server is one event loop on one thread. multi_server runs
+    several of them ("reactors"), each on its own thread with its own epoll
+    set and its own connection table. A connection stays on the reactor
+    that got it for its whole life, so reactors share nothing and take no
+    locks while serving.
+
+    Connections are spread over the reactors in one of two ways:
+
+    - distribution::reuse_port (default): every reactor has its own
+      listening socket on the same port (SO_REUSEPORT), the kernel hashes
+      incoming connections onto them. Accepting scales with the reactors.
+    - distribution::handoff: reactor 0 alone listens and hands the accepted
+      sockets round robin to all reactors, through their post() queue. An
+      even spread whatever the peers are, for one wakeup per connection.
+
+    The callbacks are shared by all reactors and run concurrently on their
+    threads. What lives in connection::context() needs no locks, anything
+    shared between connections does. connection::server() is the reactor.
+
+    With options::pin, reactor i runs on CPU options::cpus[i % size], by
+    default the CPUs the process may use (sched_getaffinity()), so a loop
+    and the data of its connections stay on one core.
+
+    Linux only, this header declares nothing on other platforms.
+*/
+
+#pragma once
+
+#include "tcpeventserver.hpp"
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace network::tcp {
+
+class multi_server
+{
+public:
+    enum class distribution { reuse_port, handoff };
+
+    struct options {
+        size_t threads = 0;        // reactors, 0: one per CPU the process may use
+        distribution mode = distribution::reuse_port;
+        bool pin = false;          // pin each reactor thread to one CPU
+        std::vector<int> cpus;     // CPUs to pin to in reactor order, empty: the allowed ones
+        event_server::options reactor; // for every reactor, reuse_port follows `mode`
+    };
+
+    multi_server();
+    multi_server(uint16_t port);
+    multi_server(network_address address, uint16_t port);
+    ~multi_server(); // stop() and wait()
+
+    multi_server(const multi_server&) = delete;
+    multi_server& operator=(const multi_server&) = delete;
+
+    options& config() { return m_options; } // change before start()
+
+    // called on the reactor threads, see the top of this file
+    void onConnect(event_server::connect_handler handler) { m_on_connect = std::move(handler); }
+    void onData(event_server::data_handler handler) { m_on_data = std::move(handler); }
+    void onClose(event_server::close_handler handler) { m_on_close = std::move(handler); }
+    void onDrain(event_server::drain_handler handler) { m_on_drain = std::move(handler); }
+
+    /// @brief Create the reactors, bind and start their threads. Port 0 picks a free port, see port().
+    void start();
+    void start(uint16_t port);
+
+    /// @brief Thread safe, also from a callback. Makes every reactor close its connections and return.
+    /// A stop() while start() is still setting up is kept and applied as soon as
+    /// the reactor threads are spawned, so start() then returns with them already
+    /// stopping. A stop() while nothing is started or starting does nothing.
+    void stop();
+
+    /// @brief Wait until the reactor threads have returned. Not from a callback.
+    void wait();
+
+    bool running() const { return m_running; }
+    uint16_t port() const { return m_port; }
+    network_address address() const;
+
+    size_t reactors() const { return m_reactors.size(); }
+    event_server& reactor(size_t index) { return *m_reactors[index]; }
+
+    /// @brief Thread safe. Counters of each reactor, in reactor order.
+    std::vector<event_server::statistics> stats() const;
+    event_server::statistics total() const; // summed over all reactors
+
+private:
+    static std::vector<int> allowedCpus();
+    void spawn(size_t index, int cpu);
+    void stopReactors(); // with m_state_mutex held
+
+    network_address m_address;
+    uint16_t m_port;
+    options m_options;
+
+    std::vector<std::unique_ptr<event_server>> m_reactors;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_running = false;
+    std::mutex m_state_mutex; // orders start() against stop() from other threads
+    bool m_starting = false;
+    bool m_stop_pending = false; // stop() arrived while m_starting
+    size_t m_next_reactor = 0; // handoff target, used by reactor 0 only
+
+    event_server::connect_handler m_on_connect;
+    event_server::data_handler m_on_data;
+    event_server::close_handler m_on_close;
+    event_server::drain_handler m_on_drain;
+};
+
+} // namespace network::tcp
+
+#endif // __linux__
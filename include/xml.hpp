@@ -28,7 +28,7 @@
     - DTD parsing/validation
 
     [SCL_STANDALONE_MODULE]
-    version: 0.2.1
+    version: 0.3.4
     cpp_generation: cxx23
 */
 #pragma once
@@ -111,10 +111,19 @@ class parser_error : public std::runtime_error {
 public: explicit parser_error(const std::string& message) : std::runtime_error("XML Parser Error: " + message) {}
 };
 
+class parser;
+class compact_document;
+class query;
+class writer;
+
 // xml single node
 class node
 {
     friend class document;
+    friend class parser;
+    friend class compact_document;
+    friend class query;
+    friend class writer;
 public:
     /// @brief Node type discriminator.
     enum class Type : uint8_t { Element, Text, Comment, ProcessingInstruction };
@@ -251,7 +260,10 @@ protected:
 // xml document
 class document
 {
-
+    friend class parser;
+    friend class compact_document;
+    friend class query;
+    friend class writer;
 public:
     document() = default;
     ~document() = default;
@@ -262,6 +274,7 @@ public:
     document& operator=(document&&) = default;
 
     node& getRootNode();
+    const node& getRootNode() const;
     void setRootNode(const node& root); // Warn: replaces the entire document if root node is changed
 
     std::optional<std::string> getXmlDeclaration() const;
@@ -271,7 +284,9 @@ public:
     void setDoctypeDeclaration(const std::string& doctype);
 
     // XML parsing and serialization
-    void deserialize(const std::string& xml_text);
+    // Parsing is a single pass over `xml_text`, see parser in xml.cpp.
+    // serialize() goes through xml::writer (xml_writer.hpp), which can also stream into a sink.
+    void deserialize(std::string_view xml_text);
     std::string serialize() const;
 
     // Make some of the functions using the same name as node,
@@ -304,6 +319,8 @@ std::ostream& operator<<(std::ostream& os, const document& doc);
 std::string makeTab(int depth);
 std::string trimString(const std::string& str);
 std::string escapeTextContent(const std::string& text);
+void escapeTextContent(std::string& out, std::string_view text); // appended to `out`
 std::string unescapeTextContent(const std::string& text);
+void unescapeTextContent(std::string& out, std::string_view text); // into `out`, reusing its buffer
 
 } // namespace xml
\ No newline at end of file
@@ -0,0 +1,156 @@
+/*
+    Compact XML documents for SharedCppLib2
+
+    A read-only alternative to xml::document for large inputs such as SOAP
+    envelopes and XBRL filings. xml::node owns a std::map of attributes, a
+    vector of children and a copy of every namespace declaration in scope,
+    so a parsed document takes around ten times its text size or more.
+    compact_document instead:
+
+    - keeps all nodes in one array, linked by index (parent, first child,
+      next sibling),
+    - interns qualified names, prefixes and namespace URIs once per document,
+    - stores the attributes of an element as a small flat range of one
+      shared array,
+    - records namespace declarations as scopes linked to their parent scope,
+      an element only refers to the innermost one,
+    - keeps all decoded text and attribute values in one character buffer.
+
+    It is built with xml::reader, so its namespace and whitespace rules are
+    the reader's: unprefixed elements are in the default namespace, and text
+    is trimmed unless xml:space="preserve" applies. Every text run between
+    two tags is a text node. toDocument() converts into an xml::document when
+    you need to edit.
+
+    Offsets are 32 bits wide, a document holds up to 4 GiB of decoded text.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx23
+    standalone_dependency: xml
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <generator>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xml.hpp"
+
+namespace xml
+{
+
+class reader;
+class compact_document;
+struct compact_storage; // defined in xml_compact.cpp
+
+struct compact_attribute {
+    std::string_view name;          // qualified name as written
+    std::string_view namespace_uri; // "" if none
+    std::string_view value;         // references decoded
+};
+
+// Handle to a node of a compact_document. Cheap to copy, valid as long as
+// the document, also across moves of the document.
+class compact_node
+{
+public:
+    compact_node() = default; // null handle
+
+    bool isNull() const { return store_ == nullptr; }
+    explicit operator bool() const { return store_ != nullptr; }
+    bool operator==(const compact_node& other) const = default;
+
+    node::Type type() const;
+    bool is_element() const { return type() == node::Type::Element; }
+    bool is_text() const { return type() == node::Type::Text; }
+    bool is_comment() const { return type() == node::Type::Comment; }
+    bool is_processing_instruction() const { return type() == node::Type::ProcessingInstruction; }
+    bool is_cdata() const; // a text node that was a CDATA section
+
+    std::string_view qualifiedName() const; // "soap:Body"
+    std::string_view localName() const;     // "Body"
+    std::string_view prefix() const;        // "soap", "" if none
+    std::string_view namespaceUri() const;  // "" if none
+
+    bool hasAttribute(std::string_view qname) const;
+    std::string_view getAttribute(std::string_view qname, std::string_view default_value = {}) const;
+    size_t attributeCount() const;
+    std::generator<compact_attribute> attributes() const;
+
+    /// @brief Namespace bound to `prefix` here, "" for the default namespace. Empty if not bound.
+    std::string_view lookupNamespace(std::string_view prefix) const;
+    std::vector<xnamespace> getDeclaredNamespaces() const; // declared by this element
+
+    /// @brief Text of a text or comment node. For an element, its text and CDATA children joined.
+    std::string getTextContent() const;
+    std::string_view text() const; // text, comment, processing instruction data; empty for elements
+
+    std::string_view pi_target() const { return is_processing_instruction() ? qualifiedName() : std::string_view(); }
+    std::string_view pi_data() const { return is_processing_instruction() ? text() : std::string_view(); }
+
+    compact_node parent() const;
+    compact_node firstChild() const;
+    compact_node nextSibling() const;
+    bool isSelfClosing() const;
+
+    bool hasChildren() const { return !firstChild().isNull(); }
+    std::generator<compact_node> childNodes() const;
+    std::generator<compact_node> elements() const; // element children only
+    compact_node firstElement(std::string_view qname) const; // null handle if there is none
+
+    /// @brief Deep copy into the classic model. Text runs become text_content (the last
+    /// one, as xml::document keeps it), CDATA sections text nodes.
+    node toNode() const;
+
+private:
+    friend class compact_document;
+    compact_node(const compact_storage* store, uint32_t index) : store_(store), index_(index) {}
+
+    const compact_storage* store_ = nullptr;
+    uint32_t index_ = 0;
+};
+
+class compact_document
+{
+public:
+    compact_document();
+    ~compact_document();
+    compact_document(compact_document&&) noexcept;
+    compact_document& operator=(compact_document&&) noexcept;
+    compact_document(const compact_document&) = delete;
+    compact_document& operator=(const compact_document&) = delete;
+
+    /// @brief Parse `xml_text`. Nothing refers to it afterwards. Throws parsing_error.
+    static compact_document parse(std::string_view xml_text);
+    /// @brief Parse from a stream read in chunks, the text is never held as a whole.
+    static compact_document fromStream(std::istream& input);
+
+    compact_node getRootNode() const;
+
+    std::optional<std::string> getXmlDeclaration() const;
+    std::optional<std::string> getDoctypeDeclaration() const;
+
+    /// @brief Deep copy into the classic model, for editing.
+    document toDocument() const;
+
+    size_t nodeCount() const;
+    size_t memoryUsage() const; // bytes held by the document
+
+private:
+    friend class compact_node;
+
+    static compact_document build(reader& r);
+    static node toNode(const compact_storage& s, uint32_t index, const std::optional<std::vector<xnamespace>>& inherited);
+    static std::vector<xnamespace> declaredNamespaces(const compact_storage& s, uint32_t index); // like node::decl_xmlns
+
+    std::unique_ptr<compact_storage> store_;
+};
+
+} // namespace xml
@@ -0,0 +1,162 @@
+/*
+    XML Path Queries for SharedCppLib2
+
+    Finds elements of an xml::document with a subset of XPath 1.0 location
+    paths instead of walking getChildNodes() by hand:
+
+        /catalog/book               children, from the root element
+        //book                      descendants at any depth
+        /catalog//title             descendants of a match
+        *, soap:*                   any element name, any in a prefix
+        soap:Body                   qualified names compare as written
+        .//price, .                 the context node
+        //book[@id]                 attribute present
+        //book[@id='bk101']         attribute equal (or !=)
+        //book[price='5.95']        child element with that text
+        //book[text()='x']          own text
+        //a[contains(@href,'x')]    also starts-with(), on @attr or text()
+        //book[not(@lang)]          negation of any of the above
+        //book[2], //book[last()]   position among the siblings matched
+        //book[@lang='en'][1]       predicates apply left to right
+
+    Name tests compare the qualified name as written ("prefix:local"), prefix
+    bindings are not resolved. Attributes and text are not selectable, the
+    result is always a list of elements in document order.
+
+    xpath is the compiled expression. xpath::select() walks the tree on
+    every call. A query is bound to one document and builds indexes on first
+    use: document order, element name to elements and id (or xml:id) to
+    element. Repeated queries then look up descendants instead of walking,
+    `//name` costs a binary search plus the size of the result. The indexes
+    hold pointers into the tree, call invalidate() after editing it.
+
+    A query is not safe to use from several threads at once, indexes are
+    built lazily from const member functions.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx23
+    standalone_dependency: xml
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xml.hpp"
+
+namespace xml
+{
+
+class query;
+struct query_index; // defined in xml_query.cpp
+
+// A compiled path expression, see the top of this file for the syntax.
+class xpath
+{
+public:
+    enum class axis : uint8_t { child, descendant, self, descendant_or_self };
+
+    struct predicate {
+        enum class kind : uint8_t {
+            position,    // [n]
+            last,        // [last()]
+            attribute,   // [@name], [@name='v'], [@name!='v']
+            child,       // [name], [name='v'], [name!='v']
+            text,        // [text()='v'], [text()!='v']
+            contains,    // [contains(@name|text(),'v')]
+            starts_with, // [starts-with(@name|text(),'v')]
+        };
+        enum class compare : uint8_t { exists, equal, not_equal };
+
+        kind type = kind::position;
+        compare op = compare::exists;
+        bool negate = false;  // inside not()
+        bool on_text = false; // contains/starts-with on text() instead of an attribute
+        size_t position = 0;
+        qualified_name name;  // attribute or child element
+        std::string value;
+    };
+
+    struct step {
+        axis direction = axis::child;
+        std::string prefix; // "" if none
+        std::string local;  // "*" matches any name
+        std::vector<predicate> predicates;
+    };
+
+    /// @brief Compile `expression`. Throws parsing_error on a syntax error.
+    explicit xpath(std::string_view expression);
+
+    const std::string& expression() const { return expression_; }
+    bool isAbsolute() const { return absolute_; }
+    const std::vector<step>& steps() const { return steps_; }
+
+    /// @brief Evaluate against the tree of `root`, walking it (no index).
+    /// Relative paths start at `root`, absolute ones at its document node.
+    std::vector<const node*> select(const node& root) const;
+    std::vector<const node*> select(const document& doc) const;
+
+    const node* selectFirst(const node& root) const; // nullptr if nothing matches
+    const node* selectFirst(const document& doc) const;
+
+private:
+    std::string expression_;
+    bool absolute_ = false;
+    std::vector<step> steps_;
+};
+
+// Queries against one document, with indexes built on first use.
+// The document must outlive the query.
+class query
+{
+public:
+    /// @param indexed Build indexes on first use. Without them every query walks the tree.
+    explicit query(const document& doc, bool indexed = true);
+    explicit query(const node& root, bool indexed = true);
+    /// @brief Several trees queried together, as children of one document node.
+    /// html::document queries its <head> and <body> this way.
+    explicit query(std::vector<const node*> roots, bool indexed = true);
+
+    ~query();
+    query(query&&) noexcept;
+    query& operator=(query&&) noexcept;
+    query(const query&) = delete;
+    query& operator=(const query&) = delete;
+
+    std::vector<const node*> select(const xpath& path) const;
+    std::vector<const node*> select(std::string_view path) const { return select(xpath(path)); }
+
+    /// @brief Evaluate a relative path from `context`, an element of the queried tree.
+    /// Throws parser_error if `context` is not part of it.
+    std::vector<const node*> select(const xpath& path, const node& context) const;
+    std::vector<const node*> select(std::string_view path, const node& context) const { return select(xpath(path), context); }
+
+    const node* selectFirst(const xpath& path) const; // nullptr if nothing matches
+    const node* selectFirst(std::string_view path) const { return selectFirst(xpath(path)); }
+
+    /// @brief First element in document order whose id or xml:id attribute is `id`.
+    const node* getElementById(std::string_view id) const;
+    /// @brief Elements with qualified name `qname` ("*" for all), in document order.
+    std::vector<const node*> getElementsByName(std::string_view qname) const;
+
+    bool isIndexed() const { return indexed_; }
+    /// @brief Drop the indexes. Required after editing the tree, they are rebuilt on next use.
+    void invalidate();
+
+private:
+    struct evaluator; // defined in xml_query.cpp
+
+    const query_index& index() const;   // document order and element names
+    const query_index& idIndex() const; // index() plus ids
+
+    std::vector<const node*> roots_;
+    bool indexed_ = true;
+    mutable std::unique_ptr<query_index> index_;
+};
+
+} // namespace xml
@@ -0,0 +1,197 @@
+/*
+    XML Reader for SharedCppLib2
+
+    Incremental, event based (pull) XML parsing for documents too large to
+    hold as an xml::document. Input comes from feed() in chunks of any size,
+    from an std::istream read on demand, or from a complete buffer such as a
+    memory-mapped file, which is read in place without being copied.
+
+    Events are produced as soon as the markup they describe is complete. Only
+    the unconsumed tail of the input is buffered, so memory stays bounded by
+    the chunk size plus the largest single tag or text run and the nesting
+    depth, whatever the size of the document.
+
+    Entity and character references are decoded and namespace prefixes are
+    resolved while reading: an element or attribute carries the xnamespace
+    it is bound to. Unlike xml::document, unprefixed element names take the
+    default namespace (xmlns="...") in scope, as the Namespaces
+    recommendation says. The xml declaration and DOCTYPE are kept, not
+    reported as events.
+
+    Text is trimmed and whitespace only text is dropped unless
+    xml:space="preserve" is in effect, like in the tree built by
+    xml::document.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx23
+    standalone_dependency: xml
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "xml.hpp"
+
+namespace xml
+{
+
+enum class event : uint8_t {
+    need_input = 0,             // everything fed so far is consumed, feed() more or finish()
+    start_element = 1,          // name(), xmlns(), attributes() and declarations() describe the element
+    end_element = 2,            // name() and xmlns() of the element that ends, also sent for <empty/>
+    text = 3,                   // text() with references decoded
+    cdata = 4,                  // text() holds the content of a CDATA section
+    comment = 5,                // text() holds the comment
+    processing_instruction = 6, // target() and text() (the data)
+    end_of_input = 7,           // the input is complete
+};
+
+struct attribute {
+    qualified_name name;
+    std::string value; // references decoded
+    const xnamespace* xmlns = nullptr; // namespace of a prefixed name (nullptr if undeclared), valid until the element ends
+};
+
+class event_handler {
+public:
+    virtual ~event_handler() = default;
+
+    virtual void on_start_element(const qualified_name& name, const xnamespace* xmlns, const std::vector<attribute>& attributes) { (void)name; (void)xmlns; (void)attributes; }
+    virtual void on_end_element(const qualified_name& name, const xnamespace* xmlns) { (void)name; (void)xmlns; }
+    virtual void on_text(const std::string& text, bool cdata) { (void)text; (void)cdata; }
+    virtual void on_comment(const std::string& text) { (void)text; }
+    virtual void on_processing_instruction(const std::string& target, const std::string& data) { (void)target; (void)data; }
+};
+
+class reader
+{
+public:
+    reader() = default;
+
+    /// @brief Read from `input` on demand, `chunk_size` bytes at a time. next() never returns need_input.
+    explicit reader(std::istream& input, size_t chunk_size = 64 * 1024);
+
+    /// @brief Read a complete document in place (e.g. a memory-mapped file). `input` is not copied and must outlive the reader.
+    explicit reader(std::string_view input);
+
+    /// @brief Append a chunk of input. Chunks may split markup anywhere.
+    void feed(std::string_view chunk);
+
+    /// @brief Mark the end of the input.
+    void finish();
+
+    /// @brief Next event, need_input when the buffered input runs out. Throws parsing_error on malformed input.
+    event next();
+
+    /// @brief Pull every available event into `handler`. Returns false once the input is complete.
+    bool dispatch(event_handler& handler);
+
+    /// @brief Right after start_element: drop everything inside the element.
+    /// The next event returned is its end_element.
+    void skip();
+
+    // name() and xmlns() belong to start_element and end_element, they are reset after an end_element
+    const qualified_name& name() const { return name_; }
+    const xnamespace* xmlns() const { return xmlns_; } // nullptr if the element has no namespace
+    const std::vector<attribute>& attributes() const { return attributes_; } // xmlns declarations excluded
+    const std::vector<xnamespace>& declarations() const { return declarations_; } // declared by the current start tag
+    const std::string& text() const { return text_; }
+    const std::string& target() const { return target_; }
+    bool isSelfClosing() const { return self_closing_; }
+
+    bool hasAttribute(const qualified_name& key) const;
+    std::string getAttribute(const qualified_name& key, const std::string& default_value = "") const;
+
+    /// @brief Namespace bound to `prefix` at the current position, "" for the default namespace.
+    const xnamespace* lookupNamespace(std::string_view prefix) const;
+
+    std::optional<std::string> getXmlDeclaration() const { return xml_declaration_; }
+    std::optional<std::string> getDoctypeDeclaration() const { return doctype_declaration_; }
+
+    // number of open elements, the one of a start_element/end_element event included
+    size_t depth() const { return stack_.size(); }
+
+    // qualified names of the open elements, "/feed/entry/title" ("" outside the root)
+    std::string path() const;
+
+    size_t position() const { return consumed_ + pos_; } // bytes consumed so far
+    size_t buffered() const { return input().size() - pos_; }
+
+    void reset();
+
+private:
+    struct open_element {
+        std::string qname; // as written, for the end tag
+        qualified_name name;
+        const xnamespace* xmlns;
+        size_t bindings;   // bindings_.size() before the element's declarations
+        bool preserve;     // xml:space="preserve" in effect
+    };
+
+    std::string_view input() const { return in_place_ ? external_ : std::string_view(buffer_); }
+
+    event nextEvent();
+    // nullopt: a token without an event (xml declaration, DOCTYPE, ignorable whitespace)
+    std::optional<event> markup(std::string_view in);
+    std::optional<event> textRun(std::string_view in);
+    std::optional<event> incomplete(const char* what) const; // need_input, or throws once finished
+    event startTag(std::string_view tag);
+    event endTag(std::string_view tag);
+    event endOfInput() const;
+    void closeElement();
+
+    // end of the construct at pos_ closed by `close`, npos if it is not complete yet
+    size_t findClose(std::string_view in, std::string_view close, size_t skip);
+    size_t findTagEnd(std::string_view in);     // quote aware '>'
+    size_t findDoctypeEnd(std::string_view in); // quote and bracket aware '>'
+    void consume(size_t end);                   // pos_ = end, drop scan state
+
+    const xnamespace* resolve(std::string_view prefix) const; // throws if not declared
+    bool pull(); // istream mode: read a chunk, false at the end of the stream
+    void compact();
+
+    // ---- input ----
+    std::string buffer_;
+    std::string_view external_;
+    bool in_place_ = false; // reading external_ instead of buffer_
+    std::istream* stream_ = nullptr;
+    size_t chunk_size_ = 64 * 1024;
+    size_t pos_ = 0;      // start of the next token in input()
+    size_t consumed_ = 0; // bytes dropped from the front of buffer_
+    size_t scan_ = 0;     // resume point of an incomplete token, 0 if none
+    char quote_ = 0;      // quote open at scan_ in an incomplete start tag
+    bool finished_ = false;
+
+    // ---- document state ----
+    std::vector<open_element> stack_;
+    std::deque<xnamespace> bindings_; // declarations in scope, innermost last; stable addresses
+    bool close_pending_ = false;      // a self-closing element still owes its end_element
+    bool pop_pending_ = false;        // the element of the last end_element is still on stack_
+    bool root_seen_ = false;
+    size_t skip_depth_ = 0;           // non-zero while skip() is in progress
+    event last_ = event::need_input;
+    std::vector<std::pair<std::string_view, std::string_view>> raw_attributes_; // of the start tag being read
+
+    std::optional<std::string> xml_declaration_;
+    std::optional<std::string> doctype_declaration_;
+
+    // ---- current event ----
+    qualified_name name_;
+    const xnamespace* xmlns_ = nullptr;
+    std::vector<attribute> attributes_;
+    std::vector<xnamespace> declarations_;
+    std::string text_;
+    std::string target_;
+    bool self_closing_ = false;
+};
+
+} // namespace xml
@@ -0,0 +1,80 @@
+/*
+    XML Writer for SharedCppLib2
+
+    Serializes nodes and documents straight into an output sink, in one pass
+    over the tree. node::serialize() used to return the text of every child
+    and append it to its parent, so each level copied its whole subtree
+    again. The writer appends everything to one buffer instead, and hands it
+    to the sink whenever it grows past writer::chunk_size at a node boundary.
+    The buffer is kept for the next write.
+
+    The output is exactly the one of node::serialize() and
+    document::serialize(), which are now implemented with a writer into a
+    string. Text is escaped with escapeTextContent(std::string&, ...), which
+    finds the characters to replace 16 or 32 bytes at a time.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.1
+    cpp_generation: cxx23
+    standalone_dependency: xml, output_sink
+*/
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+#include "output_sink.hpp"
+#include "xml.hpp"
+
+namespace xml
+{
+
+// Destination of a writer, the sinks shared with json_exporter::exportTo().
+// Receives chunks of about writer::chunk_size bytes (a single long text is
+// passed in one piece).
+using sink = scl2::output_sink;
+using scl2::string_sink;
+using scl2::ostream_sink;
+using scl2::fd_sink;
+
+class writer
+{
+public:
+    static constexpr size_t chunk_size = 64 * 1024;
+
+    explicit writer(sink& out) : out_(out) {}
+
+    writer(const writer&) = delete;
+    writer& operator=(const writer&) = delete;
+
+    /// @brief Write `n` and its subtree, like n.serialize(alignDepth).
+    void write(const node& n, int alignDepth = 0);
+    /// @brief Write the element `n` with `children` in place of its own children.
+    /// For wrappers that keep parts of the tree apart, like html::document.
+    void write(const node& n, std::span<const node* const> children, int alignDepth = 0);
+
+    /// @brief Write the prolog and the root node, like doc.serialize().
+    void write(const document& doc);
+    void write(const document& doc, std::span<const node* const> root_children);
+
+    /// @brief Flush the sink. Every write() has already handed its output over.
+    void flush() { out_.flush(); }
+
+    size_t written() const { return written_; } // bytes handed to the sink so far
+
+private:
+    void prolog(const document& doc);
+    void element(const node& n, const std::span<const node* const>* children, int depth);
+    void child(const node& n, int depth);
+    void indent(int depth) { buffer_.append(static_cast<size_t>(depth) * tab_size, ' '); }
+    void drain();     // hand the buffer over once it is large enough
+    void drainAll();  // hand everything over
+
+    sink& out_;
+    std::string buffer_;
+    std::string scratch_; // a short text while deciding its layout
+    size_t written_ = 0;
+};
+
+} // namespace xml
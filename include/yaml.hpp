@@ -6,12 +6,13 @@
     FULL_FEATURED: NO
 
     [SCL_STANDALONE_MODULE]
-    version: 0.1.0
+    version: 0.3.0
 */
 
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <variant>
@@ -59,7 +60,7 @@ struct features {
     bool multi_line    = true;   // | and > scalar blocks
     bool anchors       = true;   // &anchor and *alias
     bool tags          = false;  // !!type tags
-    bool multi_doc     = false;  // --- / ... document separators
+    bool multi_doc     = false;  // --- / ... document separators (parseNext stops at each document)
 };
 
 class value {
@@ -217,6 +218,10 @@ public:
     static document fromStream(std::istream& input, features feat = {});
     static document fromString(const std::string& input, features feat = {});
 
+    // every document of a --- separated stream, see parser::fromStringAll()
+    static std::vector<document> fromStreamAll(std::istream& input, features feat = {}, unsigned threads = 0);
+    static std::vector<document> fromStringAll(std::string_view input, features feat = {}, unsigned threads = 0);
+
     std::string toString(yaml_exporter::config cfg = {}) const;
 
 private:
@@ -225,6 +230,8 @@ private:
 
 
 class parser {
+    friend class block_lexer;
+    friend struct scalar_token;
 public:
     // ---- Entry points ----
     static document fromStream(std::istream& input, features feat = {});
@@ -232,8 +239,18 @@ public:
 
     // Streaming: read next document from a persistent stream.
     // Returns true if a document was parsed, false at EOF.
+    // Set feat.multi_doc to stop at each --- / ... marker.
     bool parseNext(std::istream& input, document& out);
 
+    // Multi-document: split at --- / ... markers with a pre-scan, then parse
+    // the documents concurrently. Results are in document order.
+    // threads = 0 uses std::thread::hardware_concurrency().
+    static std::vector<document> fromStringAll(std::string_view input, features feat = {}, unsigned threads = 0);
+    static std::vector<document> fromStreamAll(std::istream& input, features feat = {}, unsigned threads = 0);
+
+    // Text of each document (markers excluded), views into `input`.
+    static std::vector<std::string_view> splitDocuments(std::string_view input, features feat = {});
+
     features feat;  // set before parsing
 
 private:
@@ -243,6 +260,7 @@ private:
     size_t      _line_num = 0;    // current line number (for errors)
     int         _indent_level= 0; // indent of current line
     int         _indent_unit = 0; // indent unit
+    bool        _doc_open = false; // a --- ended the last document and opened the next
 
 
     // ---- Indent stack (tracks block scopes) ----
@@ -263,18 +281,26 @@ private:
     // ---- Core loop ----
     bool readLine(std::istream& input);
     void parseLine();
+    void beginDocument();
+    document finishDocument();
+    void parseText(std::string_view text, document& out); // one document, no markers
+
+    // ---- Document markers ----
+    static bool isMarker(std::string_view line, std::string_view marker); // "---" or "..."
+    static bool hasContent(std::string_view line, const features& feat);
 
     // ---- Dispatching (extend here for new features) ----
     void dispatch_scalar(std::string text);
     void dispatch_mapping_key(const std::string& key);
     void dispatch_sequence_entry();
 
-    // ---- Scalar detection ----
-    bool isNull(const std::string& s);
-    bool isBool(const std::string& s);
-    bool isInteger(const std::string& s);
-    bool isDouble(const std::string& s);
-    std::string processDoubleQuotedEscapes(const std::string& s);
+    // ---- Scalar detection (shared with block_lexer) ----
+    static bool isNull(std::string_view s);
+    static bool isBool(std::string_view s);
+    static bool isTrue(std::string_view s); // for isBool() scalars
+    static bool isInteger(std::string_view s);
+    static bool isDouble(std::string_view s);
+    static std::string processDoubleQuotedEscapes(std::string_view s);
 
     // ---- Helpers ----
     int  countIndentLevel();
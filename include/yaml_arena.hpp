@@ -0,0 +1,230 @@
+/*
+    Arena backed YAML documents for SharedCppLib2
+
+    A read-only alternative to yaml::document for large inputs such as
+    Kubernetes-style bundles. yaml::value allocates every sequence, mapping,
+    key and scalar on its own; arena_document instead:
+
+    - places all nodes in a few large arena blocks, sequence elements and
+      mapping members contiguous, larger mappings with a sorted index,
+    - keeps plain and quoted scalars without escapes as string_views into the
+      input, only escaped ones are decoded into the arena,
+    - interns mapping keys, every occurrence of "metadata" shares one copy,
+    - keeps the anchor table as a sorted array in the arena,
+    - tears down by freeing a handful of blocks, however many nodes it holds.
+
+    It accepts the same block syntax as yaml::parser. A `---` separated
+    stream gives one root per document, all in the same arena; anchors and
+    aliases are scoped to their document. An alias refers to the latest
+    definition of its anchor before it, an alias ahead of any definition is
+    an error. `to_value()` converts into the
+    classic model when you need to edit.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: yaml
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "yaml.hpp"
+
+namespace scl2::yaml {
+
+class node;
+struct member;
+struct anchor_entry;
+class arena_document;
+
+/*
+    Bump allocator used by arena_document.
+    Memory is only given back all at once, by release() or the destructor.
+*/
+class arena {
+public:
+    explicit arena(size_t block_size = 16 * 1024);
+    arena(arena&& other) noexcept;
+    arena& operator=(arena&& other) noexcept;
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    template<typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "yaml::arena never runs destructors");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    /// @brief Copy `str` into the arena.
+    std::string_view store(std::string_view str);
+
+    /// @brief Make sure the next `size` bytes come from a single block.
+    void reserve(size_t size);
+
+    /// @brief Drop every block. Cost depends on the block count only.
+    void release();
+
+    size_t used() const { return used_; }         // bytes handed out
+    size_t reserved() const { return reserved_; } // bytes held in blocks
+
+private:
+    struct block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    void grow(size_t min_size);
+
+    std::vector<block> blocks_;
+    std::byte* cur_ = nullptr;
+    size_t left_ = 0;
+    size_t block_size_;
+    size_t used_ = 0;
+    size_t reserved_ = 0;
+};
+
+/*
+    One value inside an arena_document. 16 bytes, trivially copyable.
+    Nodes are only handed out by reference and stay valid as long as their document.
+
+    Accessors look through aliases like yaml::value does, type() and
+    is_alias() report the alias itself.
+*/
+class node {
+public:
+    node() = default;
+
+    yaml::type type() const { return type_; }
+
+    bool is_null() const { return target().type_ == yaml::type::null; }
+    bool is_bool() const { return target().type_ == yaml::type::boolean; }
+    bool is_int() const { return target().type_ == yaml::type::integer; }
+    bool is_double() const { return target().type_ == yaml::type::floating; }
+    bool is_string() const { return target().type_ == yaml::type::string; }
+    bool is_array() const { return target().type_ == yaml::type::array; }
+    bool is_object() const { return target().type_ == yaml::type::object; }
+    bool is_alias() const { return type_ == yaml::type::alias; }
+
+    std::string_view alias_name() const;
+    const node& resolve() const; // the anchored node of an alias
+
+    bool as_bool() const;
+    int64_t as_int() const;
+    double as_double() const; // integers are converted
+    std::string_view as_string() const;
+
+    // for array
+    std::span<const node> elements() const;
+    const node& operator[](size_t index) const;
+    const node& at(size_t index) const { return operator[](index); }
+
+    // for object, members are in document order
+    std::span<const member> members() const;
+    const node* find(std::string_view key) const; // nullptr if missing, the last one on duplicates
+    bool has_key(std::string_view key) const { return find(key) != nullptr; }
+    const node& operator[](std::string_view key) const;
+    const node& at(std::string_view key) const { return operator[](key); }
+
+    // array & object: element count; string: length; other: 0.
+    size_t size() const;
+
+    /// @brief Deep copy into the classic model, aliases are expanded.
+    value to_value() const;
+
+    // Mappings above this many members get a sorted index for find().
+    static constexpr size_t indexed_object_size = 8;
+
+private:
+    friend class arena_document;
+
+    const node& target() const { return type_ == yaml::type::alias ? resolve() : *this; }
+    const uint32_t* sorted_index() const; // only for mappings larger than indexed_object_size
+    value toValue(std::vector<const node*>& open) const;
+
+    yaml::type type_ = yaml::type::null;
+    uint32_t size_ = 0;
+    union {
+        bool boolean;
+        int64_t integer;
+        double floating;
+        const char* string;
+        const node* elements;
+        const member* members;
+        const anchor_entry* alias;
+    } data_ = {};
+};
+
+struct member {
+    std::string_view key;
+    node value;
+};
+
+struct anchor_entry {
+    std::string_view name;
+    const node* target;
+};
+
+class arena_document {
+public:
+    arena_document() = default;
+    arena_document(arena_document&&) noexcept = default;
+    arena_document& operator=(arena_document&&) noexcept = default;
+    arena_document(const arena_document&) = delete;
+    arena_document& operator=(const arena_document&) = delete;
+
+    /// @brief Parse `text`. Scalars point into it, so it must outlive the document.
+    static arena_document parse(std::string_view text, features feat = {});
+
+    /// @brief Parse and keep `text` inside the document.
+    static arena_document parse(std::string&& text, features feat = {});
+    static arena_document parse(const char* text, features feat = {}) { return parse(std::string_view(text), feat); }
+
+    static arena_document fromStream(std::istream& input, features feat = {});
+
+    // documents of a --- separated stream, 0 for an input without content
+    size_t documents() const { return parts_.size(); }
+
+    // root of a document; a null node if there is none at all, std::out_of_range past the last one
+    const node& root(size_t document = 0) const;
+    const node& operator[](std::string_view key) const { return root()[key]; }
+    const node& operator[](size_t index) const { return root()[index]; }
+
+    // anchors of a document sorted by name, the last definition of a name is listed
+    std::span<const anchor_entry> anchors(size_t document = 0) const;
+    const node* anchor(std::string_view name, size_t document = 0) const; // nullptr if undefined
+
+    value to_value(size_t document = 0) const { return root(document).to_value(); }
+
+    /// @brief Reset to a null document and free the arena at once.
+    void clear();
+
+    size_t arena_bytes() const { return arena_.reserved(); }
+
+private:
+    class builder;
+
+    struct part {
+        const node* root;
+        std::span<const anchor_entry> anchors;
+    };
+
+    static const node null_node;
+
+    arena arena_;
+    std::unique_ptr<std::string> owned_; // heap allocated, so views into it survive moves
+    std::span<const part> parts_;        // in the arena, one per document
+};
+
+} // namespace scl2::yaml
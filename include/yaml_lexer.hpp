@@ -0,0 +1,118 @@
+/*
+    YAML block lexer for SharedCppLib2
+
+    The line grammar shared by yaml::reader and yaml::arena_document: it
+    splits each physical line into indentation, comment, document markers,
+    "key:" and "- " entries, anchors and scalar tokens, tracks the open
+    indentation levels and reports the structure to a block_handler. What
+    gets built from it, events or arena nodes, is up to the handler.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: yaml
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "yaml.hpp"
+
+namespace scl2::yaml {
+
+// A scalar or mapping key as written, already typed.
+struct scalar_token {
+    yaml::type type = yaml::type::null; // null, boolean, integer, floating or string
+    char quote = 0;        // string: '"' or '\'' if it was quoted
+    std::string_view text; // string: between the quotes, escapes not processed yet
+    union {
+        bool boolean;
+        int64_t integer;
+        double floating;
+    } data = {};
+
+    /// @brief True if `text` is the string itself, no escape or '' to decode.
+    bool literal() const { return literal_; }
+
+    /// @brief The decoded string, for tokens that are not literal().
+    std::string decode() const;
+
+private:
+    friend class block_lexer;
+    bool literal_ = true;
+};
+
+/*
+    Receives the structure of a block document. Every value is announced by
+    on_entry() (sequence), on_key() (mapping) or the start of a document
+    and then given by exactly one on_scalar(), on_alias() or on_open() ...
+    on_close() pair, so a handler can keep "the value being filled" on a
+    stack. A missing value ("key:" with nothing nested) is a null scalar.
+*/
+class block_handler {
+public:
+    virtual ~block_handler() = default;
+
+    virtual void on_start_document() {}
+    virtual void on_end_document() {}
+    virtual void on_open(bool mapping) = 0;
+    virtual void on_close(bool mapping) = 0;
+    virtual void on_entry() {}
+    virtual void on_key(const scalar_token& key) = 0;
+    virtual void on_anchor(std::string_view name) = 0; // for the value that follows
+    virtual void on_scalar(const scalar_token& scalar) = 0;
+    virtual void on_alias(std::string_view name) = 0;
+};
+
+class block_lexer {
+public:
+    explicit block_lexer(features feat = {}) : feat_(feat) {}
+
+    /// @brief One physical line, without its '\n'. Throws yaml_exception on malformed input.
+    void line(std::string_view raw, block_handler& handler);
+
+    /// @brief End of input: closes the open document, if any.
+    void finish(block_handler& handler) { endDocument(handler); }
+
+    size_t line_number() const { return line_; } // lines consumed so far
+
+private:
+    struct frame {
+        size_t indent; // column of the entries
+        bool mapping;
+        bool at_key;   // a sequence at the same column as its key ("key:\n- a")
+    };
+
+    void content(size_t column, std::string_view t, block_handler& h);
+    void block(size_t column, std::string_view t, bool dash, bool at_key, block_handler& h);
+    void sequenceEntry(size_t column, std::string_view t, block_handler& h);
+    void mappingEntry(size_t column, std::string_view t, block_handler& h);
+    void inlineValue(size_t column, std::string_view t, size_t owner_indent, bool from_key, block_handler& h);
+    void scalar(std::string_view t, block_handler& h) const;
+    bool splitKey(std::string_view t, scalar_token& key, size_t& after) const;
+    std::string_view stripComment(std::string_view t) const;
+    static bool isDash(std::string_view t) { return t.front() == '-' && (t.size() == 1 || t[1] == ' '); }
+
+    void startDocument(block_handler& h);
+    void endDocument(block_handler& h);
+    void open(size_t column, bool mapping, bool at_key, block_handler& h);
+    void close(block_handler& h);
+    [[noreturn]] void fail(const std::string& message) const;
+
+    features feat_;
+    size_t line_ = 0;
+
+    std::vector<frame> frames_;
+    bool in_document_ = false;
+    bool root_set_ = false;
+    bool awaiting_ = false; // a "key:" or "-" waiting for its value on the following lines
+    bool awaiting_key_ = false;
+    size_t awaiting_indent_ = 0;
+};
+
+} // namespace scl2::yaml
@@ -0,0 +1,151 @@
+/*
+    YAML Reader for SharedCppLib2
+
+    Incremental, event based (pull) YAML parsing for exports too large to hold
+    as a yaml::document. Feed the input in chunks of any size with feed(), and
+    pull events with next() until it asks for more input.
+
+    Events are produced line by line as soon as a line is complete. Aliases
+    are reported as alias events and never expanded, so no anchor table is
+    kept: memory stays bounded by the chunk size plus the nesting depth,
+    whatever the size of the document.
+
+    Multi-document streams are reported with start_document/end_document
+    around each document, `---` and `...` are always recognized.
+
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: yaml
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "yaml.hpp"
+#include "yaml_lexer.hpp"
+
+namespace scl2::yaml {
+
+enum class event : uint8_t {
+    need_input = 0,     // everything fed so far is consumed, feed() more or finish()
+    start_document = 1,
+    end_document = 2,
+    start_mapping = 3,
+    end_mapping = 4,
+    start_sequence = 5,
+    end_sequence = 6,
+    key = 7,            // key() holds the mapping key
+    scalar = 8,         // scalar() holds the value
+    alias = 9,          // alias() holds the anchor name, without '*'
+    end_of_input = 10,  // finish() was called and the input is complete
+};
+
+class event_handler {
+public:
+    virtual ~event_handler() = default;
+
+    virtual void on_start_document() {}
+    virtual void on_end_document() {}
+    virtual void on_start_mapping(const std::string& anchor) { (void)anchor; }
+    virtual void on_end_mapping() {}
+    virtual void on_start_sequence(const std::string& anchor) { (void)anchor; }
+    virtual void on_end_sequence() {}
+    virtual void on_key(const std::string& key) { (void)key; }
+    virtual void on_scalar(const value& scalar, const std::string& anchor) { (void)scalar; (void)anchor; }
+    virtual void on_alias(const std::string& name) { (void)name; }
+};
+
+class reader : private block_handler {
+public:
+    explicit reader(features feat = {});
+
+    /// @brief Append a chunk of input. Chunks may split lines anywhere.
+    void feed(std::string_view chunk);
+
+    /// @brief Mark the end of the input, the last line does not need a newline.
+    void finish();
+
+    /// @brief Next event, need_input when the buffered input runs out. Throws yaml_exception on malformed input.
+    event next();
+
+    /// @brief Pull every available event into `handler`. Returns false once the input is complete.
+    bool dispatch(event_handler& handler);
+
+    /// @brief Right after start_mapping/start_sequence: drop the events of the whole container.
+    /// The next event returned is the matching end_mapping/end_sequence.
+    void skip();
+
+    const std::string& key() const { return key_; }
+    const value& scalar() const { return scalar_; }
+    const std::string& alias() const { return alias_; }
+
+    // &anchor of the node opened by the last start_mapping/start_sequence/scalar event, empty if none
+    const std::string& anchor() const { return anchor_; }
+
+    // number of open mappings and sequences
+    size_t depth() const { return path_.size(); }
+
+    // json pointer style path of the node the last event belongs to ("" for the root)
+    std::string path() const;
+
+    size_t line() const { return lexer_.line_number(); } // lines consumed so far
+    size_t buffered() const { return buffer_.size() - offset_; }
+
+    void reset();
+
+private:
+    // ---- producer: lines -> queued events, the grammar is block_lexer's ----
+    struct item {
+        event type;
+        std::string text; // key or alias name
+        value scalar;
+        std::string anchor;
+    };
+
+    bool takeLine(std::string_view& line);
+
+    void on_start_document() override { emit(event::start_document); }
+    void on_end_document() override { emit(event::end_document); }
+    void on_open(bool mapping) override { emit(mapping ? event::start_mapping : event::start_sequence); }
+    void on_close(bool mapping) override { emit(mapping ? event::end_mapping : event::end_sequence); }
+    void on_key(const scalar_token& key) override;
+    void on_anchor(std::string_view name) override { pending_anchor_.assign(name); }
+    void on_scalar(const scalar_token& scalar) override;
+    void on_alias(std::string_view name) override;
+    void emit(event type, std::string text = {}, value scalar = value());
+
+    features feat_;
+    block_lexer lexer_;
+    std::string buffer_;
+    size_t offset_ = 0; // consumed bytes in buffer_
+    bool finished_ = false;
+    bool ended_ = false;
+    std::string pending_anchor_;
+
+    std::vector<item> queue_; // events of the current line, bounded by the depth
+    size_t queue_head_ = 0;
+
+    // ---- consumer: state as of the last returned event ----
+    struct segment {
+        bool mapping;
+        size_t count;    // nodes started in a sequence, the current index is count - 1
+        std::string key; // current key of a mapping
+    };
+
+    std::vector<segment> path_;
+    bool last_start_ = false; // last event opened a container
+    size_t skip_depth_ = 0;   // non-zero while skip() is in progress
+
+    std::string key_;
+    value scalar_;
+    std::string alias_;
+    std::string anchor_;
+};
+
+} // namespace scl2::yaml
@@ -110,6 +110,16 @@ body &document::getHtmlBody(){ return html_body; }
 body &document::body() { return html_body; }
 void document::addHtmlBody(::html::body &&bdy) { html_body = std::move(bdy); }
 
+xml::query document::query() const
+{
+    return xml::query({&html_header, &html_body});
+}
+
+std::vector<const xml::node*> document::select(std::string_view path) const
+{
+    return xml::query({&html_header, &html_body}, false).select(path);
+}
+
 void document::deserialize(const std::string& html_text)
 {
     reset();
@@ -135,13 +145,18 @@ void document::deserialize(const std::string& html_text)
 
 std::string document::serialize() const
 {
-    // before serializing, we need to set header and body nodes to root node
-    xml::node& root = xml_doc.getRootNode();
-    root.resetChildNodes();
-    root.addChildNode(std::move(xml::node(html_header)));
-    root.addChildNode(std::move(xml::node(html_body)));
+    std::string result;
+    xml::string_sink out(result);
+    serialize(out);
+    return result;
+}
 
-    return xml_doc.serialize();
+void document::serialize(xml::sink &out) const
+{
+    // header and body are written as the root's children in place,
+    // without copying them into xml_doc first
+    const xml::node* children[] = {&html_header, &html_body};
+    xml::writer(out).write(xml_doc, children);
 }
 
 void document::clear()
@@ -169,7 +184,8 @@ std::istream &operator>>(std::istream &is, document &doc)
 
 std::ostream &operator<<(std::ostream &os, const document &doc)
 {
-    os << doc.serialize();
+    xml::ostream_sink out(os);
+    doc.serialize(out);
     return os;
 }
 
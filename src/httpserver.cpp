@@ -4,16 +4,25 @@ namespace network::http {
 
 server::server()
     : m_tcp_server()
+#if defined(__linux__)
+    , m_multi_server()
+#endif
 {
 }
 
 server::server(uint16_t port)
     : m_tcp_server(port)
+#if defined(__linux__)
+    , m_multi_server(port)
+#endif
 {
 }
 
 server::server(network_address address, uint16_t port)
     : m_tcp_server(address, port)
+#if defined(__linux__)
+    , m_multi_server(address, port)
+#endif
 {
 }
 
@@ -34,6 +43,9 @@ void server::start(uint16_t port)
 
 void server::stop()
 {
+#if defined(__linux__)
+    m_multi_server.stop();
+#endif
     m_tcp_server.stop();
 }
 
@@ -57,11 +69,21 @@ int server::tick()
 
 uint16_t server::port() const
 {
+#if defined(__linux__)
+    if (m_multi_server.running()) {
+        return m_multi_server.port();
+    }
+#endif
     return m_tcp_server.port();
 }
 
 network_address server::address() const
 {
+#if defined(__linux__)
+    if (m_multi_server.running()) {
+        return m_multi_server.address();
+    }
+#endif
     return m_tcp_server.address();
 }
 
@@ -81,66 +103,100 @@ void server::handleClient(tcp::client_id id)
         }
 
         // Accumulate data in buffer
-        m_client_buffers[id] += data.toStdString();
-
         std::string& buffer = m_client_buffers[id];
-        
-        // Check if we have complete headers
-        if (!request::has_complete_headers(buffer)) {
+        buffer += data.toStdString();
+
+        auto resp = respond(buffer);
+        if (!resp) {
             return; // Wait for more data
         }
-        
-        // Try to parse the request to check Content-Length
-        request req;
-        try {
-            req = request::deserialize(buffer);
-        } catch (const std::exception&) {
-            // Parsing failed, send 400 Bad Request
-            response resp = response::make_text(http_status::BAD_REQUEST, "Bad Request");
-            handler.write(scl2::bytearray(resp.serialize()));
-            m_client_buffers.erase(id);
-            return;
-        }
-        
-        // Check if we have complete body
-        size_t content_length = req.get_content_length();
-        size_t header_end = buffer.find("\r\n\r\n");
-        size_t body_start = header_end + 4;
-        size_t current_body_length = buffer.size() - body_start;
-        
-        if (current_body_length < content_length) {
-            return; // Wait for more body data
-        }
-        
-        // We have a complete request, process it
-        response resp;
-        
-        // Look up route handler
-        auto route_key = std::make_pair(req.method, req.path);
-        auto route_it = m_routes.find(route_key);
-        
-        if (route_it != m_routes.end()) {
-            // Route found, call handler
-            try {
-                std::string response_body = route_it->second(req);
-                resp = response::make_text(http_status::OK, response_body);
-            } catch (const std::exception& e) {
-                // Handler threw exception
-                resp = response::make_text(http_status::INTERNAL_SERVER_ERROR, 
-                                          "Internal Server Error: " + std::string(e.what()));
-            }
-        } else {
-            // No route found
-            resp = response::make_text(http_status::NOT_FOUND, 
-                                      "Not Found: " + req.path);
-        }
-        
+
         // Send response
-        handler.write(scl2::bytearray(resp.serialize()));
+        handler.write(scl2::bytearray(*resp));
         
         // Clear the buffer
         m_client_buffers.erase(id);
     }
 }
 
+std::optional<std::string> server::respond(std::string& buffer) const
+{
+    // Check if we have complete headers
+    if (!request::has_complete_headers(buffer)) {
+        return std::nullopt;
+    }
+    size_t header_end = buffer.find("\r\n\r\n");
+    size_t body_start = header_end + 4;
+
+    // Try to parse the request to check Content-Length
+    request req;
+    try {
+        req = request::deserialize(buffer.substr(0, body_start));
+    } catch (const std::exception&) {
+        // Parsing failed, send 400 Bad Request
+        buffer.clear();
+        return response::make_text(http_status::BAD_REQUEST, "Bad Request").serialize();
+    }
+
+    // Check if we have complete body
+    size_t content_length = req.get_content_length();
+    if (buffer.size() - body_start < content_length) {
+        return std::nullopt; // Wait for more body data
+    }
+    req.body = buffer.substr(body_start, content_length);
+    buffer.erase(0, body_start + content_length);
+
+    // We have a complete request, process it
+    response resp;
+
+    // Look up route handler
+    auto route_key = std::make_pair(req.method, req.path);
+    auto route_it = m_routes.find(route_key);
+
+    if (route_it != m_routes.end()) {
+        // Route found, call handler
+        try {
+            std::string response_body = route_it->second(req);
+            resp = response::make_text(http_status::OK, response_body);
+        } catch (const std::exception& e) {
+            // Handler threw exception
+            resp = response::make_text(http_status::INTERNAL_SERVER_ERROR, 
+                                      "Internal Server Error: " + std::string(e.what()));
+        }
+    } else {
+        // No route found
+        resp = response::make_text(http_status::NOT_FOUND, 
+                                  "Not Found: " + req.path);
+    }
+
+    return resp.serialize();
+}
+
+#if defined(__linux__)
+
+void server::run(const tcp::multi_server::options& opts)
+{
+    m_multi_server.config() = opts;
+    m_multi_server.onConnect([](tcp::connection& c) {
+        c.context() = std::string(); // partial request of this connection
+    });
+    m_multi_server.onData([this](tcp::connection& c, std::string_view data) {
+        std::string& buffer = std::any_cast<std::string&>(c.context());
+        buffer.append(data);
+        // pipelined requests are answered in order
+        while (auto resp = respond(buffer)) {
+            c.send(*resp);
+        }
+    });
+    m_multi_server.start();
+    m_multi_server.wait();
+}
+
+std::vector<tcp::event_server::statistics> server::stats() const
+{
+    return m_multi_server.stats();
+}
+
+#endif
+
 } // namespace network::http
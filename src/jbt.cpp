@@ -0,0 +1,426 @@
+/*
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.1
+    cpp_generation: cxx17 - cxx23
+    standalone_dependency: json
+*/
+#include "jbt.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace scl2 {
+
+namespace {
+
+enum jbt_tag : uint8_t {
+    jbt_null = 0,
+    jbt_false = 1,
+    jbt_true = 2,
+    jbt_integer = 3,
+    jbt_floating = 4,
+    jbt_string = 5,
+    jbt_array = 6,
+    jbt_object = 7,
+    jbt_bytes = 8,
+    jbt_data_uri = 9,
+};
+
+constexpr char jbt_magic[4] = {'J', 'B', 'T', 0x01};
+
+// tag + body size + count
+constexpr size_t jbt_container_header = 9;
+
+[[noreturn]] void jbt_fail(const char* what)
+{
+    throw std::runtime_error(std::string("Invalid jbt data: ") + what);
+}
+
+uint32_t jbt_load_u32(const uint8_t* p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+void jbt_store_u32(std::string& out, size_t at, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out[at + i] = static_cast<char>(v >> (8 * i));
+}
+
+void jbt_put_u32(std::string& out, uint32_t v)
+{
+    out.append(4, '\0');
+    jbt_store_u32(out, out.size() - 4, v);
+}
+
+uint32_t jbt_checked_u32(size_t v)
+{
+    if (v > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("jbt: document is larger than 4 GiB");
+    return static_cast<uint32_t>(v);
+}
+
+void jbt_put_varint(std::string& out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out += static_cast<char>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+uint64_t jbt_get_varint(const uint8_t*& p, const uint8_t* end)
+{
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) jbt_fail("truncated varint");
+        const uint8_t b = *p++;
+        v |= uint64_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    jbt_fail("varint too long");
+}
+
+// LEB128 length followed by that many bytes, which must fit before `end`
+std::string_view jbt_get_bytes(const uint8_t* p, const uint8_t* end)
+{
+    const uint64_t length = jbt_get_varint(p, end);
+    if (length > static_cast<uint64_t>(end - p)) jbt_fail("truncated string");
+    return std::string_view(reinterpret_cast<const char*>(p), static_cast<size_t>(length));
+}
+
+void jbt_put_bytes(std::string& out, const void* data, size_t size)
+{
+    jbt_put_varint(out, size);
+    out.append(static_cast<const char*>(data), size);
+}
+
+void jbt_encode_value(const json_value& value, std::string& out)
+{
+    switch (value.type()) {
+    case json_value_type::null:
+        out += static_cast<char>(jbt_null);
+        break;
+    case json_value_type::boolean:
+        out += static_cast<char>(value.as_bool() ? jbt_true : jbt_false);
+        break;
+    case json_value_type::integer: {
+        const int64_t i = value.as_int();
+        out += static_cast<char>(jbt_integer);
+        // zigzag, so small negative numbers stay short
+        jbt_put_varint(out, (static_cast<uint64_t>(i) << 1) ^ static_cast<uint64_t>(i >> 63));
+        break;
+    }
+    case json_value_type::floating: {
+        const double d = value.as_double();
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        out += static_cast<char>(jbt_floating);
+        for (int i = 0; i < 8; ++i) out += static_cast<char>(bits >> (8 * i));
+        break;
+    }
+    case json_value_type::string:
+        out += static_cast<char>(jbt_string);
+        jbt_put_bytes(out, value.as_string().data(), value.as_string().size());
+        break;
+    case json_value_type::array: {
+        const json_array& arr = value.as_array();
+        const size_t start = out.size();
+        out += static_cast<char>(jbt_array);
+        jbt_put_u32(out, 0); // body size, patched below
+        jbt_put_u32(out, jbt_checked_u32(arr.size()));
+        const size_t table = out.size();
+        out.append(4 * arr.size(), '\0');
+        for (size_t i = 0; i < arr.size(); ++i) {
+            jbt_store_u32(out, table + 4 * i, jbt_checked_u32(out.size() - start));
+            jbt_encode_value(arr[i], out);
+        }
+        jbt_store_u32(out, start + 1, jbt_checked_u32(out.size() - start - 5));
+        break;
+    }
+    case json_value_type::object: {
+        // std::map already iterates in bytewise key order
+        const json_object& obj = value.as_object();
+        const size_t start = out.size();
+        out += static_cast<char>(jbt_object);
+        jbt_put_u32(out, 0);
+        jbt_put_u32(out, jbt_checked_u32(obj.size()));
+        const size_t table = out.size();
+        out.append(4 * obj.size(), '\0');
+        size_t i = 0;
+        for (const auto& [key, member] : obj) {
+            jbt_store_u32(out, table + 4 * i++, jbt_checked_u32(out.size() - start));
+            jbt_put_bytes(out, key.data(), key.size());
+            jbt_encode_value(member, out);
+        }
+        jbt_store_u32(out, start + 1, jbt_checked_u32(out.size() - start - 5));
+        break;
+    }
+#ifdef SCL2_JSON_ENABLE_EXTENSIONS
+    case json_value_type::bytearray:
+        out += static_cast<char>(jbt_bytes);
+        jbt_put_bytes(out, value.as_bytearray().data(), value.as_bytearray().size());
+        break;
+    case json_value_type::data_uri: {
+        const std::string uri = value.as_data_uri().to_string();
+        out += static_cast<char>(jbt_data_uri);
+        jbt_put_bytes(out, uri.data(), uri.size());
+        break;
+    }
+#endif
+    }
+}
+
+} // namespace
+
+uint8_t jbt_value::tag() const
+{
+    if (!p_) throw std::runtime_error("jbt_value: invalid value");
+    return *p_;
+}
+
+json_value_type jbt_value::type() const
+{
+    switch (tag()) {
+    case jbt_null:     return json_value_type::null;
+    case jbt_false:
+    case jbt_true:     return json_value_type::boolean;
+    case jbt_integer:  return json_value_type::integer;
+    case jbt_floating: return json_value_type::floating;
+    case jbt_string:   return json_value_type::string;
+    case jbt_array:    return json_value_type::array;
+    case jbt_object:   return json_value_type::object;
+#ifdef SCL2_JSON_ENABLE_EXTENSIONS
+    case jbt_bytes:    return json_value_type::bytearray;
+    case jbt_data_uri: return json_value_type::data_uri;
+#endif
+    default:           jbt_fail("unknown tag");
+    }
+}
+
+bool jbt_value::as_bool() const
+{
+    if (!is_bool()) throw std::runtime_error("jbt_value::as_bool: not a boolean");
+    return tag() == jbt_true;
+}
+
+int64_t jbt_value::as_int() const
+{
+    if (!is_int()) throw std::runtime_error("jbt_value::as_int: not an integer");
+    const uint8_t* p = p_ + 1;
+    const uint64_t z = jbt_get_varint(p, end_);
+    return static_cast<int64_t>((z >> 1) ^ (~(z & 1) + 1));
+}
+
+double jbt_value::as_double() const
+{
+    if (is_int()) return static_cast<double>(as_int());
+    if (!is_double()) throw std::runtime_error("jbt_value::as_double: not a number");
+    if (end_ - p_ < 9) jbt_fail("truncated double");
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) bits |= uint64_t(p_[1 + i]) << (8 * i);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+std::string_view jbt_value::as_string() const
+{
+    if (!is_string()) throw std::runtime_error("jbt_value::as_string: not a string");
+    return jbt_get_bytes(p_ + 1, end_);
+}
+
+const uint8_t *jbt_value::containerEnd() const
+{
+    if (end_ - p_ < static_cast<ptrdiff_t>(jbt_container_header)) jbt_fail("truncated container");
+    const uint32_t body = jbt_load_u32(p_ + 1);
+    const uint32_t count = jbt_load_u32(p_ + 5);
+    if (body > static_cast<size_t>(end_ - p_) - 5) jbt_fail("container exceeds its parent");
+    if (body < 4 + 4 * static_cast<uint64_t>(count)) jbt_fail("offset table exceeds its container");
+    return p_ + 5 + body;
+}
+
+jbt_value jbt_value::child(size_t index) const
+{
+    const uint8_t* end = containerEnd();
+    const uint32_t offset = jbt_load_u32(p_ + jbt_container_header + 4 * index);
+    const size_t first = jbt_container_header + 4 * size_t(jbt_load_u32(p_ + 5));
+    if (offset < first || offset >= static_cast<size_t>(end - p_)) jbt_fail("child offset out of range");
+    return jbt_value(p_ + offset, end);
+}
+
+size_t jbt_value::size() const
+{
+    switch (tag()) {
+    case jbt_array:
+    case jbt_object:
+        containerEnd();
+        return jbt_load_u32(p_ + 5);
+    case jbt_string:
+        return as_string().size();
+    default:
+        return 0;
+    }
+}
+
+jbt_value jbt_value::operator[](size_t index) const
+{
+    if (!is_array()) throw std::runtime_error("jbt_value::operator[]: not an array");
+    if (index >= size()) throw std::out_of_range("jbt_value::operator[]: index out of range");
+    return child(index);
+}
+
+std::string_view jbt_value::key_at(size_t index) const
+{
+    if (!is_object()) throw std::runtime_error("jbt_value::key_at: not an object");
+    if (index >= size()) throw std::out_of_range("jbt_value::key_at: index out of range");
+    const jbt_value entry = child(index);
+    return jbt_get_bytes(entry.p_, entry.end_);
+}
+
+jbt_value jbt_value::value_at(size_t index) const
+{
+    const std::string_view key = key_at(index);
+    const uint8_t* value = reinterpret_cast<const uint8_t*>(key.data() + key.size());
+    const uint8_t* end = containerEnd();
+    if (value >= end) jbt_fail("member without value");
+    return jbt_value(value, end);
+}
+
+jbt_value jbt_value::find(std::string_view key) const
+{
+    if (!is_object()) throw std::runtime_error("jbt_value::find: not an object");
+
+    // members are sorted, same order as std::string comparison
+    size_t lo = 0, hi = size();
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const int cmp = key_at(mid).compare(key);
+        if (cmp == 0) return value_at(mid);
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return jbt_value();
+}
+
+jbt_value jbt_value::operator[](std::string_view key) const
+{
+    jbt_value value = find(key);
+    if (!value) throw std::out_of_range("jbt_value::operator[]: key not found: " + std::string(key));
+    return value;
+}
+
+jbt_value jbt_value::at_path(const json_pointer &pointer) const
+{
+    jbt_value current = *this;
+    const std::vector<std::string>& segments = pointer.segments();
+    for (size_t depth = 0; depth < segments.size(); ++depth) {
+        const std::string& segment = segments[depth];
+        if (current.is_array()) {
+            const size_t index = pointer.indices()[depth];
+            if (index == json_pointer::npos)
+                throw std::runtime_error("jbt_value::at_path: invalid array index: " + segment);
+            if (index >= current.size())
+                throw std::runtime_error("jbt_value::at_path: array index out of bounds: " + segment);
+            current = current.child(index);
+        } else if (current.is_object()) {
+            current = current.find(segment);
+            if (!current)
+                throw std::runtime_error("jbt_value::at_path: object key not found: " + segment);
+        } else {
+            throw std::runtime_error("jbt_value::at_path: cannot apply pointer to scalar value");
+        }
+    }
+    return current;
+}
+
+json_value jbt_value::to_value() const
+{
+    switch (type()) {
+    case json_value_type::null:     return json_value(nullptr);
+    case json_value_type::boolean:  return json_value(as_bool());
+    case json_value_type::integer:  return json_value(as_int());
+    case json_value_type::floating: return json_value(as_double());
+    case json_value_type::string:   return json_value(std::string(as_string()));
+    case json_value_type::array: {
+        const size_t n = size();
+        json_array arr;
+        arr.reserve(n);
+        for (size_t i = 0; i < n; ++i) arr.push_back(child(i).to_value());
+        return json_value(std::move(arr));
+    }
+    case json_value_type::object: {
+        const size_t n = size();
+        json_object obj;
+        for (size_t i = 0; i < n; ++i)
+            obj.emplace_hint(obj.end(), std::string(key_at(i)), value_at(i).to_value());
+        return json_value(std::move(obj));
+    }
+#ifdef SCL2_JSON_ENABLE_EXTENSIONS
+    case json_value_type::bytearray: {
+        const std::string_view bytes = jbt_get_bytes(p_ + 1, end_);
+        return json_value(scl2::bytearray(bytes.data(), bytes.size()));
+    }
+    case json_value_type::data_uri:
+        return json_value(inline_data_uri::from_string(std::string(jbt_get_bytes(p_ + 1, end_))));
+#endif
+    }
+    return json_value();
+}
+
+jbt_view::jbt_view(const void *data, size_t size)
+{
+    if (!is_jbt(data, size)) jbt_fail("missing jbt header");
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint32_t payload = jbt_load_u32(p + 4);
+    if (payload == 0) jbt_fail("empty document");
+    if (payload > size - header_size) jbt_fail("truncated document");
+    root_ = jbt_value(p + header_size, p + header_size + payload);
+    size_ = header_size + payload;
+}
+
+bool jbt_view::is_jbt(const void *data, size_t size)
+{
+    return data && size >= header_size && std::memcmp(data, jbt_magic, sizeof(jbt_magic)) == 0;
+}
+
+std::string jbt::encode(const json_value &value)
+{
+    std::string out;
+    encode(value, out);
+    return out;
+}
+
+void jbt::encode(const json_value &value, std::string &out)
+{
+    const size_t start = out.size();
+    out.append(jbt_magic, sizeof(jbt_magic));
+    jbt_put_u32(out, 0);
+    jbt_encode_value(value, out);
+    jbt_store_u32(out, start + 4, jbt_checked_u32(out.size() - start - jbt_view::header_size));
+}
+
+json jbt::decode(const void *data, size_t size)
+{
+    return json(jbt_view(data, size).root().to_value());
+}
+
+#ifdef SCL2_JSON_ENABLE_EXTENSIONS
+
+scl2::bytearray json::dump() const
+{
+    return scl2::bytearray(jbt::encode(*this));
+}
+
+void json::load(scl2::bytearray &data)
+{
+    // read from the read cursor, like the other load() implementations
+    jbt_view view(data.data() + data.tellr(), data.remaining());
+    json_value::operator=(view.root().to_value());
+    data.seekr(data.tellr() + view.byte_size());
+}
+
+#endif
+
+} // namespace scl2
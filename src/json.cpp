@@ -1,12 +1,31 @@
 /*
     [SCL_STANDALONE_MODULE]
-    version: 1.9.0
+    version: 1.17.1
     cpp_generation: cxx17 - cxx23 
 */
 #include "json.hpp"
 
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <cctype>
+#include <charconv>
+#include <bit>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SCL2_JSON_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SCL2_JSON_SSE2
+#endif
+#if defined(__PCLMUL__) && defined(__x86_64__)
+    #include <wmmintrin.h>
+#endif
 
 #if defined(_WIN32) || defined(_WIN64)
 #define WIN32_LEAN_AND_MEAN
@@ -24,8 +43,30 @@ json_pointer::json_pointer(const std::string& pointer_str)
 
 json_value &json_pointer::apply(const json_value &root) const
 {
-    if (tokens.empty()) return const_cast<json_value&>(root); // empty pointer points to the whole document
-    return apply_impl(root, 0);
+    const json_value* current = &root; // empty pointer points to the whole document
+    for (size_t depth = 0; depth < tokens.size(); ++depth) {
+        const std::string& segment = tokens[depth];
+        if (current->is_array()) {
+            const size_t index = token_indices[depth];
+            if (index == npos || index == index_overflow) {
+                throw std::runtime_error("json_pointer::apply: invalid array index: " + segment);
+            }
+            if (index >= current->array_size()) {
+                throw std::runtime_error("json_pointer::apply: array index out of bounds: " + segment);
+            }
+            current = &current->as_array()[index];
+        } else if (current->is_object()) {
+            const json_object& object = current->as_object();
+            auto it = object.find(segment);
+            if (it == object.end()) {
+                throw std::runtime_error("json_pointer::apply: object key not found: " + segment);
+            }
+            current = &it->second;
+        } else {
+            throw std::runtime_error("json_pointer::apply: cannot apply pointer to scalar value");
+        }
+    }
+    return const_cast<json_value&>(*current);
 }
 
 json_value &json_pointer::apply(json_value &root) const
@@ -55,6 +96,17 @@ void json_pointer::split_tokens()
     // get the last token
     std::string last_token = pointer_str.substr(lpos);
     tokens.push_back(unescape_segment(last_token));
+
+    // array indices are parsed here once instead of on every apply()
+    token_indices.reserve(tokens.size());
+    for (const std::string& token : tokens) {
+        size_t index = npos;
+        if (!token.empty() && token.find_first_not_of("0123456789") == std::string::npos) {
+            auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), index);
+            if (ec != std::errc()) index = index_overflow;
+        }
+        token_indices.push_back(index);
+    }
 }
 
 std::string json_pointer::unescape_segment(std::string segment) const
@@ -67,55 +119,24 @@ std::string json_pointer::unescape_segment(std::string segment) const
     return segment;
 }
 
-json_value &json_pointer::apply_impl(const json_value &current, size_t depth) const
-{
-    const std::string& segment = tokens[depth];
-
-    // Navigate into the current level
-    const json_value* next = nullptr;
-    if (current.is_array()) {
-        size_t index;
-        try { index = std::stoul(segment); } catch (const std::exception&) {
-            throw std::runtime_error("json_pointer::apply: invalid array index: " + segment);
-        }
-        if (index >= current.array_size()) {
-            throw std::runtime_error("json_pointer::apply: array index out of bounds: " + segment);
-        }
-        next = &current[index];
-    } else if (current.is_object()) {
-        if (!current.has_key(segment)) {
-            throw std::runtime_error("json_pointer::apply: object key not found: " + segment);
-        }
-        next = &current[segment];
-    } else {
-        throw std::runtime_error("json_pointer::apply: cannot apply pointer to scalar value");
-    }
-
-    // Last token: return the target
-    if (depth == tokens.size() - 1) return const_cast<json_value&>(*next);
-
-    // Intermediate: recurse deeper
-    return apply_impl(*next, depth + 1);
-}
-
 json_value &json_pointer::apply_impl(json_value &current, size_t depth) const
 {
     const std::string& segment = tokens[depth];
+    const size_t index = token_indices[depth];
     bool is_last = (depth == tokens.size() - 1);
 
-    // Auto-create container if current is null
+    // Auto-create container if current is null, not for an index it would reject anyway
     if (current.is_null()) {
-        bool is_index = !segment.empty()
-            && segment.find_first_not_of("0123456789") == std::string::npos;
-        if (is_index)
+        if (index == index_overflow)
+            throw std::runtime_error("json_pointer::apply: invalid array index: " + segment);
+        if (index != npos)
             current = json_value(std::vector<json_value>{});
         else
             current = json_value(std::map<std::string, json_value>{});
     }
 
     if (current.is_array()) {
-        size_t index;
-        try { index = std::stoul(segment); } catch (const std::exception&) {
+        if (index == npos || index == index_overflow) {
             throw std::runtime_error("json_pointer::apply: invalid array index: " + segment);
         }
         // Auto-expand array if needed
@@ -124,10 +145,10 @@ json_value &json_pointer::apply_impl(json_value &current, size_t depth) const
         if (is_last) return current[index];
         return apply_impl(current[index], depth + 1);
     } else if (current.is_object()) {
-        if (!current.has_key(segment))
-            current[segment] = json_value(nullptr);
-        if (is_last) return current[segment];
-        return apply_impl(current[segment], depth + 1);
+        // inserts null for a missing key
+        json_value& next = current.as_object()[segment];
+        if (is_last) return next;
+        return apply_impl(next, depth + 1);
     } else {
         throw std::runtime_error("json_pointer::apply: cannot apply pointer to scalar value");
     }
@@ -135,34 +156,90 @@ json_value &json_pointer::apply_impl(json_value &current, size_t depth) const
 
 bool json_pointer::contains(const json_value &root) const
 {
-    if (tokens.empty()) return true;
-    return contains_impl(root, 0);
+    const json_value* current = &root;
+    for (size_t depth = 0; depth < tokens.size(); ++depth) {
+        if (current->is_array()) {
+            const size_t index = token_indices[depth];
+            if (index >= current->array_size()) return false; // also npos
+            current = &current->as_array()[index];
+        } else if (current->is_object()) {
+            const json_object& object = current->as_object();
+            auto it = object.find(tokens[depth]);
+            if (it == object.end()) return false;
+            current = &it->second;
+        } else {
+            return false;
+        }
+    }
+    return true;
 }
 
-bool json_pointer::contains_impl(const json_value &current, size_t depth) const
+json_pointer_set::json_pointer_set()
+    : nodes(1)
 {
-    const std::string& segment = tokens[depth];
+}
 
-    const json_value* next = nullptr;
-    if (current.is_array()) {
-        size_t index;
-        try { index = std::stoul(segment); } catch (const std::exception&) {
-            return false;
+json_pointer_set::json_pointer_set(const std::vector<std::string> &pointers)
+    : nodes(1)
+{
+    for (const std::string& pointer : pointers) add(json_pointer(pointer));
+}
+
+size_t json_pointer_set::add(const json_pointer &pointer)
+{
+    const std::vector<std::string>& segments = pointer.segments();
+    size_t current = 0;
+    for (size_t depth = 0; depth < segments.size(); ++depth) {
+        size_t next = 0;
+        for (size_t child : nodes[current].children) {
+            if (nodes[child].key == segments[depth]) { next = child; break; }
         }
-        if (index >= current.array_size())
-            return false;
-        next = &current[index];
-    } else if (current.is_object()) {
-        if (!current.has_key(segment))
-            return false;
-        next = &current[segment];
-    } else {
-        return false;
+        if (next == 0) {
+            next = nodes.size();
+            node n;
+            n.key = segments[depth];
+            n.index = pointer.indices()[depth];
+            nodes.push_back(std::move(n));
+            nodes[current].children.push_back(next);
+        }
+        current = next;
     }
+    nodes[current].targets.push_back(pointer_count);
+    return pointer_count++;
+}
 
-    if (depth == tokens.size() - 1)
-        return true;
-    return contains_impl(*next, depth + 1);
+void json_pointer_set::resolve(const json_value &root, std::vector<const json_value *> &results) const
+{
+    results.assign(pointer_count, nullptr);
+    resolveNode(nodes[0], root, results);
+}
+
+std::vector<const json_value *> json_pointer_set::resolve(const json_value &root) const
+{
+    std::vector<const json_value*> results;
+    resolve(root, results);
+    return results;
+}
+
+void json_pointer_set::resolveNode(const node &n, const json_value &value, std::vector<const json_value *> &results) const
+{
+    for (size_t target : n.targets) results[target] = &value;
+    if (n.children.empty()) return;
+
+    if (value.is_array()) {
+        const json_array& array = value.as_array();
+        for (size_t child : n.children) {
+            const node& c = nodes[child];
+            if (c.index < array.size()) resolveNode(c, array[c.index], results);
+        }
+    } else if (value.is_object()) {
+        const json_object& object = value.as_object();
+        for (size_t child : n.children) {
+            const node& c = nodes[child];
+            auto it = object.find(c.key);
+            if (it != object.end()) resolveNode(c, it->second, results);
+        }
+    }
 }
 
 json_value::json_value(std::nullptr_t) : value(nullptr) {}
@@ -495,14 +572,15 @@ json::json(json_value &&v)
 {
 }
 
-json json::fromString(const std::string &str)
+json json::fromString(const std::string &str, json_parse_mode mode)
 {
     json_parser parser;
+    parser.parseMode = mode;
     parser.parseFromString(str);
     return parser.getResult();
 }
 
-json json::fromFile(const std::filesystem::path& path)
+json json::fromFile(const std::filesystem::path& path, json_parse_mode mode)
 {
     std::ifstream file(path);
     if (!file) {
@@ -510,7 +588,7 @@ json json::fromFile(const std::filesystem::path& path)
     }
     std::stringstream buffer;
     buffer << file.rdbuf();
-    return fromString(buffer.str());
+    return fromString(buffer.str(), mode);
 }
 
 std::string json::toString() const
@@ -532,10 +610,485 @@ std::string json::toFile(const std::filesystem::path& path) const
     if (!file) {
         throw std::runtime_error("Failed to open file for writing: " + path.string());
     }
-    file << toString();
+    json_exporter exporter;
+    json_ostream_sink sink(file);
+    exporter.exportTo(*this, sink);
     return path.string();
 }
 
+/*
+    Structural index (stage 1 of json_parse_mode::structural)
+
+    The input is classified 64 bytes at a time into bitmasks, one bit per byte.
+    Escaped quotes are removed, a prefix xor over the quote bits gives the
+    "inside a string" mask, and what remains outside strings is flattened into
+    a list of offsets: every {}[]:, plus the opening quote of every string and
+    the first byte of every number/true/false/null.
+
+    Classification uses AVX2 or SSE2 when the compiler targets them, and a
+    lookup table anywhere else. Everything after it is plain 64-bit arithmetic.
+*/
+namespace {
+
+struct jblock_masks {
+    uint64_t whitespace = 0;
+    uint64_t op = 0;        // { } [ ] : ,
+    uint64_t quote = 0;
+    uint64_t backslash = 0;
+};
+
+inline bool jis_nesting(char c)
+{
+    // '[' and ']' differ from '{' and '}' only in bit 0x20
+    return c == '"' || (c | 0x20) == '{' || (c | 0x20) == '}';
+}
+
+// bytes the exporter cannot copy as they are
+inline bool jneeds_escape(char c, bool non_ascii)
+{
+    const unsigned char u = static_cast<unsigned char>(c);
+    return u < 0x20 || c == '"' || c == '\\' || (non_ascii && u >= 0x80);
+}
+
+#if defined(SCL2_JSON_AVX2)
+
+inline void jclassify(const char* p, jblock_masks& m)
+{
+    for (int half = 0; half < 2; ++half) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * half));
+        // '{' | 0x20 == '{' == '[' | 0x20, same for the closing pair
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+        // ' ' and \t \n \v \f \r (0x09 - 0x0d), same set as std::isspace
+        __m256i ctl = _mm256_sub_epi8(v, _mm256_set1_epi8(0x09));
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                     _mm256_cmpeq_epi8(_mm256_min_epu8(ctl, _mm256_set1_epi8(4)), ctl));
+        __m256i quote = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+        __m256i backslash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+
+        const int shift = 32 * half;
+        m.op |= uint64_t(uint32_t(_mm256_movemask_epi8(op))) << shift;
+        m.whitespace |= uint64_t(uint32_t(_mm256_movemask_epi8(ws))) << shift;
+        m.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(quote))) << shift;
+        m.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(backslash))) << shift;
+    }
+}
+
+inline const char* jscan_string(const char* p, const char* end)
+{
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t hits = uint32_t(_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')))));
+        if (hits) return p + std::countr_zero(hits);
+        p += 32;
+    }
+    while (p < end && *p != '"' && *p != '\\') ++p;
+    return p;
+}
+
+// next '"', '{', '}', '[' or ']'
+inline const char* jscan_nesting(const char* p, const char* end)
+{
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        uint32_t hits = uint32_t(_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')))));
+        if (hits) return p + std::countr_zero(hits);
+        p += 32;
+    }
+    while (p < end && !jis_nesting(*p)) ++p;
+    return p;
+}
+
+// next byte for which jneeds_escape() is true
+inline const char* jscan_escape(const char* p, const char* end, bool non_ascii)
+{
+    const __m256i high = non_ascii ? _mm256_set1_epi8(char(0x80)) : _mm256_setzero_si256();
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        // unsigned v < 0x20, as a signed compare with the sign bit flipped
+        __m256i ctl = _mm256_cmpgt_epi8(_mm256_set1_epi8(char(0x20 ^ 0x80)), _mm256_xor_si256(v, _mm256_set1_epi8(char(0x80))));
+        uint32_t hits = uint32_t(_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+            _mm256_or_si256(ctl, _mm256_and_si256(v, high)))));
+        if (hits) return p + std::countr_zero(hits);
+        p += 32;
+    }
+    while (p < end && !jneeds_escape(*p, non_ascii)) ++p;
+    return p;
+}
+
+#elif defined(SCL2_JSON_SSE2)
+
+inline void jclassify(const char* p, jblock_masks& m)
+{
+    for (int quarter = 0; quarter < 4; ++quarter) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * quarter));
+        // '{' | 0x20 == '{' == '[' | 0x20, same for the closing pair
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+        // ' ' and \t \n \v \f \r (0x09 - 0x0d), same set as std::isspace
+        __m128i ctl = _mm_sub_epi8(v, _mm_set1_epi8(0x09));
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                  _mm_cmpeq_epi8(_mm_min_epu8(ctl, _mm_set1_epi8(4)), ctl));
+        __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+        __m128i backslash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+
+        const int shift = 16 * quarter;
+        m.op |= uint64_t(uint32_t(_mm_movemask_epi8(op))) << shift;
+        m.whitespace |= uint64_t(uint32_t(_mm_movemask_epi8(ws))) << shift;
+        m.quote |= uint64_t(uint32_t(_mm_movemask_epi8(quote))) << shift;
+        m.backslash |= uint64_t(uint32_t(_mm_movemask_epi8(backslash))) << shift;
+    }
+}
+
+inline const char* jscan_string(const char* p, const char* end)
+{
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t hits = uint32_t(_mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')))));
+        if (hits) return p + std::countr_zero(hits);
+        p += 16;
+    }
+    while (p < end && *p != '"' && *p != '\\') ++p;
+    return p;
+}
+
+// next '"', '{', '}', '[' or ']'
+inline const char* jscan_nesting(const char* p, const char* end)
+{
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        uint32_t hits = uint32_t(_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('"')))));
+        if (hits) return p + std::countr_zero(hits);
+        p += 16;
+    }
+    while (p < end && !jis_nesting(*p)) ++p;
+    return p;
+}
+
+// next byte for which jneeds_escape() is true
+inline const char* jscan_escape(const char* p, const char* end, bool non_ascii)
+{
+    const __m128i high = non_ascii ? _mm_set1_epi8(char(0x80)) : _mm_setzero_si128();
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // unsigned v < 0x20, as a signed compare with the sign bit flipped
+        __m128i ctl = _mm_cmplt_epi8(_mm_xor_si128(v, _mm_set1_epi8(char(0x80))), _mm_set1_epi8(char(0x20 ^ 0x80)));
+        uint32_t hits = uint32_t(_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+            _mm_or_si128(ctl, _mm_and_si128(v, high)))));
+        if (hits) return p + std::countr_zero(hits);
+        p += 16;
+    }
+    while (p < end && !jneeds_escape(*p, non_ascii)) ++p;
+    return p;
+}
+
+#else
+
+// scalar fallback: bit 0 whitespace, bit 1 op, bit 2 quote, bit 3 backslash
+struct jclass_table {
+    uint8_t cls[256] = {};
+    constexpr jclass_table() {
+        for (unsigned char c : {' ', '\t', '\n', '\v', '\f', '\r'}) cls[c] = 1;
+        for (unsigned char c : {'{', '}', '[', ']', ':', ','}) cls[c] = 2;
+        cls[static_cast<unsigned char>('"')] = 4;
+        cls[static_cast<unsigned char>('\\')] = 8;
+    }
+};
+constexpr jclass_table jclasses;
+
+inline void jclassify(const char* p, jblock_masks& m)
+{
+    for (int i = 0; i < 64; ++i) {
+        const uint8_t c = jclasses.cls[static_cast<unsigned char>(p[i])];
+        const uint64_t bit = uint64_t(1) << i;
+        if (c & 1) m.whitespace |= bit;
+        if (c & 2) m.op |= bit;
+        if (c & 4) m.quote |= bit;
+        if (c & 8) m.backslash |= bit;
+    }
+}
+
+inline const char* jscan_string(const char* p, const char* end)
+{
+    while (p < end && *p != '"' && *p != '\\') ++p;
+    return p;
+}
+
+// next '"', '{', '}', '[' or ']'
+inline const char* jscan_nesting(const char* p, const char* end)
+{
+    while (p < end && !jis_nesting(*p)) ++p;
+    return p;
+}
+
+// next byte for which jneeds_escape() is true
+inline const char* jscan_escape(const char* p, const char* end, bool non_ascii)
+{
+    while (p < end && !jneeds_escape(*p, non_ascii)) ++p;
+    return p;
+}
+
+#endif
+
+// Bits of the characters escaped by a backslash run of odd length.
+// prev_escaped carries the state of the last bit into the next block.
+inline uint64_t jfind_escaped(uint64_t backslash, uint64_t& prev_escaped)
+{
+    constexpr uint64_t even_bits = 0x5555555555555555ULL;
+
+    backslash &= ~prev_escaped;
+    uint64_t follows_escape = (backslash << 1) | prev_escaped;
+    uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+
+    uint64_t sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+    prev_escaped = sequences_starting_on_even_bits < odd_sequence_starts ? 1 : 0;
+
+    uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+    return (even_bits ^ invert_mask) & follows_escape;
+}
+
+// Bit i becomes the xor of bits 0..i, which turns quote bits into string ranges.
+inline uint64_t jprefix_xor(uint64_t bits)
+{
+#if defined(__PCLMUL__) && defined(__x86_64__)
+    __m128i all_ones = _mm_set1_epi8(static_cast<char>(0xFF));
+    __m128i result = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(bits)), all_ones, 0);
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(result));
+#else
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+#endif
+}
+
+/*
+    Number scanning. Digits are consumed eight at a time: a 64-bit load is
+    tested for "all ASCII digits" and folded into its value with three
+    multiplications (SWAR), the tail goes one digit at a time.
+*/
+inline uint64_t jload8(const char* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = ((v & 0x00000000FFFFFFFFULL) << 32) | ((v & 0xFFFFFFFF00000000ULL) >> 32);
+    v = ((v & 0x0000FFFF0000FFFFULL) << 16) | ((v & 0xFFFF0000FFFF0000ULL) >> 16);
+    v = ((v & 0x00FF00FF00FF00FFULL) << 8) | ((v & 0xFF00FF00FF00FF00ULL) >> 8);
+#endif
+    return v; // first character in the lowest byte
+}
+
+inline bool jis_eight_digits(uint64_t v)
+{
+    // every byte is 0x30..0x39: high nibble 3, and adding 6 does not carry out of the low nibble
+    return ((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+        == 0x3333333333333333ULL;
+}
+
+inline uint32_t jeight_digits_value(uint64_t v)
+{
+    constexpr uint64_t mask = 0x000000FF000000FFULL;
+    constexpr uint64_t mul1 = 100 + (1000000ULL << 32);
+    constexpr uint64_t mul2 = 1 + (10000ULL << 32);
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8); // pairs of digits
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+    return static_cast<uint32_t>(v);
+}
+
+inline bool jdigit(char c)
+{
+    return static_cast<unsigned>(static_cast<unsigned char>(c) - '0') < 10;
+}
+
+// Skip a run of digits, accumulating their value (wraps after 19 digits).
+inline const char* jscan_digits(const char* p, const char* end, uint64_t& value)
+{
+    while (end - p >= 8) {
+        uint64_t chunk = jload8(p);
+        if (!jis_eight_digits(chunk)) break;
+        value = value * 100000000 + jeight_digits_value(chunk);
+        p += 8;
+    }
+    while (p < end && jdigit(*p)) {
+        value = value * 10 + static_cast<unsigned>(*p - '0');
+        ++p;
+    }
+    return p;
+}
+
+inline const char* jskip_digits(const char* p, const char* end)
+{
+    while (end - p >= 8 && jis_eight_digits(jload8(p))) p += 8;
+    while (p < end && jdigit(*p)) ++p;
+    return p;
+}
+
+} // namespace
+
+bool json_detail::build_structural_index(std::string_view json_str, std::vector<uint32_t>& structural_index)
+{
+    // offsets are stored as 32-bit, leave anything larger to the scalar parser
+    if (json_str.size() > UINT32_MAX) return false;
+
+    structural_index.clear();
+    structural_index.reserve(json_str.size() / 8 + 16);
+
+    uint64_t prev_escaped = 0;
+    uint64_t prev_in_string = 0;
+    uint64_t prev_scalar = 0;
+    char tail[64];
+
+    for (size_t base = 0; base < json_str.size(); base += 64) {
+        const char* block = json_str.data() + base;
+        if (json_str.size() - base < 64) {
+            // pad the last block with whitespace, it never produces an offset
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, json_str.size() - base);
+            block = tail;
+        }
+
+        jblock_masks m;
+        jclassify(block, m);
+
+        uint64_t quote = m.quote & ~jfind_escaped(m.backslash, prev_escaped);
+        uint64_t in_string = jprefix_xor(quote) ^ prev_in_string; // opening quote in, closing quote out
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+        // first byte of every run of scalar characters (numbers, true, false, null)
+        uint64_t scalar = ~(m.op | m.whitespace | m.quote);
+        uint64_t scalar_starts = scalar & ~((scalar << 1) | prev_scalar);
+        prev_scalar = scalar >> 63;
+
+        uint64_t structurals = ((m.op | scalar_starts) & ~in_string) | (quote & in_string);
+
+#ifdef SCL2_JSON_ENABLE_COMMENTS
+        // comments are handled by the scalar parser only
+        if (std::memchr(block, '/', 64)) {
+            for (int i = 0; i < 64; ++i)
+                if (block[i] == '/' && !((in_string >> i) & 1)) return false;
+        }
+#endif
+
+        while (structurals) {
+            structural_index.push_back(static_cast<uint32_t>(base + std::countr_zero(structurals)));
+            structurals &= structurals - 1;
+        }
+    }
+
+    // an unterminated string shows up in stage 2, where the scalar parser would report it too
+    return true;
+}
+
+bool json_parser::buildStructuralIndex()
+{
+    return json_detail::build_structural_index(json_str, structural_index);
+}
+
+char json_parser::nextStructural(const char *error_message)
+{
+    if (index_pos >= structural_index.size()) {
+        pos = json_str.size();
+        throw std::runtime_error(error_message);
+    }
+    pos = structural_index[index_pos++];
+    return json_str[pos];
+}
+
+char json_parser::peekStructural() const
+{
+    if (index_pos < structural_index.size())
+        return json_str[structural_index[index_pos]];
+    return 0;
+}
+
+json_value json_parser::parseIndexedValue()
+{
+    char c = nextStructural("Unexpected end of JSON input");
+    switch (c) {
+    case '{': return parseIndexedObject();
+    case '[': return parseIndexedArray();
+    case '"': return parseString();
+    case 't':
+    case 'f': { json_value v = parseBool(); jatomend(); return v; }
+    case 'n': { json_value v = parseNull(); jatomend(); return v; }
+    default:
+        if (jisdigit(c) || c == '-') {
+            json_value v = parseNumber();
+            jatomend();
+            return v;
+        }
+        throw std::runtime_error(std::string("Unexpected character in JSON input: ") + c);
+    }
+}
+
+json_value json_parser::parseIndexedObject()
+{
+    json_value obj = std::map<std::string, json_value>();
+
+    if (peekStructural() == '}') {
+        ++index_pos; // skip closing brace
+        return obj;
+    }
+
+    while (true) {
+        if (nextStructural("Unexpected end of JSON input while parsing element") != '"')
+            throw std::runtime_error("Expected '\"' at the beginning of JSON element name");
+        std::string name = parseJsonString();
+
+        if (nextStructural("Expected ':' after JSON element name") != ':')
+            throw std::runtime_error("Expected ':' after JSON element name");
+
+        obj.as_object().insert(std::make_pair(std::move(name), parseIndexedValue()));
+
+        char c = nextStructural("Unexpected end of JSON input while parsing object");
+        if (c == ',') continue;
+        if (c == '}') break;
+        throw std::runtime_error(std::string("Expected ',' or '}' in JSON object, but got: ") + c);
+    }
+
+    return obj;
+}
+
+json_value json_parser::parseIndexedArray()
+{
+    json_value arr = std::vector<json_value>();
+
+    if (peekStructural() == ']') {
+        ++index_pos; // skip closing bracket
+        return arr;
+    }
+
+    while (true) {
+        arr.as_array().push_back(parseIndexedValue());
+
+        char c = nextStructural("Unexpected end of JSON input while parsing array");
+        if (c == ',') continue;
+        if (c == ']') break;
+        throw std::runtime_error(std::string("Expected ',' or ']' in JSON array, but got: ") + c);
+    }
+
+    return arr;
+}
+
 void json_parser::parseFromString(const std::string &str_input)
 {
     result_root.clear();
@@ -550,7 +1103,25 @@ void json_parser::parseFromString(const std::string &str_input)
         throw std::runtime_error("Input JSON string is empty");
     }
 
-    result_root = parseJsonValue();
+    bool structural = parseMode == json_parse_mode::structural
+        || (parseMode == json_parse_mode::automatic && json_str.size() >= structural_threshold);
+
+    if (structural && buildStructuralIndex()) {
+        index_pos = 0;
+        result_root = parseIndexedValue();
+        // a container root ends at its closing bracket, the last structural taken
+        pos = std::max<size_t>(pos, structural_index[index_pos - 1] + 1);
+        structural_index.clear(); // keep the capacity for the next document
+    } else {
+        skipWhitespace();
+        result_root = parseJsonValue();
+    }
+
+    // both modes accept whitespace (and comments) after the root value, nothing else
+    skipWhitespace();
+    if (pos < json_str.size()) {
+        throw std::runtime_error(std::string("Unexpected character after JSON value: ") + json_str[pos]);
+    }
 }
 
 json &&json_parser::getResult()
@@ -600,16 +1171,33 @@ char json_parser::peek() const
 }
 
 std::string json_parser::parseJsonString()
+{
+    std::string result;
+    scanJsonString(&result);
+    return result;
+}
+
+void json_parser::skipJsonString()
+{
+    scanJsonString(nullptr);
+}
+
+// decodes into `out`, or with nullptr only checks the string (same errors, no allocation)
+void json_parser::scanJsonString(std::string* out)
 {
     // We should be at the opening quote.
     jexpect('"', "Expected '\"' at the beginning of JSON string");
 
     ++pos; // skip opening quote
 
-    std::string result;
-
     while (pos < json_str.size())
     {
+        // copy everything up to the next quote or backslash at once
+        const char* run_end = jscan_string(json_str.data() + pos, json_str.data() + json_str.size());
+        if (out) out->append(json_str.data() + pos, run_end);
+        pos = static_cast<size_t>(run_end - json_str.data());
+        if (pos >= json_str.size()) break;
+
         char c = json_str[pos];
 
         if (c == '\\')
@@ -621,35 +1209,41 @@ std::string json_parser::parseJsonString()
                 throw std::runtime_error("Unterminated escape sequence in JSON string");
             }
             char escaped = json_str[pos];
+            char simple = 0;
             switch (escaped)
             {
-            case '"':  result += '"';  break;
-            case '\\': result += '\\'; break;
-            case '/':  result += '/';  break;
-            case 'b':  result += '\b'; break;
-            case 'f':  result += '\f'; break;
-            case 'n':  result += '\n'; break;
-            case 'r':  result += '\r'; break;
-            case 't':  result += '\t'; break;
+            case '"':  simple = '"';  break;
+            case '\\': simple = '\\'; break;
+            case '/':  simple = '/';  break;
+            case 'b':  simple = '\b'; break;
+            case 'f':  simple = '\f'; break;
+            case 'n':  simple = '\n'; break;
+            case 'r':  simple = '\r'; break;
+            case 't':  simple = '\t'; break;
             case 'u': {
                 // \uXXXX
                 if (pos + 4 >= json_str.size()) {
                     throw std::runtime_error("Incomplete Unicode escape in JSON string");
                 }
-                std::string hex = json_str.substr(pos + 1, 4);
-                uint32_t codepoint = std::stoul(hex, nullptr, 16);
+                uint32_t codepoint = 0;
+                for (char h : json_str.substr(pos + 1, 4)) {
+                    if (!std::isxdigit(static_cast<unsigned char>(h)))
+                        throw std::runtime_error("Invalid Unicode escape in JSON string");
+                    codepoint = codepoint * 16 + (std::isdigit(static_cast<unsigned char>(h)) ? h - '0' : (h | 0x20) - 'a' + 10);
+                }
+                pos += 4;
+                if (!out) break;
                 // Encode as UTF-8
                 if (codepoint <= 0x7F) {
-                    result += static_cast<char>(codepoint);
+                    *out += static_cast<char>(codepoint);
                 } else if (codepoint <= 0x7FF) {
-                    result += static_cast<char>(0xC0 | (codepoint >> 6));
-                    result += static_cast<char>(0x80 | (codepoint & 0x3F));
+                    *out += static_cast<char>(0xC0 | (codepoint >> 6));
+                    *out += static_cast<char>(0x80 | (codepoint & 0x3F));
                 } else {
-                    result += static_cast<char>(0xE0 | (codepoint >> 12));
-                    result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
-                    result += static_cast<char>(0x80 | (codepoint & 0x3F));
+                    *out += static_cast<char>(0xE0 | (codepoint >> 12));
+                    *out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                    *out += static_cast<char>(0x80 | (codepoint & 0x3F));
                 }
-                pos += 4;
                 break;
             }
 #ifdef SCL2_JSON_ENABLE_EXTENSIONS
@@ -658,8 +1252,9 @@ std::string json_parser::parseJsonString()
                 if (pos + 2 >= json_str.size()) {
                     throw std::runtime_error("Incomplete hex escape in JSON string");
                 }
-                std::string hex = json_str.substr(pos + 1, 2);
-                result += static_cast<char>(std::stoi(hex, nullptr, 16));
+                std::string hex(json_str.substr(pos + 1, 2)); // fits the small buffer, no allocation
+                const char decoded = static_cast<char>(std::stoi(hex, nullptr, 16));
+                if (out) *out += decoded;
                 pos += 2;
                 break;
             }
@@ -667,13 +1262,11 @@ std::string json_parser::parseJsonString()
             default:
                 throw std::runtime_error(std::string("Invalid escape character in JSON string: \\") + escaped);
             }
+            if (simple && out) *out += simple;
         } else if (c == '"') {
             // Unescaped quote - end of string
             ++pos; // skip closing quote
-            return result;
-        } else {
-            // Regular character (including spaces, unicode, etc.)
-            result += c;
+            return;
         }
         ++pos;
     }
@@ -729,6 +1322,7 @@ json_value json_parser::parseObject()
     // We should be at the opening brace.
     jexpect('{', "Expected '{' at the beginning of JSON object");
     ++pos; // skip opening brace
+    skipWhitespace();
 
     if (peek() == '}') {
         ++pos; // skip closing brace
@@ -766,6 +1360,7 @@ json_value json_parser::parseArray()
     // We should be at the opening bracket.
     jexpect('[', "Expected '[' at the beginning of JSON array");
     ++pos; // skip opening bracket
+    skipWhitespace();
 
     if (peek() == ']') {
         ++pos; // skip closing bracket
@@ -821,74 +1416,89 @@ json_value json_parser::parseNumber()
 {
     jinbound();
 
-    bool is_floating = false;
-    size_t start_pos = pos;
+    const char* const begin = json_str.data();
+    const char* const end = begin + json_str.size();
+    const char* const first = begin + pos;
+    const char* p = first;
 
     // Optional minus
-    if (json_str[pos] == '-') {
-        ++pos;
+    const bool negative = *p == '-';
+    if (negative) {
+        ++p;
     }
 
-    jinbound("Invalid JSON number: expected digit");
+    if (p >= end) {
+        throw std::runtime_error("Invalid JSON number: expected digit");
+    }
 
     // Integer part
-    if (json_str[pos] == '0') {
-        ++pos;
+    uint64_t mantissa = 0;
+    const char* const digits = p;
+    if (*p == '0') {
+        ++p;
         // Leading zero is only valid for the number 0 itself.
         // "01", "007" etc. are illegal in JSON.
-        if (pos < json_str.size() && jisdigit(json_str[pos])) {
+        if (p < end && jdigit(*p)) {
             throw std::runtime_error("Invalid JSON number: leading zero is not allowed");
         }
-    } else if (jisdigit(json_str[pos])) {
-        while (pos < json_str.size() && jisdigit(json_str[pos])) {
-            ++pos;
-        }
+    } else if (jdigit(*p)) {
+        p = jscan_digits(p, end, mantissa);
     } else {
         throw std::runtime_error("Invalid JSON number: expected digit");
     }
+    const size_t digit_count = static_cast<size_t>(p - digits);
+    bool is_floating = false;
 
     // Fractional part
-    if (pos < json_str.size() && json_str[pos] == '.') {
+    if (p < end && *p == '.') {
         is_floating = true;
-        ++pos;
-        jinbound("Invalid JSON number: expected digit after decimal point");
-        if (!jisdigit(json_str[pos])) {
+        ++p;
+        if (p >= end || !jdigit(*p)) {
             throw std::runtime_error("Invalid JSON number: expected digit after decimal point");
         }
-        while (pos < json_str.size() && jisdigit(json_str[pos])) {
-            ++pos;
-        }
+        p = jskip_digits(p, end);
     }
 
     // Exponent part
-    if (pos < json_str.size() && (json_str[pos] == 'e' || json_str[pos] == 'E')) {
+    if (p < end && (*p == 'e' || *p == 'E')) {
         is_floating = true;
-        ++pos;
-        jinbound("Invalid JSON number: expected digit in exponent");
-        if (json_str[pos] == '+' || json_str[pos] == '-') {
-            ++pos;
-            jinbound("Invalid JSON number: expected digit in exponent");
+        ++p;
+        if (p < end && (*p == '+' || *p == '-')) {
+            ++p;
         }
-        if (!jisdigit(json_str[pos])) {
+        if (p >= end || !jdigit(*p)) {
             throw std::runtime_error("Invalid JSON number: expected digit in exponent");
         }
-        while (pos < json_str.size() && jisdigit(json_str[pos])) {
-            ++pos;
-        }
+        p = jskip_digits(p, end);
     }
 
-    std::string num_str = json_str.substr(start_pos, pos - start_pos);
+    pos = static_cast<size_t>(p - begin);
 
-    if (is_floating) {
-        return json_value(std::stod(num_str));
-    } else {
-        try {
-            return json_value(static_cast<int64_t>(std::stoll(num_str)));
-        } catch (const std::out_of_range&) {
-            // Integer too large, fall back to double
-            return json_value(std::stod(num_str));
+    // up to 19 digits cannot wrap the accumulator
+    if (!is_floating && digit_count <= 19) {
+        constexpr uint64_t int64_max = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+        if (!negative && mantissa <= int64_max) {
+            return json_value(static_cast<int64_t>(mantissa));
+        }
+        if (negative && mantissa <= int64_max + 1) {
+            return json_value(mantissa == int64_max + 1 ? std::numeric_limits<int64_t>::min()
+                                                        : -static_cast<int64_t>(mantissa));
+        }
+    }
+
+    // floating point, or an integer too large for int64_t (falls back to double)
+    double value = 0;
+    const std::errc ec = std::from_chars(first, p, value).ec;
+    if (ec == std::errc::result_out_of_range) {
+        // underflow rounds towards zero, overflow is an error
+        value = std::strtod(std::string(first, p).c_str(), nullptr);
+        if (std::isinf(value)) {
+            throw std::runtime_error("Invalid JSON number: out of range");
         }
+    } else if (ec != std::errc()) {
+        throw std::runtime_error("Invalid JSON number: out of range");
     }
+    return json_value(value);
 }
 
 std::pair<std::string, json_value> json_parser::getNextObject()
@@ -956,6 +1566,16 @@ bool json_parser::jisdigit(char c) const
     return std::isdigit(static_cast<unsigned char>(c));
 }
 
+void json_parser::jatomend() const
+{
+    // numbers and literals must be followed by whitespace, a structural or the end
+    if (pos >= json_str.size()) return;
+    char c = json_str[pos];
+    if (std::isspace(static_cast<unsigned char>(c))) return;
+    if (c == ',' || c == ':' || c == ']' || c == '}' || c == '[' || c == '{') return;
+    throw std::runtime_error(std::string("Unexpected character after JSON value: ") + c);
+}
+
 json_exporter json_exporter::compact_exporter()
 {
     json_exporter exporter;
@@ -975,17 +1595,32 @@ json_exporter json_exporter::inline_exporter()
 
 std::string json_exporter::exportToString(const json &j)
 {
+    sink = nullptr;
     result_str.clear();
     exportValue(j, 0);
-    return result_str;
+    return std::move(result_str);
 }
 
 std::string json_exporter::exportToCompatString(const json &j)
 {
-    result_str.clear();
     isCompat = true;
-    exportValue(j, 0);
-    return result_str;
+    return exportToString(j);
+}
+
+void json_exporter::exportTo(const json_value &value, json_sink &out)
+{
+    sink = &out;
+    result_str.clear();
+    try {
+        exportValue(value, 0);
+        jflush();
+    } catch (...) {
+        sink = nullptr;
+        result_str.clear();
+        throw;
+    }
+    sink = nullptr;
+    out.flush();
 }
 
 void json_exporter::exportValue(const json_value &value, size_t indentLevel)
@@ -1000,126 +1635,153 @@ void json_exporter::exportValue(const json_value &value, size_t indentLevel)
         case json_value_type::object:  exportObject(value, indentLevel); break;
 #ifdef SCL2_JSON_ENABLE_EXTENSIONS
         case json_value_type::bytearray:
-            result_str += jquote("base64:" + value.as_bytearray().toBase64());
+            jquote("base64:" + value.as_bytearray().toBase64());
             break;
         case json_value_type::data_uri:
-            result_str += jquote(value.as_data_uri().to_string());
+            jquote(value.as_data_uri().to_string());
             break;
 #endif
     }
 }
 
-std::string json_exporter::escapeJsonString(const std::string &str)
+namespace {
+
+// String escaping of json_exporter, also used by json_bind_writer.
+// `write(data, size)` receives the output in pieces, unescaped runs in one piece.
+template<typename Write>
+void jescape_string(std::string_view str, bool escapeNonAscii, Write&& write)
 {
-    std::string escaped;
+    auto escape_u = [&](unsigned code) { // \uXXXX, code <= 0xFFFF
+        static constexpr char hex[] = "0123456789abcdef";
+        const char buf[6] = {'\\', 'u', hex[(code >> 12) & 0xF], hex[(code >> 8) & 0xF], hex[(code >> 4) & 0xF], hex[code & 0xF]};
+        write(buf, sizeof(buf));
+    };
+
     size_t i = 0;
     while (i < str.size()) {
+        // copy the run of bytes that need no escaping in one piece
+        const char* run_end = jscan_escape(str.data() + i, str.data() + str.size(), escapeNonAscii);
+        const size_t run = static_cast<size_t>(run_end - (str.data() + i));
+        if (run != 0) {
+            write(str.data() + i, run);
+            i += run;
+            if (i == str.size()) break;
+        }
+
         unsigned char c = static_cast<unsigned char>(str[i]);
 
         // Handle standard JSON escapes
         switch (c) {
-            case '"':  escaped += "\\\""; ++i; continue;
-            case '\\': escaped += "\\\\"; ++i; continue;
-            case '\b': escaped += "\\b";  ++i; continue;
-            case '\f': escaped += "\\f";  ++i; continue;
-            case '\n': escaped += "\\n";  ++i; continue;
-            case '\r': escaped += "\\r";  ++i; continue;
-            case '\t': escaped += "\\t";  ++i; continue;
+            case '"':  write("\\\"", 2); ++i; continue;
+            case '\\': write("\\\\", 2); ++i; continue;
+            case '\b': write("\\b", 2);  ++i; continue;
+            case '\f': write("\\f", 2);  ++i; continue;
+            case '\n': write("\\n", 2);  ++i; continue;
+            case '\r': write("\\r", 2);  ++i; continue;
+            case '\t': write("\\t", 2);  ++i; continue;
         }
 
         // Control characters -> \uXXXX
         if (c < 0x20) {
-            char buf[7];
-            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
-            escaped += buf;
+            escape_u(c);
             ++i;
             continue;
         }
 
-        // ASCII printable -> pass through
-        if (c < 0x80) {
-            escaped += static_cast<char>(c);
-            ++i;
-            continue;
-        }
-
-        // Non-ASCII byte -> either escape as \uXXXX or pass through as UTF-8
-        if (escapeNonAscii) {
-            // Decode UTF-8 sequence and emit \uXXXX (or \uXXXX\uXXXX for surrogates)
-            auto decode_utf8 = [&](size_t& pos) -> int {
-                unsigned char b = static_cast<unsigned char>(str[pos]);
-                int cp, extra;
-                if      ((b & 0xE0) == 0xC0) { cp = b & 0x1F; extra = 1; }
-                else if ((b & 0xF0) == 0xE0) { cp = b & 0x0F; extra = 2; }
-                else if ((b & 0xF8) == 0xF0) { cp = b & 0x07; extra = 3; }
-                else { return -1; } // invalid byte - escape as-is
-                for (int j = 0; j < extra; ++j) {
-                    ++pos;
-                    if (pos >= str.size()) return -1;
-                    unsigned char nb = static_cast<unsigned char>(str[pos]);
-                    if ((nb & 0xC0) != 0x80) return -1;
-                    cp = (cp << 6) | (nb & 0x3F);
-                }
-                return cp;
-            };
-            int cp = decode_utf8(i);
-            if (cp >= 0) {
-                if (cp > 0xFFFF) {
-                    // Surrogate pair for code points > U+FFFF
-                    cp -= 0x10000;
-                    char buf[13];
-                    std::snprintf(buf, sizeof(buf), "\\u%04x\\u%04x",
-                                  0xD800 | (cp >> 10), 0xDC00 | (cp & 0x3FF));
-                    escaped += buf;
-                } else {
-                    char buf[7];
-                    std::snprintf(buf, sizeof(buf), "\\u%04x", cp);
-                    escaped += buf;
-                }
-                ++i; // decode_utf8 advanced i to the last byte
+        // Only reached for non-ASCII bytes with escapeNonAscii set:
+        // decode the UTF-8 sequence and emit \uXXXX (or \uXXXX\uXXXX for surrogates)
+        auto decode_utf8 = [&](size_t& pos) -> int {
+            unsigned char b = static_cast<unsigned char>(str[pos]);
+            int cp, extra;
+            if      ((b & 0xE0) == 0xC0) { cp = b & 0x1F; extra = 1; }
+            else if ((b & 0xF0) == 0xE0) { cp = b & 0x0F; extra = 2; }
+            else if ((b & 0xF8) == 0xF0) { cp = b & 0x07; extra = 3; }
+            else { return -1; } // invalid byte - escape as-is
+            for (int j = 0; j < extra; ++j) {
+                ++pos;
+                if (pos >= str.size()) return -1;
+                unsigned char nb = static_cast<unsigned char>(str[pos]);
+                if ((nb & 0xC0) != 0x80) return -1;
+                cp = (cp << 6) | (nb & 0x3F);
+            }
+            return cp;
+        };
+        size_t next = i;
+        int cp = decode_utf8(next);
+        if (cp >= 0) {
+            if (cp > 0xFFFF) {
+                // Surrogate pair for code points > U+FFFF
+                cp -= 0x10000;
+                escape_u(0xD800 | (cp >> 10));
+                escape_u(0xDC00 | (cp & 0x3FF));
             } else {
-                // Invalid UTF-8 - escape the single byte
-                char buf[7];
-                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
-                escaped += buf;
+                escape_u(static_cast<unsigned>(cp));
             }
-            ++i;
+            i = next + 1; // decode_utf8 advanced to the last byte
         } else {
-            // Pass through UTF-8 bytes unchanged
-            escaped += static_cast<char>(c);
+            // Invalid UTF-8 - escape the single byte
+            escape_u(c);
             ++i;
         }
     }
-    return escaped;
+}
+
+// Shortest text that reads back as the same double, ".0" appended to integral values so they
+// stay floating point. `buf` needs 32 bytes. Returns "null" for NaN and infinity (not JSON).
+std::string_view jformat_double(double d, char* buf)
+{
+    if (!std::isfinite(d)) return "null";
+    auto [end, ec] = std::to_chars(buf, buf + 30, d);
+    if (std::find_if(buf, end, [](char c) { return c == '.' || c == 'e'; }) == end) {
+        *end++ = '.';
+        *end++ = '0';
+    }
+    return std::string_view(buf, static_cast<size_t>(end - buf));
+}
+
+} // namespace
+
+void json_exporter::escapeJsonString(std::string_view str)
+{
+    jescape_string(str, escapeNonAscii, [this](const char* data, size_t size) { jwrite(data, size); });
+}
+
+void json_exporter::appendEscaped(std::string& out, std::string_view str, bool escapeNonAscii)
+{
+    jescape_string(str, escapeNonAscii, [&out](const char* data, size_t size) { out.append(data, size); });
+}
+
+void json_exporter::appendDouble(std::string& out, double d)
+{
+    char buf[32];
+    out += jformat_double(d, buf);
 }
 
 void json_exporter::exportKey(const std::string &value, size_t indentLevel)
 {
     jindent(indentLevel);
-    result_str += std::string(
-        jquote(escapeJsonString(value)) +
-        (isCompat ? ":" : ": ")
-    );
+    jquote(value);
+    jwrite(isCompat ? std::string_view(":") : std::string_view(": "));
 }
 
 void json_exporter::exportNull(const json_value& value, size_t indentLevel)
 {
     (void)indentLevel;
-    result_str += "null";
+    jwrite("null", 4);
 }
 
 void json_exporter::exportBool(const json_value& value, size_t indentLevel)
 {
     (void)indentLevel;
-    result_str += value.as_bool() ? "true" : "false";
+    jwrite(value.as_bool() ? std::string_view("true") : std::string_view("false"));
 }
 
 void json_exporter::exportObject(const json_value& value, size_t indentLevel)
 {
-    result_str += "{";
+    jput('{');
 
     if (value.as_object().empty()) {
-        result_str += "}";
+        jput('}');
         return;
     }
 
@@ -1132,20 +1794,20 @@ void json_exporter::exportObject(const json_value& value, size_t indentLevel)
         // Empty arrays/objects stay compact: "key": []
 
         exportValue(it->second, indentLevel + 1);
-        if (std::next(it) != value.as_object().end()) result_str += ",";
+        if (std::next(it) != value.as_object().end()) jput(',');
         jnline();
     }
 
     jindent(indentLevel);
-    result_str += "}";
+    jput('}');
 }
 
 void json_exporter::exportArray(const json_value& value, size_t indentLevel)
 {
-    result_str += "[";
+    jput('[');
 
     if (value.as_array().empty()) {
-        result_str += "]";
+        jput(']');
         return;
     }
 
@@ -1154,59 +1816,408 @@ void json_exporter::exportArray(const json_value& value, size_t indentLevel)
     for (size_t i = 0; i < value.as_array().size(); ++i) {
         jindent(indentLevel + 1);
         exportValue(value.as_array()[i], indentLevel + 1);
-        if (i != value.as_array().size() - 1) result_str += ",";
+        if (i != value.as_array().size() - 1) jput(',');
         jnline();
     }
 
     jindent(indentLevel);
-    result_str += "]";
+    jput(']');
 }
 
 void json_exporter::exportString(const json_value& value, size_t indentLevel)
 {
     (void)indentLevel;
-    result_str += jquote(escapeJsonString(value.as_string()));
+    jquote(value.as_string());
 }
 
 void json_exporter::exportNumber(const json_value &value, size_t indentLevel)
 {
     (void)indentLevel;
     if (value.is_int()) {
-        result_str += std::to_string(value.as_int());
+        char buf[24];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value.as_int());
+        jwrite(buf, static_cast<size_t>(end - buf));
     } else {
-        result_str += std::to_string(value.as_double());
+        char buf[32];
+        jwrite(jformat_double(value.as_double(), buf));
     }
 }
 
 void json_exporter::jindent(size_t indentLevel)
 {
     if (isCompat || isInline) return;
-    result_str += [this, indentLevel]() {
-        switch (indentStyle) {
-            case indent_style::none:
-                return std::string();
-            case indent_style::space2:
-                return std::string(indentLevel * 2, ' ');
-            case indent_style::space4:
-                return std::string(indentLevel * 4, ' ');
-            case indent_style::tab:
-                return std::string(indentLevel, '\t');
-            default:
-                throw std::runtime_error("Invalid indent style");
-        }
-    }();
+    switch (indentStyle) {
+        case indent_style::none:
+            return;
+        case indent_style::space2:
+            result_str.append(indentLevel * 2, ' ');
+            break;
+        case indent_style::space4:
+            result_str.append(indentLevel * 4, ' ');
+            break;
+        case indent_style::tab:
+            result_str.append(indentLevel, '\t');
+            break;
+        default:
+            throw std::runtime_error("Invalid indent style");
+    }
+    if (sink && result_str.size() >= sink_chunk_size) jflush();
 }
 
 void json_exporter::jnline()
 {
     if (isCompat) return;
-    if (isInline) { result_str += " "; return; }
-    result_str += "\n";
+    jput(isInline ? ' ' : '\n');
+}
+
+void json_exporter::jquote(std::string_view str)
+{
+    jput('"');
+    escapeJsonString(str);
+    jput('"');
+}
+
+void json_exporter::jwrite(const char *data, size_t size)
+{
+    if (sink && size >= sink_chunk_size) {
+        // large runs (long strings) go to the sink without passing through the buffer
+        jflush();
+        sink->write(data, size);
+        return;
+    }
+    result_str.append(data, size);
+    if (sink && result_str.size() >= sink_chunk_size) jflush();
+}
+
+void json_exporter::jput(char c)
+{
+    result_str += c;
+    if (sink && result_str.size() >= sink_chunk_size) jflush();
+}
+
+void json_exporter::jflush()
+{
+    if (!sink || result_str.empty()) return;
+    sink->write(result_str.data(), result_str.size());
+    result_str.clear();
+}
+
+json_cursor::json_cursor(std::string_view text)
+    : text(text)
+{
+    size_t p = skipWhitespace(0);
+    pos = p < text.size() ? p : npos;
 }
 
-std::string json_exporter::jquote(const std::string &str)
+json_value_type json_cursor::type() const
 {
-    return std::string("\"" + escapeJsonString(str) + "\"");
+    if (!valid()) throw std::runtime_error("json_cursor: invalid cursor");
+
+    char c = text[pos];
+    switch (c) {
+    case '{': return json_value_type::object;
+    case '[': return json_value_type::array;
+    case '"': return json_value_type::string;
+    case 't':
+    case 'f': return json_value_type::boolean;
+    case 'n': return json_value_type::null;
+    default:
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '-') {
+            // floating if it has a fraction or exponent, or does not fit int64_t (like json_parser)
+            std::string_view num = raw();
+            if (num.find_first_of(".eE") != std::string_view::npos) return json_value_type::floating;
+            int64_t i;
+            auto [ptr, ec] = std::from_chars(num.data(), num.data() + num.size(), i);
+            return ec == std::errc() ? json_value_type::integer : json_value_type::floating;
+        }
+        throw std::runtime_error(std::string("Unexpected character in JSON input: ") + c);
+    }
+}
+
+bool json_cursor::as_bool() const
+{
+    jexpect(json_value_type::boolean, "json_cursor::as_bool: not a boolean");
+    return to_value().as_bool();
+}
+
+int64_t json_cursor::as_int() const
+{
+    jexpect(json_value_type::integer, "json_cursor::as_int: not an integer");
+    return to_value().as_int();
+}
+
+double json_cursor::as_double() const
+{
+    json_value v = to_value();
+    if (v.is_double()) return v.as_double();
+    if (v.is_int()) return static_cast<double>(v.as_int());
+    throw std::runtime_error("json_cursor::as_double: not a number");
+}
+
+std::string json_cursor::as_string() const
+{
+    jexpect(json_value_type::string, "json_cursor::as_string: not a string");
+    return decodeString(pos);
+}
+
+json_value json_cursor::to_value() const
+{
+    if (!valid()) throw std::runtime_error("json_cursor: invalid cursor");
+
+    // parse just this subtree
+    json_parser parser;
+    parser.json_str = text;
+    parser.pos = pos;
+    return parser.parseJsonValue();
+}
+
+std::string_view json_cursor::raw() const
+{
+    if (!valid()) return {};
+    return text.substr(pos, skipValue(pos) - pos);
+}
+
+json_cursor json_cursor::find(std::string_view key) const
+{
+    jexpect(json_value_type::object, "json_cursor::find: not an object");
+
+    for (size_t p = firstItem('}'); p != npos; ) {
+        if (text[p] != '"')
+            throw std::runtime_error("Expected '\"' at the beginning of JSON element name");
+        size_t key_end = skipString(p);
+
+        size_t colon = skipWhitespace(key_end);
+        if (colon >= text.size() || text[colon] != ':')
+            throw std::runtime_error("Expected ':' after JSON element name");
+
+        size_t value = skipWhitespace(colon + 1);
+        if (value >= text.size())
+            throw std::runtime_error("Unexpected end of JSON input while parsing object");
+
+        if (keyEquals(p, key_end, key)) return json_cursor(text, value);
+        p = nextItem(skipValue(value), '}');
+    }
+    return json_cursor();
+}
+
+json_cursor json_cursor::operator[](std::string_view key) const
+{
+    json_cursor c = find(key);
+    if (!c) throw std::runtime_error("json_cursor::operator[]: object key not found: " + std::string(key));
+    return c;
+}
+
+json_cursor json_cursor::at(size_t index) const
+{
+    jexpect(json_value_type::array, "json_cursor::at: not an array");
+
+    size_t i = 0;
+    for (size_t p = firstItem(']'); p != npos; p = nextItem(skipValue(p), ']')) {
+        if (i++ == index) return json_cursor(text, p);
+    }
+    return json_cursor();
+}
+
+json_cursor json_cursor::operator[](size_t index) const
+{
+    json_cursor c = at(index);
+    if (!c) throw std::runtime_error("json_cursor::operator[]: array index out of bounds: " + std::to_string(index));
+    return c;
+}
+
+json_cursor json_cursor::at_path(const json_pointer &pointer) const
+{
+    return pointer.apply(*this);
+}
+
+size_t json_cursor::size() const
+{
+    size_t count = 0;
+    switch (type()) {
+    case json_value_type::array:
+        for (size_t p = firstItem(']'); p != npos; p = nextItem(skipValue(p), ']')) ++count;
+        return count;
+    case json_value_type::object:
+        for (size_t p = firstItem('}'); p != npos; ) {
+            size_t colon = skipWhitespace(skipString(p));
+            if (colon >= text.size() || text[colon] != ':')
+                throw std::runtime_error("Expected ':' after JSON element name");
+            p = nextItem(skipValue(skipWhitespace(colon + 1)), '}');
+            ++count;
+        }
+        return count;
+    case json_value_type::string:
+        return skipString(pos) - pos - 2; // between the quotes, escapes not decoded
+    default:
+        return 0;
+    }
+}
+
+#ifdef __cpp_lib_generator
+std::generator<json_cursor> json_cursor::array_elements() const
+{
+    jexpect(json_value_type::array, "json_cursor::array_elements: not an array");
+    for (size_t p = firstItem(']'); p != npos; p = nextItem(skipValue(p), ']'))
+        co_yield json_cursor(text, p);
+}
+
+std::generator<std::pair<std::string, json_cursor>> json_cursor::object_members() const
+{
+    jexpect(json_value_type::object, "json_cursor::object_members: not an object");
+    for (size_t p = firstItem('}'); p != npos; ) {
+        size_t colon = skipWhitespace(skipString(p));
+        if (colon >= text.size() || text[colon] != ':')
+            throw std::runtime_error("Expected ':' after JSON element name");
+        size_t value = skipWhitespace(colon + 1);
+        co_yield std::make_pair(decodeString(p), json_cursor(text, value));
+        p = nextItem(skipValue(value), '}');
+    }
+}
+#endif
+
+void json_cursor::jexpect(json_value_type expected, const char *error_message) const
+{
+    if (type() != expected) throw std::runtime_error(error_message);
+}
+
+size_t json_cursor::skipWhitespace(size_t p) const
+{
+    while (p < text.size() && std::isspace(static_cast<unsigned char>(text[p]))) ++p;
+    return p;
+}
+
+size_t json_cursor::skipString(size_t p) const
+{
+    const char* data = text.data();
+    const char* end = data + text.size();
+    const char* q = data + p + 1;
+    while (true) {
+        q = jscan_string(q, end);
+        if (q >= end) throw std::runtime_error("Unterminated JSON string");
+        if (*q == '"') return static_cast<size_t>(q - data) + 1;
+        if (end - q < 2) throw std::runtime_error("Unterminated JSON string"); // backslash at the end
+        q += 2; // backslash and the escaped character
+    }
+}
+
+size_t json_cursor::skipValue(size_t p) const
+{
+    if (p >= text.size()) throw std::runtime_error("Unexpected end of JSON input");
+
+    char c = text[p];
+    if (c == '"') return skipString(p);
+
+    if (c == '{' || c == '[') {
+        // bracket matching, strings are skipped as a whole
+        const char* data = text.data();
+        const char* end = data + text.size();
+        const char* q = data + p;
+        std::string closers; // expected closing brackets, innermost last
+        while ((q = jscan_nesting(q, end)) < end) {
+            if (*q == '"') {
+                q = data + skipString(static_cast<size_t>(q - data));
+                continue;
+            }
+            if (*q == '{' || *q == '[') {
+                closers.push_back(*q == '{' ? '}' : ']');
+            } else {
+                if (*q != closers.back())
+                    throw std::runtime_error(std::string("Mismatched bracket in JSON input: ") + *q);
+                closers.pop_back();
+                if (closers.empty()) return static_cast<size_t>(q - data) + 1;
+            }
+            ++q;
+        }
+        throw std::runtime_error("Unexpected end of JSON input");
+    }
+
+    // number or literal, up to the next delimiter
+    size_t end = p;
+    while (end < text.size()) {
+        char e = text[end];
+        if (std::isspace(static_cast<unsigned char>(e)) || e == ',' || e == ':' || e == ']' || e == '}'
+            || e == '[' || e == '{' || e == '"') break;
+        ++end;
+    }
+    if (end == p) throw std::runtime_error(std::string("Unexpected character in JSON input: ") + c);
+    return end;
+}
+
+size_t json_cursor::firstItem(char close) const
+{
+    size_t p = skipWhitespace(pos + 1);
+    if (p >= text.size()) throw std::runtime_error("Unexpected end of JSON input");
+    return text[p] == close ? npos : p;
+}
+
+size_t json_cursor::nextItem(size_t value_end, char close) const
+{
+    size_t p = skipWhitespace(value_end);
+    if (p >= text.size()) throw std::runtime_error("Unexpected end of JSON input");
+    if (text[p] == ',') {
+        p = skipWhitespace(p + 1);
+        if (p >= text.size()) throw std::runtime_error("Unexpected end of JSON input");
+        return p;
+    }
+    if (text[p] == close) return npos;
+    throw std::runtime_error(close == '}'
+        ? std::string("Expected ',' or '}' in JSON object, but got: ") + text[p]
+        : std::string("Expected ',' or ']' in JSON array, but got: ") + text[p]);
+}
+
+bool json_cursor::keyEquals(size_t quote, size_t end, std::string_view key) const
+{
+    std::string_view raw_key = text.substr(quote + 1, end - quote - 2);
+    if (raw_key.find('\\') == std::string_view::npos) return raw_key == key;
+    return decodeString(quote) == key;
+}
+
+std::string json_cursor::decodeString(size_t quote) const
+{
+    json_parser parser;
+    parser.json_str = text;
+    parser.pos = quote;
+    return parser.parseJsonString();
+}
+
+json_cursor json_pointer::apply(const json_cursor &root) const
+{
+    json_cursor current = root;
+    for (size_t depth = 0; depth < tokens.size(); ++depth) {
+        const std::string& segment = tokens[depth];
+        if (current.is_array()) {
+            const size_t index = token_indices[depth];
+            if (index == npos || index == index_overflow)
+                throw std::runtime_error("json_pointer::apply: invalid array index: " + segment);
+            json_cursor next = current.at(index);
+            if (!next) throw std::runtime_error("json_pointer::apply: array index out of bounds: " + segment);
+            current = next;
+        } else if (current.is_object()) {
+            json_cursor next = current.find(segment);
+            if (!next) throw std::runtime_error("json_pointer::apply: object key not found: " + segment);
+            current = next;
+        } else {
+            throw std::runtime_error("json_pointer::apply: cannot apply pointer to scalar value");
+        }
+    }
+    return current;
+}
+
+bool json_pointer::contains(const json_cursor &root) const
+{
+    json_cursor current = root;
+    for (size_t depth = 0; depth < tokens.size(); ++depth) {
+        if (current.is_array()) {
+            if (token_indices[depth] == npos) return false;
+            current = current.at(token_indices[depth]);
+        } else if (current.is_object()) {
+            current = current.find(tokens[depth]);
+        } else {
+            return false;
+        }
+        if (!current) return false;
+    }
+    return true;
 }
 
 std::string json_value::json_wtoa(const std::wstring& ws) {
@@ -0,0 +1,316 @@
+/*
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: json
+*/
+#include "json_binding.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace scl2 {
+
+json_bind_reader::json_bind_reader(std::string_view text)
+{
+    parser.json_str = text;
+    parser.pos = 0;
+}
+
+char json_bind_reader::peekToken()
+{
+    parser.skipWhitespace();
+    if (parser.pos >= parser.json_str.size())
+        throw std::runtime_error("Unexpected end of JSON input");
+    return parser.json_str[parser.pos];
+}
+
+bool json_bind_reader::readNull()
+{
+    if (peekToken() != 'n') return false;
+    parser.parseNull();
+    parser.jatomend();
+    return true;
+}
+
+bool json_bind_reader::readBool()
+{
+    const char c = peekToken();
+    if (c != 't' && c != 'f') throw std::runtime_error("Invalid JSON boolean value");
+    const bool value = parser.parseBool().as_bool();
+    parser.jatomend();
+    return value;
+}
+
+size_t json_bind_reader::numberEnd(bool& integer) const
+{
+    // same grammar and messages as json_parser::parseNumber
+    const std::string_view s = parser.json_str;
+    size_t i = parser.pos;
+    integer = true;
+
+    if (s[i] == '-') ++i;
+    if (i >= s.size() || !std::isdigit(static_cast<unsigned char>(s[i])))
+        throw std::runtime_error("Invalid JSON number: expected digit");
+    if (s[i] == '0') {
+        ++i;
+        if (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i])))
+            throw std::runtime_error("Invalid JSON number: leading zero is not allowed");
+    } else {
+        while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) ++i;
+    }
+
+    if (i < s.size() && s[i] == '.') {
+        integer = false;
+        ++i;
+        if (i >= s.size() || !std::isdigit(static_cast<unsigned char>(s[i])))
+            throw std::runtime_error("Invalid JSON number: expected digit after decimal point");
+        while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) ++i;
+    }
+
+    if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+        integer = false;
+        ++i;
+        if (i < s.size() && (s[i] == '+' || s[i] == '-')) ++i;
+        if (i >= s.size() || !std::isdigit(static_cast<unsigned char>(s[i])))
+            throw std::runtime_error("Invalid JSON number: expected digit in exponent");
+        while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) ++i;
+    }
+    return i;
+}
+
+int64_t json_bind_reader::readInt()
+{
+    const char c = peekToken();
+    if (c != '-' && !std::isdigit(static_cast<unsigned char>(c)))
+        throw std::runtime_error(std::string("Expected a JSON integer, but got: ") + c);
+
+    bool integer = false;
+    const size_t end = numberEnd(integer);
+    if (!integer) throw std::runtime_error("Expected a JSON integer, but got a floating point number");
+
+    int64_t value = 0;
+    const char* first = parser.json_str.data() + parser.pos;
+    auto [ptr, ec] = std::from_chars(first, parser.json_str.data() + end, value);
+    if (ec != std::errc()) throw std::runtime_error("Invalid JSON number: out of range");
+    parser.pos = end;
+    parser.jatomend();
+    return value;
+}
+
+uint64_t json_bind_reader::readUInt()
+{
+    const char c = peekToken();
+    if (c == '-') {
+        readInt(); // validates the number
+        throw std::runtime_error("Invalid JSON number: out of range");
+    }
+    if (!std::isdigit(static_cast<unsigned char>(c)))
+        throw std::runtime_error(std::string("Expected a JSON integer, but got: ") + c);
+
+    bool integer = false;
+    const size_t end = numberEnd(integer);
+    if (!integer) throw std::runtime_error("Expected a JSON integer, but got a floating point number");
+
+    uint64_t value = 0;
+    const char* first = parser.json_str.data() + parser.pos;
+    auto [ptr, ec] = std::from_chars(first, parser.json_str.data() + end, value);
+    if (ec != std::errc()) throw std::runtime_error("Invalid JSON number: out of range");
+    parser.pos = end;
+    parser.jatomend();
+    return value;
+}
+
+double json_bind_reader::readDouble()
+{
+    const char c = peekToken();
+    if (c != '-' && !std::isdigit(static_cast<unsigned char>(c)))
+        throw std::runtime_error(std::string("Expected a JSON number, but got: ") + c);
+
+    bool integer = false;
+    const size_t end = numberEnd(integer);
+
+    double value = 0;
+    const char* first = parser.json_str.data() + parser.pos;
+    auto [ptr, ec] = std::from_chars(first, parser.json_str.data() + end, value);
+    if (ec == std::errc::result_out_of_range) {
+        // like std::stod in json_parser: overflow is an error, underflow is not
+        value = std::strtod(std::string(first, parser.json_str.data() + end).c_str(), nullptr);
+        if (std::isinf(value)) throw std::runtime_error("Invalid JSON number: out of range");
+    } else if (ec != std::errc()) {
+        throw std::runtime_error("Invalid JSON number: out of range");
+    }
+    parser.pos = end;
+    parser.jatomend();
+    return value;
+}
+
+void json_bind_reader::readString(std::string& out)
+{
+    if (peekToken() != '"')
+        throw std::runtime_error(std::string("Expected a JSON string, but got: ") + parser.json_str[parser.pos]);
+    out = parser.parseJsonString();
+}
+
+std::string_view json_bind_reader::readKey(std::string& scratch)
+{
+    if (peekToken() != '"')
+        throw std::runtime_error("Expected '\"' at the beginning of JSON element name");
+
+    const std::string_view s = parser.json_str;
+    const size_t begin = parser.pos + 1;
+    const char* quote = static_cast<const char*>(std::memchr(s.data() + begin, '"', s.size() - begin));
+    std::string_view key;
+
+    if (quote && !std::memchr(s.data() + begin, '\\', quote - (s.data() + begin))) {
+        key = s.substr(begin, quote - (s.data() + begin));
+        parser.pos = static_cast<size_t>(quote + 1 - s.data());
+    } else {
+        scratch = parser.parseJsonString();
+        key = scratch;
+    }
+
+    if (peekToken() != ':') throw std::runtime_error("Expected ':' after JSON element name");
+    ++parser.pos;
+    return key;
+}
+
+bool json_bind_reader::beginObject()
+{
+    const char c = peekToken();
+    if (c != '{') throw std::runtime_error(std::string("Expected a JSON object, but got: ") + c);
+    ++parser.pos;
+    if (peekToken() == '}') {
+        ++parser.pos;
+        return false;
+    }
+    return true;
+}
+
+bool json_bind_reader::nextMember()
+{
+    const char c = peekToken();
+    ++parser.pos;
+    if (c == ',') return true;
+    if (c == '}') return false;
+    throw std::runtime_error(std::string("Expected ',' or '}' in JSON object, but got: ") + c);
+}
+
+bool json_bind_reader::beginArray()
+{
+    const char c = peekToken();
+    if (c != '[') throw std::runtime_error(std::string("Expected a JSON array, but got: ") + c);
+    ++parser.pos;
+    if (peekToken() == ']') {
+        ++parser.pos;
+        return false;
+    }
+    return true;
+}
+
+bool json_bind_reader::nextElement()
+{
+    const char c = peekToken();
+    ++parser.pos;
+    if (c == ',') return true;
+    if (c == ']') return false;
+    throw std::runtime_error(std::string("Expected ',' or ']' in JSON array, but got: ") + c);
+}
+
+void json_bind_reader::skipValue()
+{
+    // validated like a parse (strings and keys get the parser's escape checks),
+    // but nothing is decoded or allocated
+    switch (peekToken()) {
+    case '{':
+        if (beginObject()) {
+            do {
+                if (peekToken() != '"')
+                    throw std::runtime_error("Expected '\"' at the beginning of JSON element name");
+                parser.skipJsonString();
+                if (peekToken() != ':') throw std::runtime_error("Expected ':' after JSON element name");
+                ++parser.pos;
+                skipValue();
+            } while (nextMember());
+        }
+        return;
+    case '[':
+        if (beginArray()) {
+            do {
+                skipValue();
+            } while (nextElement());
+        }
+        return;
+    case '"':
+        parser.skipJsonString();
+        return;
+    case 't':
+    case 'f':
+        readBool();
+        return;
+    case 'n':
+        readNull();
+        return;
+    default: {
+        const char c = parser.json_str[parser.pos];
+        if (c != '-' && !std::isdigit(static_cast<unsigned char>(c)))
+            throw std::runtime_error(std::string("Unexpected character in JSON input: ") + c);
+        bool integer = false;
+        parser.pos = numberEnd(integer);
+        parser.jatomend();
+        return;
+    }
+    }
+}
+
+json_value json_bind_reader::readValue()
+{
+    peekToken();
+    json_value value = parser.parseJsonValue();
+    parser.jatomend();
+    return value;
+}
+
+void json_bind_reader::finish()
+{
+    parser.skipWhitespace();
+    if (parser.pos < parser.json_str.size())
+        throw std::runtime_error(std::string("Unexpected character after JSON value: ") + parser.json_str[parser.pos]);
+}
+
+void json_bind_writer::writeInt(int64_t i)
+{
+    char buf[24];
+    auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), i);
+    out.append(buf, ptr);
+}
+
+void json_bind_writer::writeUInt(uint64_t u)
+{
+    char buf[24];
+    auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), u);
+    out.append(buf, ptr);
+}
+
+void json_bind_writer::writeDouble(double d)
+{
+    json_exporter::appendDouble(out, d);
+}
+
+void json_bind_writer::writeString(std::string_view str)
+{
+    out += '"';
+    json_exporter::appendEscaped(out, str);
+    out += '"';
+}
+
+void json_bind_writer::writeValue(const json_value& value)
+{
+    json_string_sink sink(out);
+    json_exporter::compact_exporter().exportTo(value, sink);
+}
+
+} // namespace scl2
@@ -0,0 +1,602 @@
+/*
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.1
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: json
+*/
+#include "json_document.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace scl2 {
+
+json_arena::json_arena(size_t block_size)
+    : block_size_(block_size)
+{
+}
+
+json_arena::json_arena(json_arena &&other) noexcept
+    : blocks_(std::move(other.blocks_)),
+      cur_(std::exchange(other.cur_, nullptr)),
+      left_(std::exchange(other.left_, 0)),
+      block_size_(other.block_size_),
+      used_(std::exchange(other.used_, 0)),
+      reserved_(std::exchange(other.reserved_, 0))
+{
+    other.blocks_.clear();
+}
+
+json_arena &json_arena::operator=(json_arena &&other) noexcept
+{
+    if (this != &other) {
+        blocks_ = std::move(other.blocks_);
+        other.blocks_.clear();
+        cur_ = std::exchange(other.cur_, nullptr);
+        left_ = std::exchange(other.left_, 0);
+        block_size_ = other.block_size_;
+        used_ = std::exchange(other.used_, 0);
+        reserved_ = std::exchange(other.reserved_, 0);
+    }
+    return *this;
+}
+
+void *json_arena::allocate(size_t size, size_t align)
+{
+    size_t pad = (align - reinterpret_cast<uintptr_t>(cur_) % align) % align;
+    if (pad + size > left_) {
+        grow(size + align);
+        pad = (align - reinterpret_cast<uintptr_t>(cur_) % align) % align;
+    }
+    std::byte* p = cur_ + pad;
+    cur_ = p + size;
+    left_ -= pad + size;
+    used_ += size;
+    return p;
+}
+
+std::string_view json_arena::store(std::string_view str)
+{
+    if (str.empty()) return {};
+    char* p = static_cast<char*>(allocate(str.size(), 1));
+    std::memcpy(p, str.data(), str.size());
+    return std::string_view(p, str.size());
+}
+
+void json_arena::reserve(size_t size)
+{
+    if (left_ < size) grow(size);
+}
+
+void json_arena::release()
+{
+    blocks_.clear();
+    cur_ = nullptr;
+    left_ = 0;
+    used_ = 0;
+    reserved_ = 0;
+}
+
+void json_arena::grow(size_t min_size)
+{
+    constexpr size_t max_block_size = 1024 * 1024;
+
+    // oversized requests get a block of their own, the rest grows geometrically
+    size_t size = std::max(block_size_, min_size);
+    blocks_.push_back(block{std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+    cur_ = blocks_.back().data.get();
+    left_ = size;
+    reserved_ += size;
+    if (block_size_ < max_block_size) block_size_ *= 2;
+}
+
+bool json_node::as_bool() const
+{
+    if (!is_bool()) throw std::runtime_error("json_node::as_bool: not a boolean");
+    return data_.boolean;
+}
+
+int64_t json_node::as_int() const
+{
+    if (!is_int()) throw std::runtime_error("json_node::as_int: not an integer");
+    return data_.integer;
+}
+
+double json_node::as_double() const
+{
+    if (is_double()) return data_.floating;
+    if (is_int()) return static_cast<double>(data_.integer);
+    throw std::runtime_error("json_node::as_double: not a number");
+}
+
+std::string_view json_node::as_string() const
+{
+    if (!is_string()) throw std::runtime_error("json_node::as_string: not a string");
+    return std::string_view(data_.string, size_);
+}
+
+std::span<const json_node> json_node::elements() const
+{
+    if (!is_array()) throw std::runtime_error("json_node::elements: not an array");
+    return std::span<const json_node>(data_.elements, size_);
+}
+
+const json_node &json_node::operator[](size_t index) const
+{
+    if (!is_array()) throw std::runtime_error("json_node::operator[]: not an array");
+    if (index >= size_) throw std::out_of_range("json_node::operator[]: index out of range");
+    return data_.elements[index];
+}
+
+std::span<const json_member> json_node::members() const
+{
+    if (!is_object()) throw std::runtime_error("json_node::members: not an object");
+    return std::span<const json_member>(data_.members, size_);
+}
+
+const uint32_t *json_node::sorted_index() const
+{
+    // stored right behind the member array, see json_document::builder::object()
+    return reinterpret_cast<const uint32_t*>(data_.members + size_);
+}
+
+const json_node *json_node::find(std::string_view key) const
+{
+    if (!is_object()) throw std::runtime_error("json_node::find: not an object");
+
+    if (size_ <= indexed_object_size) {
+        for (uint32_t i = 0; i < size_; ++i)
+            if (data_.members[i].key == key) return &data_.members[i].value;
+        return nullptr;
+    }
+
+    const uint32_t* order = sorted_index();
+    const uint32_t* it = std::lower_bound(order, order + size_, key,
+        [this](uint32_t i, std::string_view k) { return data_.members[i].key < k; });
+    if (it != order + size_ && data_.members[*it].key == key) return &data_.members[*it].value;
+    return nullptr;
+}
+
+const json_node &json_node::operator[](std::string_view key) const
+{
+    const json_node* node = find(key);
+    if (!node) throw std::out_of_range("json_node::operator[]: key not found: " + std::string(key));
+    return *node;
+}
+
+size_t json_node::size() const
+{
+    if (is_array() || is_object() || is_string()) return size_;
+    return 0;
+}
+
+bool json_node::empty() const
+{
+    if (is_null()) return true;
+    if (is_array() || is_object() || is_string()) return size_ == 0;
+    return false;
+}
+
+json_value json_node::to_value() const
+{
+    switch (type_) {
+    case json_value_type::boolean:  return json_value(data_.boolean);
+    case json_value_type::integer:  return json_value(data_.integer);
+    case json_value_type::floating: return json_value(data_.floating);
+    case json_value_type::string:   return json_value(std::string(data_.string, size_));
+    case json_value_type::array: {
+        std::vector<json_value> arr;
+        arr.reserve(size_);
+        for (const json_node& e : elements()) arr.push_back(e.to_value());
+        return json_value(std::move(arr));
+    }
+    case json_value_type::object: {
+        std::map<std::string, json_value> obj;
+        for (const json_member& m : members()) obj.emplace(std::string(m.key), m.value.to_value());
+        return json_value(std::move(obj));
+    }
+    default:
+        return json_value(nullptr);
+    }
+}
+
+/*
+    Builds the node tree from the structural index (see json_detail::build_structural_index).
+    Children are collected on scratch stacks and copied into the arena once their
+    container closes, so every array and object ends up contiguous.
+*/
+class json_document::builder {
+public:
+    builder(json_arena& arena, std::string_view text)
+        : arena(arena), text(text) {}
+
+    json_node build()
+    {
+        if (text.empty())
+            throw std::runtime_error("Input JSON string is empty");
+        if (!json_detail::build_structural_index(text, index))
+            throw std::runtime_error("json_document: input is larger than 4 GiB or contains comments");
+
+        // roughly one node per structural, keep the common case in one block
+        arena.reserve(index.size() * sizeof(json_node) + 64);
+        json_node root = value();
+
+        // every non-whitespace byte after the root starts a structural, so a
+        // used-up index means only whitespace follows (same rule as json_parser)
+        if (index_pos < index.size())
+            throw std::runtime_error(std::string("Unexpected character after JSON value: ") + text[index[index_pos]]);
+        return root;
+    }
+
+private:
+    char next(const char* error_message)
+    {
+        if (index_pos >= index.size()) throw std::runtime_error(error_message);
+        pos = index[index_pos++];
+        return text[pos];
+    }
+
+    char peek() const
+    {
+        return index_pos < index.size() ? text[index[index_pos]] : 0;
+    }
+
+    json_node value()
+    {
+        char c = next("Unexpected end of JSON input");
+        switch (c) {
+        case '{': return object();
+        case '[': return array();
+        case '"': {
+            std::string_view s = string();
+            json_node node;
+            node.type_ = json_value_type::string;
+            node.size_ = static_cast<uint32_t>(s.size());
+            node.data_.string = s.data();
+            return node;
+        }
+        case 't': return literal("true", json_value_type::boolean, true);
+        case 'f': return literal("false", json_value_type::boolean, false);
+        case 'n': return literal("null", json_value_type::null, false);
+        default:
+            if ((c >= '0' && c <= '9') || c == '-') return number();
+            throw std::runtime_error(std::string("Unexpected character in JSON input: ") + c);
+        }
+    }
+
+    json_node array()
+    {
+        json_node node;
+        node.type_ = json_value_type::array;
+
+        if (peek() == ']') {
+            ++index_pos;
+            return node;
+        }
+
+        const size_t base = nodes.size();
+        while (true) {
+            nodes.push_back(value());
+
+            char c = next("Unexpected end of JSON input while parsing array");
+            if (c == ',') continue;
+            if (c == ']') break;
+            throw std::runtime_error(std::string("Expected ',' or ']' in JSON array, but got: ") + c);
+        }
+
+        const size_t count = nodes.size() - base;
+        json_node* elements = arena.allocate<json_node>(count);
+        std::copy(nodes.begin() + base, nodes.end(), elements);
+        nodes.resize(base);
+
+        node.size_ = static_cast<uint32_t>(count);
+        node.data_.elements = elements;
+        return node;
+    }
+
+    json_node object()
+    {
+        json_node node;
+        node.type_ = json_value_type::object;
+
+        if (peek() == '}') {
+            ++index_pos;
+            return node;
+        }
+
+        const size_t base = members.size();
+        while (true) {
+            if (next("Unexpected end of JSON input while parsing element") != '"')
+                throw std::runtime_error("Expected '\"' at the beginning of JSON element name");
+            std::string_view key = string();
+
+            if (next("Expected ':' after JSON element name") != ':')
+                throw std::runtime_error("Expected ':' after JSON element name");
+
+            json_node v = value();
+            members.push_back(json_member{key, v});
+
+            char c = next("Unexpected end of JSON input while parsing object");
+            if (c == ',') continue;
+            if (c == '}') break;
+            throw std::runtime_error(std::string("Expected ',' or '}' in JSON object, but got: ") + c);
+        }
+
+        const size_t count = members.size() - base;
+        const bool indexed = count > json_node::indexed_object_size;
+
+        // larger objects carry a sorted index of their members right behind them
+        size_t bytes = count * sizeof(json_member) + (indexed ? count * sizeof(uint32_t) : 0);
+        json_member* dest = static_cast<json_member*>(arena.allocate(bytes, alignof(json_member)));
+        std::copy(members.begin() + base, members.end(), dest);
+        members.resize(base);
+
+        if (indexed) {
+            uint32_t* order = reinterpret_cast<uint32_t*>(dest + count);
+            std::iota(order, order + count, 0u);
+            // stable, so the first of duplicate keys is found first
+            std::stable_sort(order, order + count,
+                [dest](uint32_t a, uint32_t b) { return dest[a].key < dest[b].key; });
+        }
+
+        node.size_ = static_cast<uint32_t>(count);
+        node.data_.members = dest;
+        return node;
+    }
+
+    // `pos` is at the opening quote
+    std::string_view string()
+    {
+        const char* begin = text.data() + pos + 1;
+        const char* end = text.data() + text.size();
+
+        const char* quote = static_cast<const char*>(std::memchr(begin, '"', end - begin));
+        if (!quote) throw std::runtime_error("Unterminated JSON string");
+
+        // no escapes: point into the source
+        if (!std::memchr(begin, '\\', quote - begin))
+            return std::string_view(begin, quote - begin);
+
+        scratch.clear();
+        const char* p = begin;
+        while (true) {
+            const char* stop = p;
+            while (stop < end && *stop != '"' && *stop != '\\') ++stop;
+            scratch.append(p, stop);
+            if (stop >= end) throw std::runtime_error("Unterminated JSON string");
+            if (*stop == '"') break;
+
+            p = stop + 1;
+            if (p >= end) throw std::runtime_error("Unterminated escape sequence in JSON string");
+            switch (*p) {
+            case '"':  scratch += '"';  break;
+            case '\\': scratch += '\\'; break;
+            case '/':  scratch += '/';  break;
+            case 'b':  scratch += '\b'; break;
+            case 'f':  scratch += '\f'; break;
+            case 'n':  scratch += '\n'; break;
+            case 'r':  scratch += '\r'; break;
+            case 't':  scratch += '\t'; break;
+            case 'u': {
+                uint32_t codepoint = hex4(p + 1, end);
+                p += 4;
+                // surrogate pair
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF && end - p > 6 && p[1] == '\\' && p[2] == 'u') {
+                    uint32_t low = hex4(p + 3, end);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    }
+                }
+                utf8(codepoint);
+                break;
+            }
+#ifdef SCL2_JSON_ENABLE_EXTENSIONS
+            case 'x': {
+                if (end - p <= 2 || !std::isxdigit(static_cast<unsigned char>(p[1]))
+                                  || !std::isxdigit(static_cast<unsigned char>(p[2])))
+                    throw std::runtime_error("Incomplete hex escape in JSON string");
+                unsigned int byte = 0;
+                std::from_chars(p + 1, p + 3, byte, 16);
+                scratch += static_cast<char>(byte);
+                p += 2;
+                break;
+            }
+#endif
+            default:
+                throw std::runtime_error(std::string("Invalid escape character in JSON string: \\") + *p);
+            }
+            ++p;
+        }
+
+        return arena.store(scratch);
+    }
+
+    static uint32_t hex4(const char* p, const char* end)
+    {
+        uint32_t codepoint = 0;
+        if (end - p < 4) throw std::runtime_error("Incomplete Unicode escape in JSON string");
+        auto [ptr, ec] = std::from_chars(p, p + 4, codepoint, 16);
+        if (ec != std::errc() || ptr != p + 4)
+            throw std::runtime_error("Invalid Unicode escape in JSON string");
+        return codepoint;
+    }
+
+    void utf8(uint32_t codepoint)
+    {
+        if (codepoint <= 0x7F) {
+            scratch += static_cast<char>(codepoint);
+        } else if (codepoint <= 0x7FF) {
+            scratch += static_cast<char>(0xC0 | (codepoint >> 6));
+            scratch += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else if (codepoint <= 0xFFFF) {
+            scratch += static_cast<char>(0xE0 | (codepoint >> 12));
+            scratch += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            scratch += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else {
+            scratch += static_cast<char>(0xF0 | (codepoint >> 18));
+            scratch += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            scratch += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            scratch += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    json_node literal(std::string_view word, json_value_type type, bool flag)
+    {
+        if (text.compare(pos, word.size(), word) != 0) {
+            throw std::runtime_error(type == json_value_type::null
+                ? "Expected 'null'" : "Invalid JSON boolean value");
+        }
+        atom_end(pos + word.size());
+
+        json_node node;
+        node.type_ = type;
+        node.data_.boolean = flag;
+        return node;
+    }
+
+    json_node number()
+    {
+        const char* first = text.data() + pos;
+        const char* end = text.data() + text.size();
+        const char* p = first;
+        bool is_floating = false;
+
+        auto digit = [&]() { return p < end && *p >= '0' && *p <= '9'; };
+
+        if (*p == '-') ++p;
+        if (p < end && *p == '0') {
+            ++p;
+            if (digit()) throw std::runtime_error("Invalid JSON number: leading zero is not allowed");
+        } else if (digit()) {
+            while (digit()) ++p;
+        } else {
+            throw std::runtime_error("Invalid JSON number: expected digit");
+        }
+        if (p < end && *p == '.') {
+            is_floating = true;
+            ++p;
+            if (!digit()) throw std::runtime_error("Invalid JSON number: expected digit after decimal point");
+            while (digit()) ++p;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            is_floating = true;
+            ++p;
+            if (p < end && (*p == '+' || *p == '-')) ++p;
+            if (!digit()) throw std::runtime_error("Invalid JSON number: expected digit in exponent");
+            while (digit()) ++p;
+        }
+        atom_end(static_cast<size_t>(p - text.data()));
+
+        json_node node;
+        if (!is_floating) {
+            int64_t i = 0;
+            auto [ptr, ec] = std::from_chars(first, p, i);
+            if (ec == std::errc()) {
+                node.type_ = json_value_type::integer;
+                node.data_.integer = i;
+                return node;
+            }
+            // too large for int64_t, fall back to double like json_parser
+        }
+        double d = 0;
+        if (std::from_chars(first, p, d).ec != std::errc())
+            throw std::runtime_error("Invalid JSON number: out of range");
+        node.type_ = json_value_type::floating;
+        node.data_.floating = d;
+        return node;
+    }
+
+    // numbers and literals must be followed by whitespace, a structural or the end
+    void atom_end(size_t end) const
+    {
+        if (end >= text.size()) return;
+        char c = text[end];
+        if (c == ' ' || (c >= '\t' && c <= '\r')) return;
+        if (c == ',' || c == ':' || c == ']' || c == '}' || c == '[' || c == '{') return;
+        throw std::runtime_error(std::string("Unexpected character after JSON value: ") + c);
+    }
+
+    json_arena& arena;
+    std::string_view text;
+    std::vector<uint32_t> index;
+    size_t index_pos = 0;
+    size_t pos = 0;
+
+    std::vector<json_node> nodes;
+    std::vector<json_member> members;
+    std::string scratch;
+};
+
+json_document json_document::parse(std::string_view text)
+{
+    json_document doc;
+    builder b(doc.arena_, text);
+    doc.root_ = b.build();
+    return doc;
+}
+
+json_document json_document::parse(std::string &&text)
+{
+    json_document doc;
+    doc.owned_ = std::make_unique<std::string>(std::move(text));
+    builder b(doc.arena_, *doc.owned_);
+    doc.root_ = b.build();
+    return doc;
+}
+
+json_document json_document::fromFile(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open JSON file: " + path.string());
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return parse(std::move(buffer).str());
+}
+
+const json_node &json_document::at_path(const json_pointer &pointer) const
+{
+    const json_node* current = &root_;
+    const std::vector<std::string>& segments = pointer.segments();
+    for (size_t depth = 0; depth < segments.size(); ++depth) {
+        const std::string& segment = segments[depth];
+        if (current->is_array()) {
+            const size_t index = pointer.indices()[depth];
+            if (index == json_pointer::npos)
+                throw std::runtime_error("json_document::at_path: invalid array index: " + segment);
+            if (index >= current->size())
+                throw std::runtime_error("json_document::at_path: array index out of bounds: " + segment);
+            current = &(*current)[index];
+        } else if (current->is_object()) {
+            current = current->find(segment);
+            if (!current)
+                throw std::runtime_error("json_document::at_path: object key not found: " + segment);
+        } else {
+            throw std::runtime_error("json_document::at_path: cannot apply pointer to scalar value");
+        }
+    }
+    return *current;
+}
+
+json json_document::to_json() const
+{
+    return json(root_.to_value());
+}
+
+void json_document::clear()
+{
+    root_ = json_node();
+    arena_.release();
+    owned_.reset();
+}
+
+} // namespace scl2
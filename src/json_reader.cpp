@@ -0,0 +1,370 @@
+/*
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.1
+    cpp_generation: cxx17 - cxx23
+    standalone_dependency: json
+*/
+#include "json_reader.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+namespace scl2 {
+
+void json_reader::feed(std::string_view chunk)
+{
+    if (finished_) throw std::runtime_error("json_reader::feed: input already finished");
+
+    // drop the consumed part once it is at least half of the buffer
+    if (offset_ != 0 && offset_ >= buffer_.size() / 2) {
+        buffer_.erase(0, offset_);
+        offset_ = 0;
+    }
+    buffer_.append(chunk);
+}
+
+void json_reader::finish()
+{
+    finished_ = true;
+}
+
+json_event json_reader::next()
+{
+    while (true) {
+        json_event ev = nextEvent();
+        if (skip_depth_ == 0 || ev == json_event::need_input || ev == json_event::end_of_input)
+            return ev;
+        if ((ev == json_event::end_object || ev == json_event::end_array) && frames_.size() < skip_depth_) {
+            skip_depth_ = 0;
+            return ev;
+        }
+    }
+}
+
+bool json_reader::dispatch(json_sax_handler &handler)
+{
+    while (true) {
+        switch (next()) {
+        case json_event::need_input:   return true;
+        case json_event::end_of_input: return false;
+        case json_event::start_object: handler.on_start_object(); break;
+        case json_event::end_object:   handler.on_end_object(); break;
+        case json_event::start_array:  handler.on_start_array(); break;
+        case json_event::end_array:    handler.on_end_array(); break;
+        case json_event::key:          handler.on_key(key_); break;
+        case json_event::value:        handler.on_value(value_); break;
+        }
+    }
+}
+
+void json_reader::skip()
+{
+    if (!last_start_)
+        throw std::runtime_error("json_reader::skip: not at the start of an object or array");
+    skip_depth_ = frames_.size();
+}
+
+std::string json_reader::path() const
+{
+    std::string result;
+    const size_t n = pathLength();
+    for (size_t i = 0; i < n; ++i) {
+        result += '/';
+        if (!frames_[i].object) {
+            result += std::to_string(frames_[i].index);
+            continue;
+        }
+        for (char c : frames_[i].key) {
+            if (c == '~') result += "~0";
+            else if (c == '/') result += "~1";
+            else result += c;
+        }
+    }
+    return result;
+}
+
+bool json_reader::path_matches(const json_pointer &pattern, bool prefix) const
+{
+    const std::vector<std::string>& segments = pattern.segments();
+    const size_t n = pathLength();
+    if (prefix ? segments.size() <= n : segments.size() != n) return false;
+
+    for (size_t i = 0; i < n; ++i) {
+        const std::string& segment = segments[i];
+        if (segment == "*") continue;
+        if (frames_[i].object) {
+            if (frames_[i].key != segment) return false;
+        } else if (pattern.indices()[i] != frames_[i].index) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void json_reader::reset()
+{
+    buffer_.clear();
+    offset_ = 0;
+    string_scan_ = 0;
+    finished_ = false;
+    frames_.clear();
+    expect_ = expect::value;
+    last_start_ = false;
+    skip_depth_ = 0;
+    key_.clear();
+    value_.clear();
+}
+
+json_event json_reader::nextEvent()
+{
+    while (true) {
+        while (offset_ < buffer_.size() && std::isspace(static_cast<unsigned char>(buffer_[offset_])))
+            ++offset_;
+
+        if (offset_ >= buffer_.size()) {
+            if (!finished_) return json_event::need_input;
+            if (frames_.empty() && expect_ == expect::value) return json_event::end_of_input;
+            throw std::runtime_error("Unexpected end of JSON input");
+        }
+
+        const char c = buffer_[offset_];
+        switch (expect_) {
+        case expect::colon:
+            if (c != ':') throw std::runtime_error("Expected ':' after JSON element name");
+            ++offset_;
+            expect_ = expect::value;
+            continue;
+
+        case expect::comma_or_end:
+            if (c == ',') {
+                ++offset_;
+                expect_ = frames_.back().object ? expect::key : expect::value;
+                continue;
+            }
+            if (frames_.back().object) {
+                if (c == '}') return closeContainer();
+                throw std::runtime_error(std::string("Expected ',' or '}' in JSON object, but got: ") + c);
+            }
+            if (c == ']') return closeContainer();
+            throw std::runtime_error(std::string("Expected ',' or ']' in JSON array, but got: ") + c);
+
+        case expect::key_or_end:
+            if (c == '}') return closeContainer();
+            [[fallthrough]];
+        case expect::key: {
+            if (c != '"') throw std::runtime_error("Expected '\"' at the beginning of JSON element name");
+            size_t length = 0;
+            if (!scanString(length)) return json_event::need_input;
+
+            parser_.json_str = std::string_view(buffer_).substr(offset_, length);
+            parser_.pos = 0;
+            key_ = parser_.parseJsonString();
+            offset_ += length;
+
+            frames_.back().key = key_;
+            expect_ = expect::colon;
+            last_start_ = false;
+            return json_event::key;
+        }
+
+        case expect::value_or_end:
+            if (c == ']') return closeContainer();
+            [[fallthrough]];
+        case expect::value:
+            return beginValue(c);
+        }
+    }
+}
+
+json_event json_reader::beginValue(char c)
+{
+    if (c == '{' || c == '[') {
+        ++offset_;
+        if (!frames_.empty() && !frames_.back().object) ++frames_.back().index;
+        frames_.push_back(frame{c == '{', static_cast<size_t>(-1), std::string()});
+        expect_ = c == '{' ? expect::key_or_end : expect::value_or_end;
+        last_start_ = true;
+        return c == '{' ? json_event::start_object : json_event::start_array;
+    }
+
+    size_t length = 0;
+    if (c == '"') {
+        if (!scanString(length)) return json_event::need_input;
+    } else if (c == '-' || c == 't' || c == 'f' || c == 'n' || (c >= '0' && c <= '9')) {
+        if (!scanAtom(length)) return json_event::need_input;
+    } else {
+        throw std::runtime_error(std::string("Unexpected character in JSON input: ") + c);
+    }
+
+    // values inside skip() are only delimited, never decoded
+    if (skip_depth_ == 0) {
+        parser_.json_str = std::string_view(buffer_).substr(offset_, length);
+        parser_.pos = 0;
+        value_ = parser_.parseJsonValue();
+        if (parser_.pos != length)
+            throw std::runtime_error(std::string("Unexpected character after JSON value: ") + buffer_[offset_ + parser_.pos]);
+    }
+    offset_ += length;
+
+    if (!frames_.empty() && !frames_.back().object) ++frames_.back().index;
+    afterValue();
+    last_start_ = false;
+    return json_event::value;
+}
+
+json_event json_reader::closeContainer()
+{
+    ++offset_;
+    const bool object = frames_.back().object;
+    frames_.pop_back();
+    afterValue();
+    last_start_ = false;
+    return object ? json_event::end_object : json_event::end_array;
+}
+
+void json_reader::afterValue()
+{
+    expect_ = frames_.empty() ? expect::value : expect::comma_or_end;
+}
+
+size_t json_reader::pathLength() const
+{
+    // a start event belongs to the container itself, not to its first child
+    return frames_.size() - (last_start_ ? 1 : 0);
+}
+
+bool json_reader::scanString(size_t &length)
+{
+    const char* data = buffer_.data();
+    const char* end = data + buffer_.size();
+    const char* p = data + offset_ + std::max<size_t>(string_scan_, 1);
+
+    while (p < end) {
+        const char* quote = static_cast<const char*>(std::memchr(p, '"', end - p));
+        const char* search_end = quote ? quote : end;
+        const char* backslash = static_cast<const char*>(std::memchr(p, '\\', search_end - p));
+
+        if (!backslash) {
+            if (!quote) { p = end; break; }
+            length = static_cast<size_t>(quote + 1 - (data + offset_));
+            string_scan_ = 0;
+            return true;
+        }
+        if (backslash + 1 >= end) { p = backslash; break; } // resume at the split escape
+        p = backslash + 2;
+    }
+
+    if (finished_) throw std::runtime_error("Unterminated JSON string");
+    string_scan_ = static_cast<size_t>(p - (data + offset_));
+    return false;
+}
+
+bool json_reader::scanAtom(size_t &length)
+{
+    size_t i = offset_;
+    while (i < buffer_.size()) {
+        char c = buffer_[i];
+        if (std::isspace(static_cast<unsigned char>(c)) || c == ',' || c == ':' || c == ']' || c == '}'
+            || c == '[' || c == '{' || c == '"') break;
+        ++i;
+    }
+    // a number or literal at the end of the buffer may continue in the next chunk
+    if (i == buffer_.size() && !finished_) return false;
+    length = i - offset_;
+    return true;
+}
+
+json_subtree_collector::json_subtree_collector(const std::vector<std::string> &patterns, callback on_match)
+    : on_match_(std::move(on_match))
+{
+    patterns_.reserve(patterns.size());
+    for (const std::string& pattern : patterns) patterns_.emplace_back(pattern);
+}
+
+json_event json_subtree_collector::consume(json_reader &reader)
+{
+    while (true) {
+        json_event ev = reader.next();
+        switch (ev) {
+        case json_event::need_input:
+        case json_event::end_of_input:
+            return ev;
+
+        case json_event::key:
+            if (!stack_.empty()) key_ = reader.key();
+            break;
+
+        case json_event::value:
+            if (!stack_.empty()) {
+                addChild(json_value(reader.value()));
+            } else if (matches(reader)) {
+                on_match_(reader.path(), json_value(reader.value()));
+            }
+            break;
+
+        case json_event::start_object:
+        case json_event::start_array: {
+            json_value container = ev == json_event::start_object
+                ? json_value(json_object()) : json_value(json_array());
+            if (!stack_.empty()) {
+                json_value* child = addChild(std::move(container));
+                if (child) {
+                    stack_.push_back(child);
+                } else {
+                    reader.skip(); // duplicate key, the first one wins like in json_parser
+                    skipping_ = true;
+                }
+            } else if (matches(reader)) {
+                root_ = std::move(container);
+                root_path_ = reader.path();
+                stack_.push_back(&root_);
+            } else if (!matchesBelow(reader)) {
+                reader.skip();
+            }
+            break;
+        }
+
+        case json_event::end_object:
+        case json_event::end_array:
+            if (skipping_) {
+                skipping_ = false;
+            } else if (!stack_.empty()) {
+                stack_.pop_back();
+                if (stack_.empty()) {
+                    on_match_(root_path_, std::move(root_));
+                    root_ = json_value();
+                }
+            }
+            break;
+        }
+    }
+}
+
+bool json_subtree_collector::matches(const json_reader &reader) const
+{
+    for (const json_pointer& pattern : patterns_)
+        if (reader.path_matches(pattern)) return true;
+    return false;
+}
+
+bool json_subtree_collector::matchesBelow(const json_reader &reader) const
+{
+    for (const json_pointer& pattern : patterns_)
+        if (reader.path_matches(pattern, true)) return true;
+    return false;
+}
+
+json_value *json_subtree_collector::addChild(json_value &&child)
+{
+    json_value* parent = stack_.back();
+    if (parent->is_array()) {
+        parent->as_array().push_back(std::move(child));
+        return &parent->as_array().back();
+    }
+    auto [it, inserted] = parent->as_object().try_emplace(key_, std::move(child));
+    return inserted ? &it->second : nullptr;
+}
+
+} // namespace scl2
@@ -2,15 +2,38 @@
 
 #include "basics.hpp"
 
+#include <ctime>
+
 // 静态成员定义
 std::mutex logt_eventbus::mutex_;
 std::condition_variable logt_eventbus::cond_;
 std::queue<logt_message> logt_eventbus::queue_;
+std::vector<std::unique_ptr<logt_chunk>> logt_eventbus::chunks_;
 std::atomic<bool> logt_eventbus::stopped_{false};
+bool logt_eventbus::finished_ = false;
+bool logt_eventbus::woken_ = false;
+std::atomic<logt_eventbus::Backend> logt_eventbus::backend_{logt_eventbus::Backend::queue};
+logt_ringbuffer logt_eventbus::ring_;
+LogOverflow logt_eventbus::policy_ = LogOverflow::Block;
+std::atomic<bool> logt_eventbus::used_{false};
+std::atomic<bool> logt_eventbus::consumer_waiting_{false};
+std::atomic<int> logt_eventbus::blocked_producers_{0};
+std::condition_variable logt_eventbus::space_cond_;
+std::atomic<uint64_t> logt_eventbus::dropped_{0};
+
+std::atomic<bool> logt_staging::enabled_{false};
+std::atomic<size_t> logt_staging::pending_{0};
+std::atomic<size_t> logt_staging::chunk_size_{64 * 1024};
+std::atomic<int64_t> logt_staging::flush_interval_ms_{20};
+std::mutex logt_staging::registry_mutex_;
+std::vector<logt_staging::buffer*> logt_staging::registry_;
+std::mutex logt_staging::pool_mutex_;
+std::vector<std::unique_ptr<logt_chunk>> logt_staging::pool_;
 
 
 // 静态成员定义
-LogLevel logt::filter_level_ = LogLevel::Info;
+std::atomic<LogLevel> logt::filter_level_{LogLevel::Info};
+std::atomic<LogLevel> logt::min_level_{LogLevel::Info};
 logt_channel logt::channels_[LOGT_MAX_CHANNEL];
 logt_channelinfo logt::channelinfo_;  // track registered channels
 int logt::last_channel_id = 1;
@@ -18,9 +41,11 @@ logt_channelinfo logt::default_channels_;
 preprocessor_t logt::preprocessor_;
 std::mutex logt::thread_mutex_;
 std::unordered_map<std::thread::id, std::string> logt::thread_names_;
+std::atomic<uint64_t> logt::thread_names_generation_{0};
 std::thread logt::worker_;
 std::once_flag logt::worker_flag_;
 std::atomic<bool> logt::super_timestamp_enabled_{false};
+std::atomic<bool> logt::coarse_timestamp_enabled_{false};
 logt_format logt::formatter_;
 
 const char* logt::level_labels_[] = {
@@ -57,6 +82,11 @@ void logt_channel::close() {
         case ChannelType::stdcout:
             std::cout << std::flush; // flush stdout
             break;
+        case ChannelType::file_sink:
+            sink->close();
+            delete sink;
+            sink = nullptr;
+            break;
         case ChannelType::custom_ostream:
         case ChannelType::invalid:
         default:
@@ -72,19 +102,159 @@ void logt_channel::close() {
 }
 
 logt_message::logt_message(std::string msg, LogLevel level, logt_channelinfo channels) 
-: timestamp(std::chrono::system_clock::now())
+: timestamp(logt::now())
 , content(std::move(msg))
 , level(level)
 , channels(channels) {}
 
 
-void logt_eventbus::push(const std::string& s, LogLevel level, logt_channelinfo channel) {
+void logt_ringbuffer::reset(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    slots_ = std::make_unique<slot[]>(size);
+    for (size_t i = 0; i < size; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = size - 1;
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+}
+
+bool logt_ringbuffer::try_push(logt_message& message) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        slot& s = slots_[pos & mask_];
+        size_t seq = s.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            // slot is free for this lap, try to claim it
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                s.message = std::move(message);
+                s.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // the consumer has not released this slot yet: full
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool logt_ringbuffer::try_pop(logt_message& result) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        slot& s = slots_[pos & mask_];
+        size_t seq = s.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                result = std::move(s.message);
+                s.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // nothing committed at this position: empty
+        } else {
+            pos = dequeue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool logt_ringbuffer::empty() const {
+    size_t pos = dequeue_pos_.load(std::memory_order_acquire);
+    return slots_[pos & mask_].sequence.load(std::memory_order_acquire) != pos + 1;
+}
+
+bool logt_ringbuffer::full() const {
+    size_t head = dequeue_pos_.load(std::memory_order_acquire);
+    size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+    return tail - head >= capacity();
+}
+
+
+
+void logt_eventbus::push(std::string s, LogLevel level, logt_channelinfo channel) {
+    // configure_ring() refuses to switch once anything went through the bus
+    if (!used_.load(std::memory_order_relaxed)) used_.store(true, std::memory_order_relaxed);
+
+    if (backend() == Backend::ring) {
+        logt_message message(std::move(s), level, channel);
+        push_ring(message);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push(logt_message(std::move(s), level, channel));
+    cond_.notify_one();
+}
+
+void logt_eventbus::push_chunk(std::unique_ptr<logt_chunk> chunk) {
     std::unique_lock<std::mutex> lock(mutex_);
-    queue_.push(logt_message(s, level, channel));
+    if (finished_) {
+        // nobody writes it anymore (thread exiting after shutdown)
+        dropped_.fetch_add(chunk->records.size(), std::memory_order_relaxed);
+        return;
+    }
+    chunks_.push_back(std::move(chunk));
     cond_.notify_one();
 }
 
+void logt_eventbus::push_ring(logt_message& message) {
+    bool pushed = ring_.try_push(message);
+
+    if (!pushed) {
+        switch (policy_) {
+        case LogOverflow::DropNewest:
+            break;
+        case LogOverflow::DropOldest: {
+            // act as a second consumer and evict from the head until we fit
+            logt_message victim;
+            while (!(pushed = ring_.try_push(message))) {
+                if (ring_.try_pop(victim)) dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+        }
+        case LogOverflow::Block:
+        default:
+            while (!(pushed = ring_.try_push(message)) && !stopped_) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                blocked_producers_.fetch_add(1);
+                space_cond_.wait(lock, []() { return !ring_.full() || stopped_; });
+                blocked_producers_.fetch_sub(1);
+            }
+            break;
+        }
+    }
+
+    if (!pushed) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // only pay for the mutex when the worker is actually asleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_waiting_.load()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.notify_one();
+    }
+}
+
 bool logt_eventbus::pop(logt_message& result) {
+    if (backend() == Backend::ring) {
+        for (;;) {
+            if (ring_.try_pop(result)) return true;
+            if (stopped_) return ring_.try_pop(result);
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            consumer_waiting_.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cond_.wait(lock, []() { return !ring_.empty() || stopped_; });
+            consumer_waiting_.store(false);
+        }
+    }
+
     std::unique_lock<std::mutex> lock(mutex_);
     cond_.wait(lock, [&]() { return !queue_.empty() || stopped_; });
     
@@ -96,64 +266,297 @@ bool logt_eventbus::pop(logt_message& result) {
     return true;
 }
 
+size_t logt_eventbus::drain_ring(std::vector<logt_message>& result, size_t max_count) {
+    size_t count = 0;
+    logt_message message;
+    while (count < max_count && ring_.try_pop(message)) {
+        result.push_back(std::move(message));
+        count++;
+    }
+
+    // pairs with a producer that registers in blocked_producers_ and then checks full()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (count != 0 && blocked_producers_.load() > 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cond_.notify_all();
+    }
+    return count;
+}
+
+bool logt_eventbus::pop_batch(std::vector<logt_message>& result, std::vector<std::unique_ptr<logt_chunk>>& chunks,
+                              std::chrono::milliseconds timeout, size_t max_count) {
+    auto take_chunks = [&]() {
+        for (auto& chunk : chunks_) chunks.push_back(std::move(chunk));
+        chunks_.clear();
+    };
+
+    if (backend() == Backend::ring) {
+        size_t count = drain_ring(result, max_count);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (count == 0 && chunks_.empty() && !stopped_ && !woken_) {
+            consumer_waiting_.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto ready = []() { return !ring_.empty() || !chunks_.empty() || stopped_ || woken_; };
+            if (timeout.count() > 0) cond_.wait_for(lock, timeout, ready);
+            else cond_.wait(lock, ready);
+            consumer_waiting_.store(false);
+        }
+        woken_ = false;
+        take_chunks();
+        bool stopped = stopped_;
+        lock.unlock();
+
+        if (count == 0) count = drain_ring(result, max_count);
+        return !(stopped && count == 0 && chunks.empty() && ring_.empty());
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    // configure_ring() may switch the backend while the worker waits here
+    auto ready = [&]() { return !queue_.empty() || !chunks_.empty() || stopped_ || woken_ || backend() != Backend::queue; };
+    if (timeout.count() > 0) cond_.wait_for(lock, timeout, ready);
+    else cond_.wait(lock, ready);
+    woken_ = false;
+
+    size_t count = 0;
+    while (count < max_count && !queue_.empty()) {
+        result.push_back(std::move(queue_.front()));
+        queue_.pop();
+        count++;
+    }
+    take_chunks();
+    return !(stopped_ && count == 0 && chunks.empty());
+}
+
 void logt_eventbus::stop() {
     std::unique_lock<std::mutex> lock(mutex_);
     stopped_ = true;
     cond_.notify_all();
+    space_cond_.notify_all();
+}
+
+void logt_eventbus::wake() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    woken_ = true;
+    cond_.notify_one();
+}
+
+void logt_eventbus::finish(std::vector<std::unique_ptr<logt_chunk>>& chunks) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_ = true;
+    for (auto& chunk : chunks_) chunks.push_back(std::move(chunk));
+    chunks_.clear();
 }
 
+bool logt_eventbus::configure_ring(size_t capacity, LogOverflow policy) {
+    if (capacity == 0 || used_.load()) return false;
 
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!queue_.empty()) return false;
 
-logt_sso::logt_sso(LogLevel level, const logt_format& formatter, const logt_channelinfo& channels, const std::string& signature) 
-    : level_(level), channels(channels)
-{
-    logt::ensure_worker_started();
+    ring_.reset(capacity);
+    policy_ = policy;
+    backend_.store(Backend::ring);
+    cond_.notify_all(); // a worker waiting in queue mode moves over to the ring
+    return true;
+}
 
-    logt_format::formatInfo info;
-    info.level = level;
-    info.signature = signature;
 
-    if(formatter.formatFunc) {
-        ss_ << formatter.formatFunc(formatter.settings, info);
-    } else {
-        ss_ << default_formatter(formatter.settings, info);
+
+// streambuf appending to the record a thread is writing
+class logt_chunkbuf : public std::streambuf {
+public:
+    std::string* target = nullptr;
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            target->push_back(traits_type::to_char_type(ch));
+        }
+        return traits_type::not_eof(ch);
     }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        target->append(s, static_cast<size_t>(n));
+        return n;
+    }
+};
+
+struct logt_staging::buffer {
+    std::mutex mutex; // guards chunk, held only to copy a finished record in
+    std::unique_ptr<logt_chunk> chunk;
+    std::string record; // the record being written, formatted without the lock
+    logt_chunkbuf streambuf;
+    std::ostream stream{&streambuf};
+    bool busy = false; // a record is being written by this thread
+
+    buffer() : chunk(logt_staging::acquire_chunk()) {
+        chunk->owner = std::this_thread::get_id();
+        streambuf.target = &record;
+        std::unique_lock<std::mutex> lock(registry_mutex_);
+        registry_.push_back(this);
+    }
+
+    ~buffer() {
+        {
+            std::unique_lock<std::mutex> lock(registry_mutex_);
+            std::erase(registry_, this);
+        }
+        // thread is exiting, hand over whatever is left (counted as dropped after shutdown)
+        if (!chunk->empty()) {
+            pending_.fetch_sub(1);
+            logt_eventbus::push_chunk(std::move(chunk));
+        }
+    }
+
+    // swap in an empty chunk, caller holds `mutex`
+    std::unique_ptr<logt_chunk> take() {
+        if (!chunk->empty()) pending_.fetch_sub(1);
+        std::unique_ptr<logt_chunk> full = std::move(chunk);
+        chunk = logt_staging::acquire_chunk();
+        chunk->owner = full->owner;
+        return full;
+    }
+};
+
+void logt_staging::configure(bool enabled, size_t chunk_size, std::chrono::milliseconds flush_interval) {
+    chunk_size_.store(chunk_size == 0 ? 1 : chunk_size);
+    flush_interval_ms_.store(flush_interval.count() > 0 ? flush_interval.count() : 1);
+    enabled_.store(enabled);
 }
 
-logt_sso::~logt_sso() {
-    // 析构时自动推送完整日志
-    logt_eventbus::push(ss_.str(), level_, channels);
+logt_staging::buffer& logt_staging::local() {
+    thread_local buffer buf;
+    return buf;
 }
 
-std::string logt_sso::default_formatter(const logt_format::formatSettings& settings, const logt_format::formatInfo &info)
-{
-    std::string format_result;
-    format_result = logt::level_labels_[static_cast<int>(info.level)];
+std::ostream* logt_staging::begin_record() {
+    buffer& buf = local();
+    if (buf.busy) return nullptr; // nested logging, records must not interleave
+
+    buf.busy = true;
+    buf.record.clear();
+
+    // a fresh stringstream starts with default formatting, so does every record
+    buf.stream.clear();
+    buf.stream.flags(std::ios_base::skipws | std::ios_base::dec);
+    buf.stream.precision(6);
+    buf.stream.width(0);
+    buf.stream.fill(' ');
+    return &buf.stream;
+}
+
+std::string* logt_staging::begin_binary() {
+    buffer& buf = local();
+    if (buf.busy) return nullptr;
+
+    buf.busy = true;
+    buf.record.clear();
+    return &buf.record;
+}
 
-    if(settings.enableAlignment) {
-        if(info.level == LogLevel::Info || info.level == LogLevel::Warn) {
-            format_result += " "; // add an extra space for alignment
+void logt_staging::end_record(LogLevel level, logt_channelinfo channels,
+                              const logt_site* site, size_t prefix, int prefix_flags) {
+    buffer& buf = local();
+    auto now = logt::now();
+
+    std::unique_ptr<logt_chunk> full;
+    bool first_pending = false;
+    {
+        // the record is complete, the worker may take the chunk at any other time
+        std::unique_lock<std::mutex> lock(buf.mutex);
+        logt_chunk& chunk = *buf.chunk;
+        if (chunk.empty()) first_pending = pending_.fetch_add(1) == 0;
+        chunk.records.push_back({level, channels, now, chunk.data.size(), buf.record.size(), site, prefix, prefix_flags});
+        chunk.data += buf.record;
+
+        if (chunk.data.size() >= chunk_size_.load(std::memory_order_relaxed)
+            || now - chunk.records.front().timestamp >= flush_interval()) {
+            full = buf.take();
         }
     }
+    buf.busy = false;
 
-    if(settings.enableThreadTag) {
-        format_result += std::string(" ");
-        auto thread_name = logt::get_thread_name();
-        if (!thread_name.empty()) {
-            format_result += "[" + thread_name + "] ";
-        } else {
-            format_result += "[#" + streamed_to_string(std::this_thread::get_id()) + "] ";
+    if (full) logt_eventbus::push_chunk(std::move(full));
+    // the worker may be waiting without a timeout, it has to come back for this chunk
+    else if (first_pending) logt_eventbus::wake();
+}
+
+void logt_staging::collect(std::vector<std::unique_ptr<logt_chunk>>& out, bool force) {
+    auto now = logt::now(); // the clock end_record() stamps with
+    auto interval = flush_interval();
+
+    std::unique_lock<std::mutex> lock(registry_mutex_);
+    for (buffer* buf : registry_) {
+        std::unique_lock<std::mutex> buflock(buf->mutex, std::defer_lock);
+        if (force) buflock.lock();
+        else if (!buflock.try_lock()) continue; // the owner is adding a record, it will hand off itself
+
+        if (buf->chunk->empty()) continue;
+        if (force || now - buf->chunk->records.front().timestamp >= interval) {
+            out.push_back(buf->take());
         }
     }
+}
+
+std::unique_ptr<logt_chunk> logt_staging::acquire_chunk() {
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex_);
+        if (!pool_.empty()) {
+            std::unique_ptr<logt_chunk> chunk = std::move(pool_.back());
+            pool_.pop_back();
+            return chunk;
+        }
+    }
+    auto chunk = std::make_unique<logt_chunk>();
+    chunk->data.reserve(chunk_size_.load(std::memory_order_relaxed));
+    return chunk;
+}
+
+void logt_staging::recycle(std::unique_ptr<logt_chunk> chunk) {
+    chunk->clear();
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    if (pool_.size() < pool_limit) pool_.push_back(std::move(chunk));
+}
+
+
+
+logt_site::logt_site(std::string_view format, const char* file, int line)
+    : format(format), file(file), line(line) {}
+
+
 
-    if (!info.signature.empty()) {
-        format_result += "[" + info.signature + "] ";
+logt_sso::logt_sso(LogLevel level, const logt_format& formatter, const logt_channelinfo& channels, const std::string& signature) 
+    : level_(logt::effective_level(level)), channels(channels)
+{
+    logt::ensure_worker_started();
+
+    if (logt_staging::enabled()) {
+        os_ = logt_staging::begin_record();
+        staged_ = (os_ != nullptr);
+    }
+    if (!staged_) {
+        ss_.emplace();
+        os_ = &*ss_;
     }
 
-    return format_result;
+    if(formatter.formatFunc) {
+        *os_ << formatter.formatFunc(formatter.settings, logt_format::formatInfo{level_, signature});
+    } else {
+        *os_ << logt::cached_prefix(formatter.settings, level_, signature);
+    }
 }
 
+logt_sso::~logt_sso() {
+    if (!active_) return;
 
+    // 析构时自动推送完整日志
+    if (staged_) {
+        logt_staging::end_record(level_, channels);
+    } else {
+        logt_eventbus::push(std::move(*ss_).str(), level_, channels);
+    }
+}
 
 logt_sig::logt_sig(const std::string& name)
     : name_(name)
@@ -213,6 +616,35 @@ int logt::addfile(const std::filesystem::path& filename, bool default_enable) {
     return newid;
 }
 
+int logt::addfilesink(const std::filesystem::path& filename, logt_filesink::options options, bool default_enable) {
+    ensure_worker_started();
+
+    int newid = last_channel_id++;
+    if (newid >= LOGT_MAX_CHANNEL) {
+        return -1;  // 频道已满
+    }
+    logt_channel &channel = channels_[newid];
+    auto lock = channel.lock();
+
+    channel.type = logt_channel::ChannelType::file_sink;
+    channel.sink = new logt_filesink(filename, std::move(options));
+    channel.valid = true; // the sink retries opening on flush
+    channel.enabled = true;
+
+    channelinfo_.set(newid, true);  // mark as registered
+    default_channels_.set(newid, default_enable);
+
+    return newid;
+}
+
+logt_filesink::stats logt::channelStats(int channel_id) {
+    if (channel_id < 0 || channel_id >= LOGT_MAX_CHANNEL) return {};
+
+    auto lock = channels_[channel_id].lock();
+    if (channels_[channel_id].type != logt_channel::ChannelType::file_sink || !channels_[channel_id].valid) return {};
+    return channels_[channel_id].sink->statistics();
+}
+
 int logt::addostream(std::ostream& os, bool default_enable) {
     ensure_worker_started();
     // std::unique_lock<std::mutex> lock(file_mutex_);
@@ -248,6 +680,7 @@ void logt::claim(const std::string& name) {
     ensure_worker_started();
     std::unique_lock<std::mutex> lock(thread_mutex_);
     thread_names_[std::this_thread::get_id()] = name;
+    thread_names_generation_.fetch_add(1, std::memory_order_release);
 }
 
 void logt::shutdown() {
@@ -274,6 +707,96 @@ void logt::setFormatter(logt_format::format_func formatter)
     formatter_.formatFunc = formatter;
 }
 
+std::string logt::thread_tag(std::thread::id thread) {
+    std::string thread_name;
+    {
+        std::unique_lock<std::mutex> lock(thread_mutex_);
+        auto it = thread_names_.find(thread);
+        if (it != thread_names_.end()) thread_name = it->second;
+    }
+    if (!thread_name.empty()) {
+        return "[" + thread_name + "] ";
+    }
+    return "[#" + streamed_to_string(thread) + "] ";
+}
+
+int logt::prefix_flags(const logt_format::formatSettings& settings) {
+    return (settings.enableThreadTag ? 1 : 0) | (settings.enableAlignment ? 2 : 0);
+}
+
+// Appends the prefix logt_sso writes with the default formatter, `flags` from prefix_flags()
+void logt::format_prefix(std::string& out, int flags, LogLevel level, std::string_view signature, std::string_view tag)
+{
+    out += level_labels_[static_cast<int>(level)];
+
+    if ((flags & 2) && (level == LogLevel::Info || level == LogLevel::Warn)) {
+        out += " "; // add an extra space for alignment
+    }
+
+    if (flags & 1) {
+        out += " ";
+        out += tag;
+    }
+
+    if (!signature.empty()) {
+        out += "[";
+        out += signature;
+        out += "] ";
+    }
+}
+
+// Prefixes of the calling thread, rebuilt only when the settings or the thread
+// name change. Saves the thread name lookup and the string building on every
+// message. A few signatures are kept, so a thread alternating between sigs
+// doesn't rebuild on each message.
+const std::string& logt::cached_prefix(const logt_format::formatSettings& settings, LogLevel level,
+                                       const std::string& signature)
+{
+    struct prefix_slot {
+        std::string signature;  // the prefixes below belong to this signature
+        int flags = -1;         // prefix_flags() they were built with, -1: unused slot
+        std::string prefix[5];  // per level, empty until first used
+    };
+    struct prefix_cache {
+        uint64_t generation = ~uint64_t(0);
+        std::string tag;        // "[name] " or "[#id] "
+        prefix_slot slots[4];
+        size_t next = 0;        // slot replaced on the next miss
+    };
+    thread_local prefix_cache cache;
+
+    level = effective_level(level); // Inherit has no label of its own
+    uint64_t generation = thread_names_generation_.load(std::memory_order_acquire);
+    int flags = prefix_flags(settings);
+
+    if (cache.generation != generation) {
+        cache.tag = thread_tag(std::this_thread::get_id());
+        cache.generation = generation;
+        for (prefix_slot& slot : cache.slots) slot.flags = -1;
+    }
+
+    prefix_slot* slot = nullptr;
+    for (prefix_slot& s : cache.slots) {
+        if (s.flags == flags && s.signature == signature) {
+            slot = &s;
+            break;
+        }
+    }
+    if (!slot) {
+        slot = &cache.slots[cache.next];
+        cache.next = (cache.next + 1) % std::size(cache.slots);
+        slot->flags = flags;
+        slot->signature = signature;
+        for (std::string& p : slot->prefix) p.clear();
+    }
+
+    std::string& prefix = slot->prefix[static_cast<int>(level)];
+    if (prefix.empty()) {
+        format_prefix(prefix, flags, level, signature, cache.tag);
+    }
+    return prefix;
+}
+
 std::string logt::get_thread_name() {
     std::unique_lock<std::mutex> lock(thread_mutex_);
     auto it = thread_names_.find(std::this_thread::get_id());
@@ -291,10 +814,91 @@ void logt::worker_thread() {
         channelinfo_.set(0, true); // stdout channel is always registered
     }
 
-    logt_message message;
-    while (logt_eventbus::pop(message)) {
-        write_message(message);
+    // drain in batches, each wake-up of the worker handles everything that piled up
+    std::vector<logt_message> batch;
+    std::vector<std::unique_ptr<logt_chunk>> chunks;
+    logt_message scratch;
+    batch.reserve(logt_eventbus::default_batch);
+
+    bool running = true;
+    while (running) {
+        // only poll the staging buffers while they hold something, idle means no wake-ups
+        auto timeout = logt_staging::pending() ? logt_staging::flush_interval() : std::chrono::milliseconds(0);
+        running = logt_eventbus::pop_batch(batch, chunks, timeout);
+
+        // pick up chunks of threads that stopped logging, and everything left on shutdown
+        logt_staging::collect(chunks, !running);
+
+        for (const logt_message& message : batch) {
+            write_message(message);
+        }
+        for (auto& chunk : chunks) {
+            write_chunk(*chunk, scratch);
+            logt_staging::recycle(std::move(chunk));
+        }
+        flush_sinks(); // one writev per sink for the whole batch
+        batch.clear();
+        chunks.clear();
     }
+
+    // chunks of threads that exited since the last batch, later ones are counted as dropped
+    logt_eventbus::finish(chunks);
+    for (auto& chunk : chunks) {
+        write_chunk(*chunk, scratch);
+    }
+    flush_sinks();
+}
+
+void logt::flush_sinks() {
+    for(int i = 1; i < LOGT_MAX_CHANNEL; i++) {
+        if (!channelinfo_[i]) continue;
+        auto lock = channels_[i].lock();
+        if (channels_[i].type == logt_channel::ChannelType::file_sink && channels_[i].valid) {
+            channels_[i].sink->flush();
+        }
+    }
+}
+
+void logt::write_chunk(const logt_chunk& chunk, logt_message& scratch) {
+    std::string tag; // of the thread that wrote the chunk, looked up for the first deferred record
+    for (const logt_chunk::record& record : chunk.records) {
+        scratch.level = record.level;
+        scratch.channels = record.channels;
+        scratch.timestamp = record.timestamp;
+        if (record.site) {
+            // deferred record, format it now
+            const logt_site& site = *record.site;
+            std::string_view content = chunk.content(record);
+            std::string_view raw = content.substr(record.prefix);
+            if (record.prefix_flags < 0) {
+                scratch.content.assign(content.substr(0, record.prefix)); // written by a custom formatter
+            } else {
+                if (tag.empty()) tag = thread_tag(chunk.owner);
+                scratch.content.clear();
+                format_prefix(scratch.content, record.prefix_flags, record.level, content.substr(0, record.prefix), tag);
+            }
+            scratch.content += site.decode.load(std::memory_order_relaxed)(site.format, raw.data(), raw.size());
+        } else {
+            scratch.content.assign(chunk.content(record)); // reuses the capacity of scratch
+        }
+        write_message(scratch);
+    }
+}
+
+bool logt::channel_accepts(const logt_channel& channel, LogLevel level) {
+    LogLevel filter = filter_level_.load(std::memory_order_relaxed);
+    if (channel.filter != LogLevel::Inherit) filter = channel.filter;
+    return filter != LogLevel::Quiet && level >= filter;
+}
+
+void logt::update_min_level() {
+    // Inherit (16) is above every real level, so it doubles as "nothing passes"
+    LogLevel lowest = LogLevel::Inherit;
+    for (int i = 0; i < LOGT_MAX_CHANNEL; i++) {
+        LogLevel filter = channels_[i].filter != LogLevel::Inherit ? channels_[i].filter : filter_level_.load(std::memory_order_relaxed);
+        if (filter != LogLevel::Quiet && filter < lowest) lowest = filter;
+    }
+    min_level_.store(lowest, std::memory_order_relaxed);
 }
 
 void logt::write_message(const logt_message& message) {
@@ -307,7 +911,7 @@ void logt::write_message(const logt_message& message) {
     // std::unique_lock<std::mutex> lock(file_mutex_); // I don't this this is needed anymore
     std::string timestamp_str = (formatter_.settings.enableTimestamp)?(format_timestamp(message.timestamp) + " "):"";
 
-    if(processed.channels.stdoutput()) {
+    if(processed.channels.stdoutput() && channel_accepts(channels_[0], message.level)) {
         *channels_[0].ostream << timestamp_str << processed.content << std::endl; // keep colors for stdout
     }
 
@@ -316,9 +920,7 @@ void logt::write_message(const logt_message& message) {
             auto lock = channels_[i].lock();
             
             auto& channel = channels_[i];
-            LogLevel filter = filter_level_;
-            if (channel.filter != LogLevel::Inherit) filter = channel.filter;
-            if (message.level < filter) continue; // skip this channel
+            if (!channel_accepts(channel, message.level)) continue; // skip this channel
 
             if (channel.valid) {
                 switch(channel.type) {
@@ -326,6 +928,9 @@ void logt::write_message(const logt_message& message) {
                     channel.fileobj << timestamp_str << message.content << std::endl; // files get unprocessed (no color)
                     channel.fileobj.flush(); ///TODO: change this to something like flush every second, not every message
                     break;
+                case logt_channel::ChannelType::file_sink:
+                    channel.sink->append(timestamp_str, message.content); // unprocessed, written by flush_sinks()
+                    break;
                 case logt_channel::ChannelType::stdcout:
                 case logt_channel::ChannelType::custom_ostream:
                     *channel.ostream << timestamp_str << processed.content << std::endl;
@@ -353,13 +958,24 @@ void logt::write_message(const logt_message& message) {
 // }
 
 std::string logt::format_timestamp(const std::chrono::system_clock::time_point& tp) {
+    // localtime and the date/time formatting only change once per second, keep the
+    // rendered "[YYYY/MM/DD HH:MM:SS" and only append the sub-second part
+    thread_local std::time_t cached_second = -1;
+    thread_local std::string cached_text;
+
     std::time_t currentTime = std::chrono::system_clock::to_time_t(tp);
-    std::tm localTime;
+    if (currentTime != cached_second) {
+        std::tm localTime;
 #ifdef _WIN32
-    localtime_s(&localTime, &currentTime);
+        localtime_s(&localTime, &currentTime);
 #else
-    localtime_r(&currentTime, &localTime);
+        localtime_r(&currentTime, &localTime);
 #endif
+        cached_text = std::format("[{:04d}/{:02d}/{:02d} {:02d}:{:02d}:{:02d}",
+            localTime.tm_year+1900, localTime.tm_mon+1, localTime.tm_mday,
+            localTime.tm_hour, localTime.tm_min, localTime.tm_sec);
+        cached_second = currentTime;
+    }
     
     if (super_timestamp_enabled_) {
         // 高精度时间戳：包含毫秒和微秒
@@ -370,16 +986,24 @@ std::string logt::format_timestamp(const std::chrono::system_clock::time_point&
         int milliseconds = static_cast<int>(micros.count() / 1000);
         int microseconds = micros.count() % 1000;
         
-        return std::format("[{:04d}/{:02d}/{:02d} {:02d}:{:02d}:{:02d}.{:03d}.{:03d}]",
-            localTime.tm_year+1900, localTime.tm_mon+1, localTime.tm_mday,
-            localTime.tm_hour, localTime.tm_min, localTime.tm_sec,
-            milliseconds, microseconds);
+        return cached_text + std::format(".{:03d}.{:03d}]", milliseconds, microseconds);
     } else {
         // 普通时间戳
-        return std::format("[{:04d}/{:02d}/{:02d} {:02d}:{:02d}:{:02d}]",
-            localTime.tm_year+1900, localTime.tm_mon+1, localTime.tm_mday,
-            localTime.tm_hour, localTime.tm_min, localTime.tm_sec);
+        return cached_text + "]";
+    }
+}
+
+std::chrono::system_clock::time_point logt::now() {
+#if defined(__linux__) && defined(CLOCK_REALTIME_COARSE)
+    if (coarse_timestamp_enabled_.load(std::memory_order_relaxed)) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+        auto since_epoch = std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch));
     }
+#endif
+    return std::chrono::system_clock::now();
 }
 
 // Wrapper for steady_clock timestamps: maps to system_clock using current offset.
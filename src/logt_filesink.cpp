@@ -0,0 +1,265 @@
+#include "logt_filesink.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <limits.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #ifndef IOV_MAX
+        #define IOV_MAX 1024
+    #endif
+#endif
+
+
+logt_filesink::logt_filesink(const std::filesystem::path& path, options opt)
+    : path_(path), opt_(std::move(opt))
+{
+    open();
+}
+
+logt_filesink::~logt_filesink() {
+    close();
+}
+
+bool logt_filesink::open() {
+#ifdef _WIN32
+    fd_ = _wopen(path_.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+    struct _stat64 st;
+    file_size_ = (fd_ >= 0 && _fstat64(fd_, &st) == 0) ? static_cast<uint64_t>(st.st_size) : 0;
+#else
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+    file_size_ = (fd_ >= 0 && ::fstat(fd_, &st) == 0) ? static_cast<uint64_t>(st.st_size) : 0;
+#endif
+    if (fd_ < 0) {
+        errors_++;
+        return false;
+    }
+    opened_at_ = std::chrono::system_clock::now();
+    last_sync_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void logt_filesink::append(std::string_view prefix, std::string_view content) {
+    const size_t line = prefix.size() + content.size() + 1;
+
+    if (opt_.max_bytes != 0 && file_size_ + pending_size_ + line > opt_.max_bytes && file_size_ + pending_size_ != 0) {
+        rotate();
+    } else if (opt_.max_age.count() != 0 && std::chrono::system_clock::now() - opened_at_ >= opt_.max_age) {
+        rotate();
+    }
+
+    // continue the last block if the line fits, lines larger than a block get one of their own
+    if (used_blocks_ == 0 || blocks_[used_blocks_ - 1].size() + line > block_size) {
+        if (used_blocks_ == blocks_.size()) {
+            blocks_.emplace_back();
+            blocks_.back().reserve(block_size);
+        }
+        used_blocks_++;
+    }
+
+    std::string& block = blocks_[used_blocks_ - 1];
+    block.append(prefix);
+    block.append(content);
+    block.push_back('\n');
+
+    pending_size_ += line;
+    messages_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void logt_filesink::flush() {
+    if (used_blocks_ == 0) return;
+
+    if (fd_ < 0 && !open()) {
+        // nowhere to write, drop the batch
+        for (size_t i = 0; i < used_blocks_; i++) blocks_[i].clear();
+        used_blocks_ = 0;
+        pending_size_ = 0;
+        return;
+    }
+
+#ifdef _WIN32
+    for (size_t i = 0; i < used_blocks_; i++) {
+        const char* data = blocks_[i].data();
+        size_t left = blocks_[i].size();
+        while (left != 0) {
+            int n = _write(fd_, data, static_cast<unsigned int>(left));
+            writes_.fetch_add(1, std::memory_order_relaxed);
+            if (n <= 0) { errors_++; break; }
+            data += n;
+            left -= static_cast<size_t>(n);
+            file_size_ += static_cast<uint64_t>(n);
+            bytes_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+        }
+    }
+#else
+    std::vector<struct iovec> iov(used_blocks_);
+    for (size_t i = 0; i < used_blocks_; i++) {
+        iov[i].iov_base = blocks_[i].data();
+        iov[i].iov_len = blocks_[i].size();
+    }
+
+    size_t first = 0;
+    while (first < iov.size()) {
+        int count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+        ssize_t n = ::writev(fd_, iov.data() + first, count);
+        writes_.fetch_add(1, std::memory_order_relaxed);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            errors_++;
+            break;
+        }
+        file_size_ += static_cast<uint64_t>(n);
+        bytes_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+
+        // skip what was written, partial writes resume inside an iovec
+        size_t written = static_cast<size_t>(n);
+        while (first < iov.size() && written >= iov[first].iov_len) {
+            written -= iov[first].iov_len;
+            first++;
+        }
+        if (first < iov.size()) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + written;
+            iov[first].iov_len -= written;
+        }
+    }
+#endif
+
+    for (size_t i = 0; i < used_blocks_; i++) blocks_[i].clear();
+    used_blocks_ = 0;
+    pending_size_ = 0;
+
+    sync(opt_.fsync == FsyncPolicy::every_flush);
+}
+
+void logt_filesink::sync(bool force) {
+    if (fd_ < 0 || opt_.fsync == FsyncPolicy::never) return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - last_sync_ < opt_.fsync_interval) return;
+
+#ifdef _WIN32
+    _commit(fd_);
+#elif defined(__APPLE__)
+    ::fsync(fd_);
+#else
+    ::fdatasync(fd_);
+#endif
+    last_sync_ = now;
+    fsyncs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void logt_filesink::rotate() {
+    flush();
+    sync(true);
+
+    if (fd_ >= 0) {
+#ifdef _WIN32
+        _close(fd_);
+#else
+        ::close(fd_);
+#endif
+        fd_ = -1;
+    }
+
+    // app.log -> app.log.20240101-120000 (plus .N if that name is taken)
+    std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), ".%Y%m%d-%H%M%S", &tm);
+
+    std::filesystem::path rotated = path_;
+    rotated += stamp;
+    for (int i = 1; std::filesystem::exists(rotated); i++) {
+        rotated = path_;
+        rotated += stamp + ("." + std::to_string(i));
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(path_, rotated, ec);
+    if (ec) {
+        errors_++;
+    } else {
+        rotations_.fetch_add(1, std::memory_order_relaxed);
+        if (opt_.on_rotate) hand_off(std::move(rotated));
+    }
+
+    open();
+}
+
+void logt_filesink::hand_off(std::filesystem::path rotated) {
+    std::unique_lock<std::mutex> lock(bg_mutex_);
+    if (!background_.joinable()) {
+        bg_stop_ = false;
+        background_ = std::thread(&logt_filesink::background_thread, this);
+    }
+    rotated_.push_back(std::move(rotated));
+    bg_cond_.notify_one();
+}
+
+void logt_filesink::background_thread() {
+    std::unique_lock<std::mutex> lock(bg_mutex_);
+    for (;;) {
+        bg_cond_.wait(lock, [this]() { return !rotated_.empty() || bg_stop_; });
+        if (rotated_.empty()) return; // stopped and nothing left
+
+        std::filesystem::path file = std::move(rotated_.front());
+        rotated_.pop_front();
+
+        lock.unlock();
+        try {
+            opt_.on_rotate(file);
+        } catch (...) {
+            errors_++; // never let a callback take the logger down
+        }
+        lock.lock();
+    }
+}
+
+void logt_filesink::close() {
+    flush();
+
+    if (fd_ >= 0) {
+        sync(true);
+#ifdef _WIN32
+        _close(fd_);
+#else
+        ::close(fd_);
+#endif
+        fd_ = -1;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(bg_mutex_);
+        bg_stop_ = true;
+        bg_cond_.notify_one();
+    }
+    if (background_.joinable()) background_.join();
+}
+
+logt_filesink::stats logt_filesink::statistics() const {
+    stats result;
+    result.messages = messages_.load(std::memory_order_relaxed);
+    result.bytes = bytes_.load(std::memory_order_relaxed);
+    result.writes = writes_.load(std::memory_order_relaxed);
+    result.fsyncs = fsyncs_.load(std::memory_order_relaxed);
+    result.rotations = rotations_.load(std::memory_order_relaxed);
+    result.errors = errors_.load(std::memory_order_relaxed);
+    return result;
+}
@@ -0,0 +1,48 @@
+/*
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx17 - cxx23
+*/
+#include "output_sink.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace scl2 {
+
+void ostream_sink::write(const char *data, size_t size)
+{
+    os.write(data, static_cast<std::streamsize>(size));
+    if (!os) throw std::runtime_error("Failed to write output to stream");
+}
+
+void ostream_sink::flush()
+{
+    os.flush();
+}
+
+void fd_sink::write(const char *data, size_t size)
+{
+    while (size > 0) {
+#if defined(_WIN32) || defined(_WIN64)
+        int n = ::_write(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1u << 30)));
+#else
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n <= 0) throw std::runtime_error(std::string("Failed to write output: ") + std::strerror(errno));
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+} // namespace scl2
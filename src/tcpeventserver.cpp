@@ -0,0 +1,580 @@
+#include "tcpeventserver.hpp"
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+
+namespace network::tcp {
+
+namespace {
+
+// only the loop thread writes a counter, readers need no more than atomicity
+void bump(std::atomic<uint64_t>& counter, uint64_t n = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+} // namespace
+
+// connection
+
+connection::connection(event_server &srv, socket_t socket, client_id id, const sockaddr_in &addr)
+    : m_server(srv), m_socket(socket), m_id(id), m_addr(addr)
+{
+}
+
+network_address connection::address() const
+{
+    char text[INET_ADDRSTRLEN] = {};
+    ::inet_ntop(AF_INET, &m_addr.sin_addr, text, sizeof(text));
+    network_address result;
+    result.address = text;
+    result.__ipv4 = ipv4::from_string(result.address);
+    return result;
+}
+
+bool connection::send(const char *data, size_t size)
+{
+    if (m_closed || m_close_after_write) {
+        return false;
+    }
+
+    // nothing queued: write directly, queue only what the socket does not take
+    if (pending() == 0) {
+        while (size > 0) {
+            ssize_t sent = ::send(m_socket, data, size, MSG_NOSIGNAL);
+            if (sent > 0) {
+                data += sent;
+                size -= static_cast<size_t>(sent);
+                bump(m_server.m_stats.bytes_written, static_cast<uint64_t>(sent));
+                continue;
+            }
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            m_server.closeConnection(*this);
+            return false;
+        }
+    }
+
+    if (size > 0) {
+        if (m_output_pos > 0 && m_output_pos >= m_output.size() / 2) {
+            m_output.erase(0, m_output_pos);
+            m_output_pos = 0;
+        }
+        m_output.append(data, size);
+    }
+    m_server.touch(*this);
+    return true;
+}
+
+bool connection::flush()
+{
+    while (pending() > 0) {
+        ssize_t sent = ::send(m_socket, m_output.data() + m_output_pos, pending(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            m_output_pos += static_cast<size_t>(sent);
+            bump(m_server.m_stats.bytes_written, static_cast<uint64_t>(sent));
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        return false;
+    }
+    // an idle connection keeps no buffer
+    std::string().swap(m_output);
+    m_output_pos = 0;
+    return true;
+}
+
+void connection::close()
+{
+    if (m_closed) return;
+    if (pending() == 0) {
+        m_server.closeConnection(*this);
+    } else {
+        m_close_after_write = true;
+    }
+}
+
+void connection::abort()
+{
+    m_server.closeConnection(*this);
+}
+
+// event_server
+
+event_server::event_server()
+    : m_address(), m_port(0)
+{
+    init();
+    m_address.dummy = true;
+}
+
+event_server::event_server(uint16_t port)
+    : m_address(), m_port(port)
+{
+    init();
+    m_address.dummy = true;
+}
+
+event_server::event_server(network_address address, uint16_t port)
+    : m_address(address), m_port(port)
+{
+    init();
+    m_address.dummy = false;
+}
+
+event_server::~event_server()
+{
+    stop();
+}
+
+void event_server::start()
+{
+    start(m_port);
+}
+
+void event_server::start(uint16_t port)
+{
+    if (m_running) {
+        stop();
+    }
+    m_port = port;
+
+    socket_t listen_socket = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (listen_socket == invalid_socket) {
+        throw network_error("Failed to create socket");
+    }
+
+    int opt = 1;
+    ::setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (m_options.reuse_port && ::setsockopt(listen_socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) {
+        ::close(listen_socket);
+        throw network_error("Failed to set SO_REUSEPORT");
+    }
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_port);
+
+    if (m_address.dummy || m_address.address.empty()) {
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        m_address.address = "0.0.0.0";
+        m_address.__ipv4 = ipv4::from_string(m_address.address);
+        m_address.dummy = false;
+    } else {
+        if (::inet_pton(AF_INET, m_address.address.c_str(), &addr.sin_addr) != 1) {
+            ::close(listen_socket);
+            throw network_error("Invalid IPv4 address");
+        }
+        m_address.__ipv4 = ipv4::from_string(m_address.address);
+    }
+
+    if (::bind(listen_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        ::close(listen_socket);
+        throw network_error("Failed to bind socket");
+    }
+    if (::listen(listen_socket, m_options.backlog) == -1) {
+        ::close(listen_socket);
+        throw network_error("Failed to listen on socket");
+    }
+
+    // port 0: the kernel picked one
+    socklen_t addr_len = sizeof(addr);
+    if (::getsockname(listen_socket, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0) {
+        m_port = ntohs(addr.sin_port);
+    }
+
+    try {
+        openLoop();
+    } catch (...) {
+        ::close(listen_socket);
+        throw;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = &m_listen_socket;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, listen_socket, &ev);
+    m_listen_socket = listen_socket;
+}
+
+void event_server::open()
+{
+    if (m_running) {
+        stop();
+    }
+    openLoop();
+}
+
+void event_server::openLoop()
+{
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll == -1 || m_wake == -1) {
+        if (m_epoll != -1) ::close(m_epoll);
+        if (m_wake != -1) ::close(m_wake);
+        m_epoll = m_wake = -1;
+        throw network_error("Failed to create epoll instance");
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = &m_wake;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &ev);
+
+    m_events.resize(static_cast<size_t>(std::max(m_options.max_events, 1)));
+    m_read_buffer.resize(std::max<size_t>(m_options.read_size, 512));
+    m_running = true;
+}
+
+void event_server::stop()
+{
+    // inside a turn connections are in use, the turn closes them when it is done
+    if (m_in_run || m_in_poll) {
+        m_stop_requested = true;
+        std::lock_guard<std::mutex> guard(m_post_mutex);
+        if (m_wake != -1) {
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t r = ::write(m_wake, &one, sizeof(one));
+        }
+        return;
+    }
+    closeAll();
+}
+
+void event_server::closeAll()
+{
+    runPosted(); // may hold adopt()s, their sockets are closed below
+    while (!m_connections.empty()) {
+        closeConnection(*m_connections.begin()->second);
+    }
+    m_closed.clear();
+    m_read_pending.clear();
+    m_accept_pending = false;
+
+    if (m_listen_socket != invalid_socket) {
+        ::close(m_listen_socket);
+        m_listen_socket = invalid_socket;
+    }
+    if (m_epoll != -1) {
+        ::close(m_epoll);
+        m_epoll = -1;
+    }
+    {
+        // post() from other threads must not write to a reused descriptor
+        std::lock_guard<std::mutex> guard(m_post_mutex);
+        if (m_wake != -1) {
+            ::close(m_wake);
+            m_wake = -1;
+        }
+    }
+    m_running = false;
+}
+
+int event_server::poll(int timeout_ms)
+{
+    if (!m_running) {
+        return -1;
+    }
+
+    m_in_poll = true;
+    int n;
+    try {
+        n = turn(timeout_ms);
+    } catch (...) {
+        m_in_poll = false;
+        throw;
+    }
+    // a stop() during the turn only flagged it, no connection is in use now
+    if (m_stop_requested && !m_in_run) {
+        closeAll();
+        m_stop_requested = false;
+    }
+    m_in_poll = false;
+    return n;
+}
+
+int event_server::turn(int timeout_ms)
+{
+    runPosted();
+
+    // leftovers of the last turn: do not sleep
+    bool busy = m_accept_pending || !m_read_pending.empty();
+    int n = ::epoll_wait(m_epoll, m_events.data(), static_cast<int>(m_events.size()), busy ? 0 : waitTimeout(timeout_ms));
+    if (n < 0) {
+        if (errno != EINTR) throw network_error(std::string("epoll_wait failed: ") + std::strerror(errno));
+        n = 0;
+    }
+    bump(m_stats.wakeups);
+    bump(m_stats.events, static_cast<uint64_t>(n));
+
+    std::vector<connection*> leftover;
+    leftover.swap(m_read_pending);
+    for (connection* c : leftover) c->m_reading = false;
+
+    for (int i = 0; i < n; ++i) {
+        const epoll_event& ev = m_events[static_cast<size_t>(i)];
+        if (ev.data.ptr == &m_listen_socket) {
+            m_accept_pending = true;
+        } else if (ev.data.ptr == &m_wake) {
+            uint64_t count;
+            [[maybe_unused]] ssize_t r = ::read(m_wake, &count, sizeof(count));
+        } else {
+            connection& c = *static_cast<connection*>(ev.data.ptr);
+            if (c.m_closed) continue; // closed earlier in this turn
+            if (ev.events & EPOLLOUT) writable(c);
+            if (!c.m_closed && (ev.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) readBatch(c);
+        }
+    }
+
+    for (connection* c : leftover) {
+        if (!c->m_closed && !c->m_reading) readBatch(*c);
+    }
+    if (m_accept_pending) {
+        acceptBatch();
+    }
+
+    runPosted();
+    if (m_options.idle_timeout.count() > 0) {
+        expireIdle();
+    }
+    m_closed.clear();
+    return n;
+}
+
+void event_server::run()
+{
+    if (!m_running) {
+        return;
+    }
+    m_in_run = true;
+    while (!m_stop_requested) {
+        poll(-1);
+    }
+    closeAll(); // still "in run": a stop() posted meanwhile only sets the flag
+    m_in_run = false;
+    m_stop_requested = false;
+}
+
+void event_server::post(std::function<void()> fn)
+{
+    std::lock_guard<std::mutex> guard(m_post_mutex);
+    m_posted.push_back(std::move(fn));
+    if (m_wake != -1) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t r = ::write(m_wake, &one, sizeof(one));
+    }
+}
+
+void event_server::runPosted()
+{
+    std::vector<std::function<void()>> posted;
+    {
+        std::lock_guard<std::mutex> guard(m_post_mutex);
+        if (m_posted.empty()) return;
+        posted.swap(m_posted);
+    }
+    for (auto& fn : posted) fn();
+}
+
+uint16_t event_server::port() const { return m_port; }
+network_address event_server::address() const { return m_address; }
+
+connection* event_server::find(client_id id)
+{
+    auto it = m_connections.find(id);
+    return it == m_connections.end() ? nullptr : it->second.get();
+}
+
+event_server::statistics event_server::stats() const
+{
+    statistics s;
+    s.accepted = m_stats.accepted.load(std::memory_order_relaxed);
+    s.opened = m_stats.opened.load(std::memory_order_relaxed);
+    s.closed = m_stats.closed.load(std::memory_order_relaxed);
+    s.bytes_read = m_stats.bytes_read.load(std::memory_order_relaxed);
+    s.bytes_written = m_stats.bytes_written.load(std::memory_order_relaxed);
+    s.wakeups = m_stats.wakeups.load(std::memory_order_relaxed);
+    s.events = m_stats.events.load(std::memory_order_relaxed);
+    return s;
+}
+
+void event_server::acceptBatch()
+{
+    m_accept_pending = false;
+    for (int i = 0; i < m_options.accept_batch; ++i) {
+        sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        socket_t fd = ::accept4(m_listen_socket, reinterpret_cast<sockaddr*>(&addr), &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == invalid_socket) {
+            if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO) continue;
+            // EAGAIN: accepted everything. Out of descriptors or memory: the
+            // rest stays in the backlog until the next connection arrives.
+            return;
+        }
+
+        bump(m_stats.accepted);
+
+        if (m_options.no_delay) {
+            int opt = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        }
+
+        if (m_on_accept && m_on_accept(fd, addr)) {
+            continue; // taken over
+        }
+        adopt(fd, addr);
+    }
+    m_accept_pending = true; // batch used up, there may be more
+}
+
+connection* event_server::adopt(socket_t socket, const sockaddr_in &addr)
+{
+    if (!m_running) {
+        ::close(socket);
+        return nullptr;
+    }
+
+    client_id id = m_next_client_id++;
+    std::unique_ptr<connection> c(new connection(*this, socket, id, addr));
+
+    // registered once for both directions, edge-triggered
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = c.get();
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &ev) == -1) {
+        ::close(socket);
+        return nullptr;
+    }
+
+    connection& ref = *c;
+    m_connections.emplace(id, std::move(c));
+    bump(m_stats.opened);
+    touch(ref);
+    if (m_on_connect) m_on_connect(ref);
+    return &ref;
+}
+
+void event_server::readBatch(connection &c)
+{
+    size_t budget = m_options.read_budget;
+    while (!c.m_closed) {
+        if (budget == 0) {
+            // more may be waiting, but edge-triggered epoll will not say so again
+            c.m_reading = true;
+            m_read_pending.push_back(&c);
+            return;
+        }
+        ssize_t n = ::recv(c.m_socket, m_read_buffer.data(), m_read_buffer.size(), 0);
+        if (n > 0) {
+            budget -= std::min(budget, static_cast<size_t>(n));
+            bump(m_stats.bytes_read, static_cast<uint64_t>(n));
+            if (c.m_close_after_write) continue; // closing, input is dropped
+            touch(c);
+            if (m_on_data) m_on_data(c, std::string_view(m_read_buffer.data(), static_cast<size_t>(n)));
+            continue;
+        }
+        if (n == 0) {
+            c.close(); // peer is done sending, queued output still goes out
+            return;
+        }
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(c);
+        return;
+    }
+}
+
+void event_server::writable(connection &c)
+{
+    bool had_output = c.pending() > 0;
+    if (!c.flush()) {
+        closeConnection(c);
+        return;
+    }
+    if (!had_output || c.pending() > 0) {
+        return;
+    }
+    if (c.m_close_after_write) {
+        closeConnection(c);
+    } else if (m_on_drain) {
+        m_on_drain(c);
+    }
+}
+
+void event_server::closeConnection(connection &c)
+{
+    if (c.m_closed) {
+        return;
+    }
+    c.m_closed = true;
+    unlink(c);
+    if (c.m_reading) {
+        std::erase(m_read_pending, &c);
+        c.m_reading = false;
+    }
+    ::close(c.m_socket); // also leaves the epoll set
+    bump(m_stats.closed);
+
+    if (m_on_close) m_on_close(c);
+
+    // freed after the current turn, events of this turn may still point to it
+    auto it = m_connections.find(c.m_id);
+    if (it != m_connections.end()) {
+        m_closed.push_back(std::move(it->second));
+        m_connections.erase(it);
+    }
+}
+
+void event_server::touch(connection &c)
+{
+    if (m_options.idle_timeout.count() <= 0 || c.m_closed) {
+        return;
+    }
+    c.m_last_active = std::chrono::steady_clock::now();
+    if (m_idle_tail == &c) {
+        return;
+    }
+    unlink(c);
+    c.m_idle_prev = m_idle_tail;
+    if (m_idle_tail) m_idle_tail->m_idle_next = &c;
+    else m_idle_head = &c;
+    m_idle_tail = &c;
+}
+
+void event_server::unlink(connection &c)
+{
+    if (c.m_idle_prev) c.m_idle_prev->m_idle_next = c.m_idle_next;
+    else if (m_idle_head == &c) m_idle_head = c.m_idle_next;
+    if (c.m_idle_next) c.m_idle_next->m_idle_prev = c.m_idle_prev;
+    else if (m_idle_tail == &c) m_idle_tail = c.m_idle_prev;
+    c.m_idle_prev = c.m_idle_next = nullptr;
+}
+
+void event_server::expireIdle()
+{
+    auto now = std::chrono::steady_clock::now();
+    while (m_idle_head && now - m_idle_head->m_last_active >= m_options.idle_timeout) {
+        closeConnection(*m_idle_head);
+    }
+}
+
+int event_server::waitTimeout(int timeout_ms) const
+{
+    if (m_options.idle_timeout.count() <= 0 || m_idle_head == nullptr) {
+        return timeout_ms;
+    }
+    auto left = m_idle_head->m_last_active + m_options.idle_timeout - std::chrono::steady_clock::now();
+    int idle_ms = static_cast<int>(std::max<int64_t>(0, std::chrono::ceil<std::chrono::milliseconds>(left).count()));
+    return timeout_ms < 0 ? idle_ms : std::min(timeout_ms, idle_ms);
+}
+
+} // namespace network::tcp
+
+#endif // __linux__
@@ -0,0 +1,224 @@
+#include "tcpmultiserver.hpp"
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <string>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace network::tcp {
+
+multi_server::multi_server()
+    : m_address(), m_port(0)
+{
+    init();
+    m_address.dummy = true;
+}
+
+multi_server::multi_server(uint16_t port)
+    : m_address(), m_port(port)
+{
+    init();
+    m_address.dummy = true;
+}
+
+multi_server::multi_server(network_address address, uint16_t port)
+    : m_address(address), m_port(port)
+{
+    init();
+    m_address.dummy = false;
+}
+
+multi_server::~multi_server()
+{
+    stop();
+    wait();
+}
+
+void multi_server::start()
+{
+    start(m_port);
+}
+
+void multi_server::start(uint16_t port)
+{
+    stop();
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_state_mutex);
+        m_starting = true;
+        m_stop_pending = false;
+    }
+    m_reactors.clear();
+    m_port = port;
+
+    std::vector<int> cpus;
+    size_t count = 0;
+    bool handoff = m_options.mode == distribution::handoff;
+
+    try {
+        cpus = m_options.cpus.empty() ? allowedCpus() : m_options.cpus;
+        for (int cpu : cpus) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                throw network_error("Invalid CPU number " + std::to_string(cpu));
+            }
+        }
+        count = m_options.threads > 0 ? m_options.threads : std::max<size_t>(cpus.size(), 1);
+
+        for (size_t i = 0; i < count; ++i) {
+            auto r = m_address.dummy ? std::make_unique<event_server>(m_port)
+                                     : std::make_unique<event_server>(m_address, m_port);
+            r->config() = m_options.reactor;
+            r->config().reuse_port = !handoff && count > 1;
+            r->onConnect(m_on_connect);
+            r->onData(m_on_data);
+            r->onClose(m_on_close);
+            r->onDrain(m_on_drain);
+
+            if (handoff && i > 0) {
+                r->open();
+            } else {
+                r->start(m_port);
+                m_port = r->port(); // the one picked for port 0, shared by the others
+            }
+            m_reactors.push_back(std::move(r));
+        }
+    } catch (...) {
+        m_reactors.clear(); // not running yet, closes what was opened
+        std::lock_guard<std::mutex> lock(m_state_mutex);
+        m_starting = false;
+        throw;
+    }
+
+    if (handoff && count > 1) {
+        m_next_reactor = 0;
+        m_reactors[0]->onAccept([this](socket_t socket, const sockaddr_in& addr) {
+            size_t target = m_next_reactor++ % m_reactors.size();
+            if (target == 0) {
+                return false;
+            }
+            event_server* r = m_reactors[target].get();
+            r->post([r, socket, addr] { r->adopt(socket, addr); });
+            return true;
+        });
+    }
+
+    std::lock_guard<std::mutex> lock(m_state_mutex);
+    m_starting = false;
+    m_running = true;
+    for (size_t i = 0; i < count; ++i) {
+        spawn(i, m_options.pin && !cpus.empty() ? cpus[i % cpus.size()] : -1);
+    }
+    // a stop() from another thread during the setup above
+    if (m_stop_pending) {
+        m_stop_pending = false;
+        stopReactors();
+    }
+}
+
+void multi_server::spawn(size_t index, int cpu)
+{
+    m_threads.emplace_back([this, index, cpu] {
+        if (cpu >= 0) {
+            // best effort: a CPU that is offline or not allowed leaves the thread unpinned
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+        }
+        m_reactors[index]->run();
+
+        // handoff: the others stop after the acceptor, so no socket is
+        // handed to a reactor that is gone. post() keeps the order.
+        if (index == 0 && m_options.mode == distribution::handoff) {
+            for (size_t i = 1; i < m_reactors.size(); ++i) {
+                event_server* r = m_reactors[i].get();
+                r->post([r] { r->stop(); });
+            }
+        }
+    });
+}
+
+void multi_server::stop()
+{
+    std::lock_guard<std::mutex> lock(m_state_mutex);
+    if (m_starting) {
+        m_stop_pending = true;
+        return;
+    }
+    stopReactors();
+}
+
+void multi_server::stopReactors()
+{
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    // run on each loop thread, where stop() only flags the loop
+    size_t count = m_options.mode == distribution::handoff ? 1 : m_reactors.size();
+    for (size_t i = 0; i < count; ++i) {
+        event_server* r = m_reactors[i].get();
+        r->post([r] { r->stop(); });
+    }
+}
+
+void multi_server::wait()
+{
+    for (auto& t : m_threads) {
+        if (t.joinable()) t.join();
+    }
+    m_threads.clear();
+}
+
+network_address multi_server::address() const
+{
+    return m_reactors.empty() ? m_address : m_reactors.front()->address();
+}
+
+std::vector<event_server::statistics> multi_server::stats() const
+{
+    std::vector<event_server::statistics> result;
+    result.reserve(m_reactors.size());
+    for (const auto& r : m_reactors) {
+        result.push_back(r->stats());
+    }
+    return result;
+}
+
+event_server::statistics multi_server::total() const
+{
+    event_server::statistics sum;
+    for (const auto& s : stats()) {
+        sum.accepted += s.accepted;
+        sum.opened += s.opened;
+        sum.closed += s.closed;
+        sum.bytes_read += s.bytes_read;
+        sum.bytes_written += s.bytes_written;
+        sum.wakeups += s.wakeups;
+        sum.events += s.events;
+    }
+    return sum;
+}
+
+std::vector<int> multi_server::allowedCpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+    if (cpus.empty()) {
+        unsigned n = std::max(std::thread::hardware_concurrency(), 1u);
+        for (unsigned cpu = 0; cpu < n; ++cpu) cpus.push_back(static_cast<int>(cpu));
+    }
+    return cpus;
+}
+
+} // namespace network::tcp
+
+#endif // __linux__
@@ -3,10 +3,23 @@
     As part of SharedCppLib2 project.
 */
 #include "xml.hpp"
+#include "xml_writer.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
 #include <functional>
 #include <sstream>
 
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SCL2_XML_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SCL2_XML_SSE2
+#endif
+
 namespace xml
 {
 
@@ -220,428 +233,567 @@ void node::removeNamespace()
     xmlns.reset();
 }
 
-std::string node::deserialize(const std::string &node_text, bool preserve_whitespace)
+/*
+    Single pass parser behind document::deserialize() and node::deserialize().
+
+    A cursor walks the input once. Open elements are kept on an explicit stack
+    instead of recursing, and every name, attribute value and text run is
+    copied out of the input exactly once, with entity references decoded in
+    the same copy. '<', '&' and quote characters are located 32 or 16 bytes
+    at a time with AVX2/SSE2 when the compiler targets them.
+
+    The tree is the one the substring based parser used to build, including
+    its conventions: text between children goes to text_content (the last run
+    wins), whitespace is trimmed unless xml:space="preserve", and whitespace
+    right after a self-closing child is dropped.
+*/
+namespace {
+
+#if defined(SCL2_XML_AVX2)
+
+// next `a` or `b`
+inline const char* xscan2(const char* p, const char* end, char a, char b)
 {
-    // uh,
-    reset(); // clears everything on this planet
-
-    const std::string &working_text = node_text;
-    // std::stringstream working_set(node_text);
-
-    // find the tag structure <name>, possibly with attributes.
-    // Also, if self-closing, actually get the full tag.
-    // while(true) { // we may need to retry for a few times before we get a valid line, so use a loop
-    //     // get a single line
-    //     std::getline(working_set, working_text);
-    //
-    //     working_text = trimString(working_text);
-    //     // check for starting '<' and ending '>'
-    //
-    //     // empty line or only spaces, ignore
-    //     if(working_text.empty()) {
-    //         continue; // get the next line
-    //     }
-    //
-    //     // find the starting '<'
-    //     if(!working_text.starts_with('<')) {
-    //         throw parsing_error("Node text does not start with '<'");
-    //     }
-    //
-    //     // find the ending '>'
-    //     size_t end_pos = working_text.find('>');
-    //     if(end_pos == std::string::npos) {
-    //         // try append following lines, until we find a ending '>'
-    //         while(true) {
-    //             std::string next_line;
-    //             if(std::getline(working_set, next_line)) {
-    //                 working_text += " " + trimString(next_line);
-    //                 end_pos = working_text.find('>');
-    //                 if(end_pos != std::string::npos) {
-    //                     break; // found it
-    //                 }
-    //             } else {
-    //                 // no more lines, still not found
-    //                 // then clearly I'm not able to parse this
-    //                 throw parsing_error("Node text does not end with '>'");
-    //             }
-    //         }
-    //     }
-    //     break; // got a valid working_text containing a full tag
-    // }
-
-    // find tag start and end
-    size_t tag_start = working_text.find('<');
-    if(tag_start == std::string::npos) {
-        throw parsing_error("Node text does not start with '<'");
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t hits = uint32_t(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb))));
+        if (hits) return p + std::countr_zero(hits);
+        p += 32;
     }
+    while (p < end && *p != a && *p != b) ++p;
+    return p;
+}
 
-    // handle comment <!-- ... -->
-    if (working_text.substr(tag_start, 4) == "<!--") {
-        size_t comment_end = working_text.find("-->", tag_start + 4);
-        if (comment_end == std::string::npos) {
-            throw parsing_error("Unclosed comment");
-        }
-        *this = create_comment(working_text.substr(tag_start + 4, comment_end - tag_start - 4));
-        return working_text.substr(comment_end + 3);
+// next character escapeTextContent() replaces
+inline const char* xscan_escape(const char* p, const char* end)
+{
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')))));
+        uint32_t hits = uint32_t(_mm256_movemask_epi8(hit));
+        if (hits) return p + std::countr_zero(hits);
+        p += 32;
     }
+    while (p < end && *p != '&' && *p != '<' && *p != '>' && *p != '"' && *p != '\'') ++p;
+    return p;
+}
 
-    // handle processing instruction <?target data?>
-    if (working_text.substr(tag_start, 2) == "<?") {
-        size_t pi_end = working_text.find("?>", tag_start + 2);
-        if (pi_end == std::string::npos) {
-            throw parsing_error("Unclosed processing instruction");
-        }
-        std::string pi_content = working_text.substr(tag_start + 2, pi_end - tag_start - 2);
-        size_t space_pos = pi_content.find_first_of(" \t");
-        std::string pi_target, pi_data;
-        if (space_pos == std::string::npos) {
-            pi_target = pi_content;
-        } else {
-            pi_target = pi_content.substr(0, space_pos);
-            pi_data = trimString(pi_content.substr(space_pos + 1));
-        }
-        *this = create_processing_instruction(pi_target, pi_data);
-        return working_text.substr(pi_end + 2);
+#elif defined(SCL2_XML_SSE2)
+
+// next `a` or `b`
+inline const char* xscan2(const char* p, const char* end, char a, char b)
+{
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t hits = uint32_t(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb))));
+        if (hits) return p + std::countr_zero(hits);
+        p += 16;
     }
+    while (p < end && *p != a && *p != b) ++p;
+    return p;
+}
 
-    size_t end_pos = working_text.find('>', tag_start);
-    if(end_pos == std::string::npos) {
-        throw parsing_error("Node text does not end with '>'");
+// next character escapeTextContent() replaces
+inline const char* xscan_escape(const char* p, const char* end)
+{
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('&')), _mm_cmpeq_epi8(v, _mm_set1_epi8('<'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('>')),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\'')))));
+        uint32_t hits = uint32_t(_mm_movemask_epi8(hit));
+        if (hits) return p + std::countr_zero(hits);
+        p += 16;
     }
+    while (p < end && *p != '&' && *p != '<' && *p != '>' && *p != '"' && *p != '\'') ++p;
+    return p;
+}
 
-    // first, check if there IS a name
-    size_t name_start = working_text.find_first_not_of(" \t\r\n", tag_start + 1);
-    if(name_start == std::string::npos || name_start >= end_pos) {
-        throw parsing_error("Node name is missing");
+#else
+
+// next `a` or `b`
+inline const char* xscan2(const char* p, const char* end, char a, char b)
+{
+    while (p < end && *p != a && *p != b) ++p;
+    return p;
+}
+
+// next character escapeTextContent() replaces
+inline const char* xscan_escape(const char* p, const char* end)
+{
+    while (p < end && *p != '&' && *p != '<' && *p != '>' && *p != '"' && *p != '\'') ++p;
+    return p;
+}
+
+#endif
+
+inline bool xis_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline std::string_view xtrim(std::string_view s)
+{
+    while (!s.empty() && xis_space(s.front())) s.remove_prefix(1);
+    while (!s.empty() && xis_space(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+void xappend_utf8(std::string& out, char32_t c)
+{
+    if (c <= 0x7F) {
+        out += static_cast<char>(c);
+    } else if (c <= 0x7FF) {
+        out += static_cast<char>(0xC0 | ((c >> 6) & 0x1F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c <= 0xFFFF) {
+        out += static_cast<char>(0xE0 | ((c >> 12) & 0x0F));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | ((c >> 18) & 0x07));
+        out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
     }
-    size_t name_end = working_text.find_first_of(" \t\r\n/>", name_start);
-    if(name_end == std::string::npos || name_end <= name_start) {
-        throw parsing_error("Node name is missing");
+}
+
+// the reference starting at s[0] == '&', false if it is not one we know (then it is kept as is)
+bool xdecode_reference(std::string_view s, std::string& out, size_t& length)
+{
+    const size_t semi = s.substr(0, 12).find(';');
+    if (semi == std::string_view::npos) return false;
+    const std::string_view name = s.substr(1, semi - 1);
+    length = semi + 1;
+
+    if (name == "lt")   { out += '<'; return true; }
+    if (name == "gt")   { out += '>'; return true; }
+    if (name == "amp")  { out += '&'; return true; }
+    if (name == "quot") { out += '"'; return true; }
+    if (name == "apos") { out += '\''; return true; }
+
+    if (name.size() < 2 || name[0] != '#') return false;
+    const bool hex = name[1] == 'x';
+    const std::string_view digits = name.substr(hex ? 2 : 1);
+    uint32_t code = 0;
+    auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), code, hex ? 16 : 10);
+    if (digits.empty() || ec != std::errc() || ptr != digits.data() + digits.size() || code > 0x10FFFF) return false;
+    xappend_utf8(out, static_cast<char32_t>(code));
+    return true;
+}
+
+// `s` with entity and character references decoded in one pass, so "&amp;lt;" stays "&lt;"
+void xassign_unescaped(std::string& out, std::string_view s)
+{
+    const char* p = s.data();
+    const char* end = p + s.size();
+    const char* amp = static_cast<const char*>(std::memchr(p, '&', s.size()));
+    if (!amp) {
+        out.assign(s);
+        return;
     }
+    out.clear();
+    out.reserve(s.size());
+    while (amp) {
+        out.append(p, amp);
+        size_t length = 0;
+        if (xdecode_reference(std::string_view(amp, end - amp), out, length)) {
+            p = amp + length;
+        } else {
+            out += '&';
+            p = amp + 1;
+        }
+        amp = static_cast<const char*>(std::memchr(p, '&', end - p));
+    }
+    out.append(p, end);
+}
 
-    // extract name (with possible namespace prefix at this point)
-    std::string full_name = working_text.substr(name_start, name_end - name_start);
+} // namespace
 
-    // check for namespace prefix
-    std::map<std::string, std::string> pending_namespaces; // prefix -> uri
+class parser {
+public:
+    explicit parser(std::string_view text) : text(text) {}
 
-    // parse attributes and possible namespace declarations
-    size_t attr_pos = name_end;
-    [&]() {
-        std::stringstream attr_stream(working_text.substr(attr_pos, end_pos - attr_pos));
-        while(true) {
-            // skip spaces
-            char ch;
-            do {
-                attr_stream.get(ch);
-                if(attr_stream.eof() || ch == '>' || ch == '/') {
-                    return; // exit the lambda
-                }
-            } while(ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n');
+    void parseDocument(document& doc);
 
-            attr_stream.unget(); // put back the last read character
+    // One node at the first '<', like node::deserialize(). Returns whether it
+    // was a self-closing element; position() is right behind the node.
+    bool parseNode(node& out, bool preserve_whitespace);
 
-            // read attribute name
-            std::string attr_name;
-            std::getline(attr_stream, attr_name, '=');
-            attr_name = trimString(attr_name);
-            if(attr_name.empty()) {
-                throw parsing_error("Attribute name is missing");
-            }
+    size_t position() const { return pos; }
 
-            // '=' was consumed by getline(..., '=') above, no need to read it again
+private:
+    struct open_element {
+        node* element;
+        std::string_view qname; // for the end tag
+        bool preserve;
+    };
 
-            // read attribute value
-            char quote_char;
-            attr_stream.get(quote_char);
-            if(quote_char != '"' && quote_char != '\'') {
-                throw parsing_error("Attribute value must start with a quote");
-            }
+    bool startTag(node& n, bool& preserve, std::string_view& qname); // true if self-closing
+    void content(node& root, std::string_view qname, bool preserve); // children up to the end tag of `root`
+    void endTag(std::string_view qname);
+    node processingInstruction(bool trim_data);
+    node comment();
+    node cdata();
 
-            std::string attr_value;
-            std::getline(attr_stream, attr_value, quote_char);
-
-            // check if this is a namespace declaration
-            if(attr_name == "xmlns") {
-                // default namespace
-                pending_namespaces[""] = attr_value;
-            } else if(attr_name.starts_with("xmlns:")) {
-                std::string ns_prefix = attr_name.substr(6);
-                pending_namespaces[ns_prefix] = attr_value;
-            } else {
-                // normal attribute
-                // attribute name may also have namespace prefix,
-                // in that case it is automatically parsed by qualified_name,
-                // which is now the key type of attributes map.
-                attributes[qualified_name(attr_name)] = unescapeTextContent(attr_value);
-            }
-        }
-        
-    }(); // call it
+    void skipSpace() { while (pos < text.size() && xis_space(text[pos])) ++pos; }
+    bool startsWith(std::string_view s) const { return text.substr(pos, s.size()) == s; }
 
-    // resolve namespaces
-    if(!pending_namespaces.empty()) {
-        for(const auto &ns : pending_namespaces) {
-            declareNamespace(ns.first, ns.second);
+    std::string_view text;
+    size_t pos = 0;
+    std::vector<open_element> stack;
+};
+
+void parser::parseDocument(document &doc)
+{
+    doc.reset();
+    pos = 0;
+
+    if (startsWith("<?xml")) {
+        size_t end = text.find("?>", pos);
+        if (end == std::string_view::npos) throw parsing_error("Unclosed XML declaration");
+        doc.xml_declaration = std::string(text.substr(0, end + 2));
+        pos = end + 2;
+    }
+    skipSpace();
+
+    if (startsWith("<!DOCTYPE")) {
+        // an internal subset in [...] may contain '>'
+        size_t i = pos + 9;
+        char quote = 0;
+        int brackets = 0;
+        for (; i < text.size(); ++i) {
+            const char c = text[i];
+            if (quote) { if (c == quote) quote = 0; }
+            else if (c == '"' || c == '\'') quote = c;
+            else if (c == '[') ++brackets;
+            else if (c == ']') --brackets;
+            else if (c == '>' && brackets <= 0) break;
         }
+        if (i >= text.size()) throw parsing_error("Unclosed DOCTYPE declaration");
+        doc.doctype_declaration = std::string(text.substr(pos, i - pos + 1));
+        pos = i + 1;
     }
 
-    // resolve node namespace
-    {
-        size_t colon_pos = full_name.find(':');
-        if(colon_pos != std::string::npos) {
-            // has namespace prefix
-            std::string prefix = full_name.substr(0, colon_pos);
-            std::string local_name = full_name.substr(colon_pos + 1);
-            
-            if(decl_xmlns.has_value()) {
-                for(const auto &ns : decl_xmlns.value()) {
-                    if(ns.prefix.has_value() && ns.prefix.value() == prefix) {
-                        xmlns = ns;
-                        break;
-                    }
-                }
-            }
-            // also check inherited namespaces from ancestors
-            if(!xmlns.has_value() && inherited_xmlns.has_value()) {
-                for(const auto &ns : inherited_xmlns.value()) {
-                    if(ns.prefix.has_value() && ns.prefix.value() == prefix) {
-                        xmlns = ns;
-                        break;
-                    }
-                }
-            }
+    // comments and processing instructions before the root element have no place in the tree
+    while (true) {
+        skipSpace();
+        if (startsWith("<!--")) comment();
+        else if (startsWith("<?")) processingInstruction(false);
+        else break;
+    }
 
-            if(!xmlns.has_value()) {
-                throw parsing_error("Namespace prefix '" + prefix + "' not declared");
-            }
+    parseNode(doc.root_node, false);
+}
 
-            name = local_name;
-        } else {
-            name = full_name;
-        }
+bool parser::parseNode(node &out, bool preserve_whitespace)
+{
+    out.reset(); // keeps inherited_xmlns, they resolve our prefixes
+
+    const size_t lt = text.find('<', pos);
+    if (lt == std::string_view::npos) {
+        throw parsing_error("Node text does not start with '<'");
     }
+    pos = lt;
 
-    // check if self-closing
-    if(working_text[end_pos - 1] == '/') {
-        self_closing = true;
-        // we are done here, but we need to remove the end tag
-        // before returning the remaining text.
+    if (startsWith("<!--")) {
+        out = comment();
+        return false;
+    }
+    if (startsWith("<?")) {
+        out = processingInstruction(true);
+        return false;
+    }
 
-        std::string remaining_text = working_text.substr(end_pos + 1);
-        remaining_text = trimString(remaining_text);
-        return remaining_text;
-    } else {
-        self_closing = false;
+    bool preserve = preserve_whitespace;
+    std::string_view qname;
+    if (startTag(out, preserve, qname)) return true;
+    content(out, qname, preserve);
+    return false;
+}
+
+bool parser::startTag(node &n, bool &preserve, std::string_view &qname)
+{
+    ++pos; // '<'
+    skipSpace();
+    const size_t name_start = pos;
+    while (pos < text.size() && !xis_space(text[pos]) && text[pos] != '/' && text[pos] != '>') ++pos;
+    if (pos == name_start || pos >= text.size()) {
+        throw parsing_error("Node name is missing");
     }
+    const std::string_view full_name = text.substr(name_start, pos - name_start);
+    qname = full_name;
 
-    // extract text content if any
-    // note that in theory, working_text only contains the tag part,
-    // so we need to append whatever remains in working_set to working_text.
-    // std::
-    std::string remaining_text = working_text.substr(end_pos + 1);
+    std::vector<std::pair<std::string, std::string>> pending_namespaces; // prefix -> uri
+    bool self_closing = false;
+    const char* const end = text.data() + text.size();
 
-    // check for xml:space="preserve" on this element
-    bool child_preserve = preserve_whitespace;
-    {
-        auto it = attributes.find(qualified_name("xml:space"));
-        if (it != attributes.end()) {
-            child_preserve = (it->second == "preserve");
+    while (true) {
+        skipSpace();
+        if (pos >= text.size()) {
+            throw parsing_error("Node text does not end with '>'");
+        }
+        if (text[pos] == '>') {
+            ++pos;
+            break;
+        }
+        if (text[pos] == '/') {
+            if (pos + 1 >= text.size() || text[pos + 1] != '>') {
+                throw parsing_error("Expected '>' after '/'");
+            }
+            pos += 2;
+            self_closing = true;
+            break;
+        }
+
+        const size_t attr_start = pos;
+        while (pos < text.size() && text[pos] != '=' && !xis_space(text[pos]) && text[pos] != '>' && text[pos] != '/') ++pos;
+        const std::string_view attr_name = text.substr(attr_start, pos - attr_start);
+        if (attr_name.empty()) {
+            throw parsing_error("Attribute name is missing");
+        }
+        skipSpace();
+        if (pos >= text.size() || text[pos] != '=') {
+            throw parsing_error("Expected '=' after attribute name '" + std::string(attr_name) + "'");
+        }
+        ++pos;
+        skipSpace();
+        if (pos >= text.size() || (text[pos] != '"' && text[pos] != '\'')) {
+            throw parsing_error("Attribute value must start with a quote");
+        }
+        const char quote = text[pos++];
+
+        // the quote, passing over '&' on the way: then the value has references
+        const char* p = text.data() + pos;
+        bool has_reference = false;
+        while (true) {
+            p = xscan2(p, end, quote, '&');
+            if (p == end) throw parsing_error("Unterminated value of attribute '" + std::string(attr_name) + "'");
+            if (*p == quote) break;
+            has_reference = true;
+            ++p;
+        }
+        const std::string_view raw = text.substr(pos, static_cast<size_t>(p - text.data()) - pos);
+        pos = static_cast<size_t>(p - text.data()) + 1;
+
+        if (attr_name == "xmlns") {
+            pending_namespaces.emplace_back(std::string(), std::string(raw));
+        } else if (attr_name.starts_with("xmlns:")) {
+            pending_namespaces.emplace_back(std::string(attr_name.substr(6)), std::string(raw));
+        } else {
+            std::string& value = n.attributes[qualified_name(attr_name)];
+            if (has_reference) xassign_unescaped(value, raw);
+            else value.assign(raw);
         }
     }
 
-    if (!child_preserve) {
-        remaining_text = trimString(remaining_text);
-    }
-    if(!remaining_text.empty()) {
-        while(true) { // we may need to look for multiple children or text content, before we find the end tag
-            // check the type of the next content
-            if(remaining_text.starts_with("</")) {
-                // end tag. will be parsed after this if-else.
-                break;
-            } else if(remaining_text.starts_with("<![CDATA[")) {
-                // CDATA section
-                size_t cdata_end = remaining_text.find("]]>", 9);
-                if (cdata_end == std::string::npos) {
-                    throw parsing_error("Unclosed CDATA section");
-                }
-                node cdata_node;
-                cdata_node.type_ = Type::Text;
-                cdata_node.text_content = remaining_text.substr(9, cdata_end - 9);
-                if (!children.has_value()) {
-                    children = std::vector<node>();
-                }
-                children->push_back(std::move(cdata_node));
-                remaining_text = remaining_text.substr(cdata_end + 3);
-            } else if(remaining_text.starts_with("<?")) {
-                // processing instruction as child
-                size_t pi_end = remaining_text.find("?>", 2);
-                if (pi_end == std::string::npos) {
-                    throw parsing_error("Unclosed processing instruction");
-                }
-                std::string pi_content = remaining_text.substr(2, pi_end - 2);
-                size_t space_pos = pi_content.find_first_of(" \t");
-                std::string pi_target, pi_data;
-                if (space_pos == std::string::npos) {
-                    pi_target = pi_content;
-                } else {
-                    pi_target = pi_content.substr(0, space_pos);
-                    pi_data = pi_content.substr(space_pos + 1);
-                }
-                node pi_node = create_processing_instruction(pi_target, pi_data);
-                if (!children.has_value()) {
-                    children = std::vector<node>();
-                }
-                children->push_back(std::move(pi_node));
-                remaining_text = remaining_text.substr(pi_end + 2);
-            } else if(remaining_text.starts_with('<')) {
-                // then it's children.
-                node child_node;
-                // pass down namespace context: inherited + currently declared
-                if(decl_xmlns.has_value() || inherited_xmlns.has_value()) {
-                    child_node.inherited_xmlns = std::vector<xnamespace>();
-                    if(inherited_xmlns.has_value()) {
-                        child_node.inherited_xmlns->insert(child_node.inherited_xmlns->end(), inherited_xmlns->begin(), inherited_xmlns->end());
-                    }
-                    if(decl_xmlns.has_value()) {
-                        child_node.inherited_xmlns->insert(child_node.inherited_xmlns->end(), decl_xmlns->begin(), decl_xmlns->end());
-                    }
-                }
-                std::string rt = child_node.deserialize(remaining_text, child_preserve);
-                
-                // add to children
-                if(!children.has_value()) {
-                    children = std::vector<node>();
-                }
-                children->push_back(child_node);
-                remaining_text = rt;
-            } else {
-                // text content
-                size_t next_tag_pos = remaining_text.find('<');
-                if(next_tag_pos == std::string::npos) {
-                    throw parsing_error("End tag </" + full_name + "> not found");
-                }
+    // declared in prefix order, a repeated prefix keeps its last uri
+    if (!pending_namespaces.empty()) {
+        std::stable_sort(pending_namespaces.begin(), pending_namespaces.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < pending_namespaces.size(); ++i) {
+            if (i + 1 < pending_namespaces.size() && pending_namespaces[i + 1].first == pending_namespaces[i].first) continue;
+            n.declareNamespace(pending_namespaces[i].first, pending_namespaces[i].second);
+        }
+    }
 
-                std::string text = remaining_text.substr(0, next_tag_pos);
-                if (child_preserve) {
-                    text_content = unescapeTextContent(text);
-                } else {
-                    text_content = unescapeTextContent(trimString(text));
+    const size_t colon = full_name.find(':');
+    if (colon != std::string_view::npos) {
+        const std::string_view prefix = full_name.substr(0, colon);
+        auto find = [&](const std::optional<std::vector<xnamespace>>& list) {
+            if (!list.has_value()) return false;
+            for (const auto& ns : list.value()) {
+                if (ns.prefix.has_value() && ns.prefix.value() == prefix) {
+                    n.xmlns = ns;
+                    return true;
                 }
-                remaining_text = remaining_text.substr(next_tag_pos);
             }
+            return false;
+        };
+        if (!find(n.decl_xmlns) && !find(n.inherited_xmlns)) {
+            throw parsing_error("Namespace prefix '" + std::string(prefix) + "' not declared");
         }
+        n.name = std::string(full_name.substr(colon + 1));
+    } else {
+        n.name = std::string(full_name);
+    }
 
-        // check for end tag
-        std::string end_tag = "</" + full_name + ">";
-        size_t end_tag_pos = remaining_text.find(end_tag);
-        if(end_tag_pos == std::string::npos) {
-            throw parsing_error("End tag " + end_tag + " not found");
-        }
+    n.self_closing = self_closing;
 
-        // remove end tag from remaining text
-        remaining_text = remaining_text.substr(remaining_text.find('>') + 1);
+    auto space = n.attributes.find(qualified_name("xml:space"));
+    if (space != n.attributes.end()) {
+        preserve = space->second == "preserve";
     }
-
-    // If any more text is remaining, we simply return it.
-    // In this case it may belongs to sibling nodes, which is not our concern here.
-    return remaining_text;
+    return self_closing;
 }
 
-std::string node::serialize(int alignDepth) const
+void parser::content(node &root, std::string_view qname, bool preserve)
 {
-    std::string result;
-    // Comment node
-    if (is_comment()) {
-        return makeTab(alignDepth) + "<!--" + text_content.value_or("") + "-->";
-    }
+    stack.clear();
+    stack.push_back(open_element{&root, qname, preserve});
 
-    // Text node
-    if (is_text()) {
-        return escapeTextContent(text_content.value_or(""));
-    }
+    const char* const end = text.data() + text.size();
+    if (!preserve) skipSpace();
 
-    // Processing Instruction node
-    if (is_processing_instruction()) {
-        return makeTab(alignDepth) + "<?" + pi_target_ + " " + pi_data_ + "?>";
-    }    
-    // if any attributes, text content or children exist, ignore self_closing setting
-    bool full_tag = !attributes.empty() || hasTextContent() || hasChildren() ? true : isSelfClosing();
+    while (!stack.empty()) {
+        open_element& f = stack.back();
+        if (pos >= text.size()) {
+            throw parsing_error("End tag </" + std::string(f.qname) + "> not found");
+        }
 
-    result = makeTab(alignDepth) + "<" + fullQualifiedName(); // by default explicitly use qualified name
+        if (text[pos] != '<') {
+            // text run up to the next tag
+            const char* p = text.data() + pos;
+            bool has_reference = false;
+            while (true) {
+                p = xscan2(p, end, '<', '&');
+                if (p == end) throw parsing_error("End tag </" + std::string(f.qname) + "> not found");
+                if (*p == '<') break;
+                has_reference = true;
+                ++p;
+            }
+            std::string_view run = text.substr(pos, static_cast<size_t>(p - text.data()) - pos);
+            pos = static_cast<size_t>(p - text.data());
+            if (!f.preserve) run = xtrim(run);
+            std::string& value = f.element->text_content.emplace();
+            if (has_reference) xassign_unescaped(value, run);
+            else value.assign(run);
+            continue;
+        }
 
-    if(!full_tag) {
-        // verified self-closing tag, so we are done
-        result += " />";
-        return result;
-    }
+        if (startsWith("</")) {
+            endTag(f.qname);
+            stack.pop_back();
+            continue;
+        }
 
-    // attributes
-    for(const auto &attr : attributes) {
-        // this convertion from qualified_name adds the namespace prefix if any
-        result += " " + std::string(attr.first) + "=\"" + escapeTextContent(attr.second) + "\"";
-    }
+        if (!f.element->children.has_value()) {
+            f.element->children = std::vector<node>();
+        }
+        std::vector<node>& children = f.element->children.value();
 
-    // namespace declarations
-    // only emit namespaces declared on this node that are not already inherited
-    auto is_declared_inherited = [&](const xnamespace& ns)->bool {
-        if(!inherited_xmlns.has_value()) return false;
-        for(const auto &inh : inherited_xmlns.value()) {
-            // compare prefix presence/value and uri
-            bool same_prefix = (!ns.prefix.has_value() && !inh.prefix.has_value()) ||
-                               (ns.prefix.has_value() && inh.prefix.has_value() && ns.prefix.value() == inh.prefix.value());
-            if(same_prefix && ns.uri == inh.uri) {
-                return true;
-            }
+        if (startsWith("<![CDATA[")) {
+            children.push_back(cdata());
+            continue;
+        }
+        if (startsWith("<!--")) {
+            children.push_back(comment());
+            continue;
+        }
+        if (startsWith("<?")) {
+            children.push_back(processingInstruction(false));
+            continue;
         }
-        return false;
-    };
 
-    if(decl_xmlns.has_value()) {
-        for(const auto &ns : decl_xmlns.value()) {
-            if(is_declared_inherited(ns)) {
-                continue; // already available from parent
+        // child element, it sees the namespaces of all its ancestors
+        node& parent = *f.element;
+        const bool parent_preserve = f.preserve;
+        node& child = children.emplace_back();
+        if (parent.decl_xmlns.has_value() || parent.inherited_xmlns.has_value()) {
+            child.inherited_xmlns = std::vector<xnamespace>();
+            if (parent.inherited_xmlns.has_value()) {
+                child.inherited_xmlns->insert(child.inherited_xmlns->end(), parent.inherited_xmlns->begin(), parent.inherited_xmlns->end());
             }
-            if(!ns.prefix.has_value()) {
-                result += " xmlns=\"" + escapeTextContent(ns.uri) + "\"";
-            } else {
-                result += " xmlns:" + ns.prefix.value() + "=\"" + escapeTextContent(ns.uri) + "\"";
+            if (parent.decl_xmlns.has_value()) {
+                child.inherited_xmlns->insert(child.inherited_xmlns->end(), parent.decl_xmlns->begin(), parent.decl_xmlns->end());
             }
         }
+
+        bool child_preserve = parent_preserve;
+        std::string_view child_qname;
+        if (startTag(child, child_preserve, child_qname)) {
+            skipSpace();
+            continue;
+        }
+        // `child` stays valid: only the innermost open element gets new children
+        stack.push_back(open_element{&child, child_qname, child_preserve});
+        if (!child_preserve) skipSpace();
     }
+}
 
-    // tag ending
-    result += ">";
+void parser::endTag(std::string_view qname)
+{
+    pos += 2; // "</"
+    const size_t name_start = pos;
+    while (pos < text.size() && !xis_space(text[pos]) && text[pos] != '>') ++pos;
+    const std::string_view name = text.substr(name_start, pos - name_start);
+    skipSpace();
+    if (pos >= text.size() || text[pos] != '>') {
+        throw parsing_error("End tag </" + std::string(name) + " is not closed");
+    }
+    if (name != qname) {
+        throw parsing_error("End tag </" + std::string(qname) + "> not found, got </" + std::string(name) + ">");
+    }
+    ++pos;
+}
 
-    // text content
-    // Note: if both text content and children exist, text content is placed before children
-    // Also, if the text is short enough, we keep it in the same line
+node parser::processingInstruction(bool trim_data)
+{
+    const size_t end = text.find("?>", pos + 2);
+    if (end == std::string_view::npos) {
+        throw parsing_error("Unclosed processing instruction");
+    }
+    const std::string_view body = text.substr(pos + 2, end - pos - 2);
+    pos = end + 2;
 
-    if(hasTextContent()) {
-        std::string escaped_text = escapeTextContent(text_content.value());
-        if(escaped_text.find('\n') == std::string::npos && escaped_text.length() <= 60) {
-            // short text, keep in the same line
-            result += escaped_text;
-        } else {
-            // long text or multi-line, put in new line with indentation
-            result += "\n" + makeTab(alignDepth + 1) + escaped_text + "\n" + makeTab(alignDepth);
-        }
+    const size_t space = body.find_first_of(" \t");
+    if (space == std::string_view::npos) {
+        return node::create_processing_instruction(std::string(body), "");
     }
+    std::string_view data = body.substr(space + 1);
+    if (trim_data) data = xtrim(data);
+    return node::create_processing_instruction(std::string(body.substr(0, space)), std::string(data));
+}
 
-    // children
-    if(children.has_value()) {
-        result += "\n";
-        for(const auto &child : children.value()) {
-            result += child.serialize(alignDepth + 1) + "\n";
-        }
-        result += makeTab(alignDepth);
+node parser::comment()
+{
+    const size_t end = text.find("-->", pos + 4);
+    if (end == std::string_view::npos) {
+        throw parsing_error("Unclosed comment");
     }
+    node n = node::create_comment(std::string(text.substr(pos + 4, end - pos - 4)));
+    pos = end + 3;
+    return n;
+}
 
-    // end tag
-    result += "</" + fullQualifiedName() + ">";
+node parser::cdata()
+{
+    const size_t end = text.find("]]>", pos + 9);
+    if (end == std::string_view::npos) {
+        throw parsing_error("Unclosed CDATA section");
+    }
+    node n = node::create_text(std::string(text.substr(pos + 9, end - pos - 9)));
+    pos = end + 3;
+    return n;
+}
 
-    // We may want to add some truncation policy to prevent making a single line too long.
+std::string node::deserialize(const std::string &node_text, bool preserve_whitespace)
+{
+    parser p(node_text);
+    const bool self_closing = p.parseNode(*this, preserve_whitespace);
+    std::string remaining_text = node_text.substr(p.position());
+    // as before: whitespace around a self-closing node is dropped, and so is
+    // trailing whitespace of the input
+    if (self_closing) {
+        return trimString(remaining_text);
+    }
+    remaining_text.erase(remaining_text.find_last_not_of(" \t\n\r") + 1);
+    return remaining_text;
+}
 
+std::string node::serialize(int alignDepth) const
+{
+    std::string result;
+    string_sink out(result);
+    writer(out).write(*this, alignDepth);
     return result;
 }
 
@@ -706,16 +858,6 @@ void node::reset()
     xmlns.reset();
 }
 
-// private helper functions
-void search_and_replace(std::string &source, const std::string &from, const std::string &to)
-{
-    size_t pos = 0;
-    while((pos = source.find(from, pos)) != std::string::npos) {
-        source.replace(pos, from.length(), to);
-        pos += to.length();
-    }
-}
-
 std::string makeTab(int depth)
 {
     return std::string(depth * tab_size, ' ');
@@ -743,77 +885,54 @@ std::string trimString(const std::string &str)
 
 std::string escapeTextContent(const std::string &text)
 {
-    std::string result = text;
-    search_and_replace(result, "&", "&amp;");
-    search_and_replace(result, "<", "&lt;");
-    search_and_replace(result, ">", "&gt;");
-    search_and_replace(result, "\"", "&quot;");
-    search_and_replace(result, "'", "&apos;");
+    std::string result;
+    result.reserve(text.size());
+    escapeTextContent(result, text);
     return result;
 }
 
-std::string unescapeTextContent(const std::string &text)
+void escapeTextContent(std::string &out, std::string_view text)
 {
-    std::string result = text;
-    search_and_replace(result, "&apos;", "'");
-    search_and_replace(result, "&quot;", "\"");
-    search_and_replace(result, "&gt;", ">");
-    search_and_replace(result, "&lt;", "<");
-    search_and_replace(result, "&amp;", "&");
-
-    // decimal and hex character references
-    size_t pos = 0;
-    while((pos = result.find("&#", pos)) != std::string::npos) {
-        try {
-            size_t end_pos = result.find(';', pos);
-            if(end_pos == std::string::npos) {
-                break; // malformed, no ending ';'
-            }
-            std::string char_ref = result.substr(pos + 2, end_pos - (pos + 2));
-            char32_t char_code = 0;
-            if(!char_ref.empty() && char_ref[0] == 'x') {
-                // hex
-                char_code = static_cast<char32_t>(std::stoul(char_ref.substr(1), nullptr, 16));
-            } else {
-                // decimal
-                char_code = static_cast<char32_t>(std::stoul(char_ref, nullptr, 10));
-            }
-            // convert char_code to UTF-8
-            std::string utf8_char;
-            if(char_code <= 0x7F) {
-                utf8_char += static_cast<char>(char_code);
-            } else if(char_code <= 0x7FF) {
-                utf8_char += static_cast<char>(0xC0 | ((char_code >> 6) & 0x1F));
-                utf8_char += static_cast<char>(0x80 | (char_code & 0x3F));
-            } else if(char_code <= 0xFFFF) {
-                utf8_char += static_cast<char>(0xE0 | ((char_code >> 12) & 0x0F));
-                utf8_char += static_cast<char>(0x80 | ((char_code >> 6) & 0x3F));
-                utf8_char += static_cast<char>(0x80 | (char_code & 0x3F));
-            } else if(char_code <= 0x10FFFF) {
-                utf8_char += static_cast<char>(0xF0 | ((char_code >> 18) & 0x07));
-                utf8_char += static_cast<char>(0x80 | ((char_code >> 12) & 0x3F));
-                utf8_char += static_cast<char>(0x80 | ((char_code >> 6) & 0x3F));
-                utf8_char += static_cast<char>(0x80 | (char_code & 0x3F));
-            } else {
-                // invalid code point
-                pos = end_pos + 1;
-                continue;
-            }
-            result.replace(pos, end_pos - pos + 1, utf8_char);
-            pos += utf8_char.length();
-        } catch(...) {
-            // If conversion fails, skip this character reference
-            pos += 2;
+    // clean runs are found 16/32 bytes at a time and copied in one piece
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        const char* hit = xscan_escape(p, end);
+        out.append(p, static_cast<size_t>(hit - p));
+        if (hit == end) break;
+        switch (*hit) {
+        case '&': out += "&amp;"; break;
+        case '<': out += "&lt;"; break;
+        case '>': out += "&gt;"; break;
+        case '"': out += "&quot;"; break;
+        default: out += "&apos;"; break;
         }
+        p = hit + 1;
     }
+}
+
+std::string unescapeTextContent(const std::string &text)
+{
+    std::string result;
+    xassign_unescaped(result, text);
     return result;
 }
 
+void unescapeTextContent(std::string &out, std::string_view text)
+{
+    xassign_unescaped(out, text);
+}
+
 node &document::getRootNode()
 {
     return root_node;
 }
 
+const node &document::getRootNode() const
+{
+    return root_node;
+}
+
 void document::setRootNode(const node &root)
 {
     this->root_node = root;
@@ -839,50 +958,16 @@ void document::setDoctypeDeclaration(const std::string &doctype)
     this->doctype_declaration = doctype;
 }
 
-void document::deserialize(const std::string &xml_text)
+void document::deserialize(std::string_view xml_text)
 {
-    reset();
-    // simply deserialize the prolog, then just give the rest of the content to root node
-
-    // For simplicity, we only look for xml declaration and doctype in the prolog
-    size_t pos = 0;
-    // xml declaration
-    if(xml_text.compare(0, 5, "<?xml") == 0) {
-        size_t end_pos = xml_text.find("?>", pos);
-        if(end_pos != std::string::npos) {
-            xml_declaration = xml_text.substr(0, end_pos + 2);
-            pos = end_pos + 2;
-        }
-    }
-    if(xml_text.compare(pos, 9, "<!DOCTYPE") == 0) {
-        size_t end_pos = xml_text.find('>', pos);
-        if(end_pos != std::string::npos) {
-            doctype_declaration = xml_text.substr(pos, end_pos - pos + 1);
-            pos = end_pos + 1;
-        }
-    }
-
-    root_node.deserialize(xml_text.substr(pos));
+    parser(xml_text).parseDocument(*this);
 }
 
 std::string document::serialize() const
 {
-    // we simply serialize the root node, with optional xml declaration and doctype
     std::string result;
-
-    // prolog
-    if(xml_declaration.has_value()) {
-        result += xml_declaration.value() + "\n";
-    }
-
-    if(doctype_declaration.has_value()) {
-        result += doctype_declaration.value() + "\n";
-    }
-
-    // root node
-    result += root_node.serialize();
-
-    // and we're done
+    string_sink out(result);
+    writer(out).write(*this);
     return result;
 }
 
@@ -952,7 +1037,9 @@ std::istream& operator>>(std::istream &is, document &doc)
 
 std::ostream& operator<<(std::ostream &os, const document &doc)
 {
-    os << doc.serialize();
+    // streamed in chunks, the text never exists as a whole
+    ostream_sink out(os);
+    writer(out).write(doc);
     return os;
 }
 
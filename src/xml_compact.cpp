@@ -0,0 +1,545 @@
+/*
+    Compact XML document implementation file,
+    As part of SharedCppLib2 project.
+*/
+#include "xml_compact.hpp"
+#include "xml_reader.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <unordered_map>
+
+namespace xml
+{
+
+namespace {
+
+constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+enum : uint8_t {
+    flag_cdata = 1 << 0,
+    flag_self_closing = 1 << 1,
+};
+
+} // namespace
+
+struct compact_storage {
+    struct record {
+        node::Type type;
+        uint8_t flags;
+        uint32_t parent;
+        uint32_t first_child;
+        uint32_t next_sibling;
+        uint32_t name;  // element: qualified name, processing instruction: target
+        uint32_t xmlns; // element: namespace uri, 0 if none
+        uint32_t scope; // innermost namespace declaration in effect, `none` if none
+        uint32_t first; // element: attribute range, other nodes: range in `text`
+        uint32_t count;
+    };
+
+    struct attribute_record {
+        uint32_t name;
+        uint32_t xmlns;
+        uint32_t value; // range in `text`
+        uint32_t length;
+    };
+
+    // one namespace declaration, linked to the declaration in effect before it
+    struct scope_record {
+        uint32_t prefix; // "" for the default namespace
+        uint32_t uri;
+        uint32_t parent;
+    };
+
+    std::vector<record> nodes;
+    std::vector<attribute_record> attributes;
+    std::vector<scope_record> scopes;
+    std::string text;
+
+    // interned strings, id 0 is ""
+    std::deque<std::string> pool;
+    std::vector<std::string_view> strings;
+    std::unordered_map<std::string_view, uint32_t> ids;
+
+    std::optional<std::string> xml_declaration;
+    std::optional<std::string> doctype_declaration;
+
+    compact_storage() { intern(std::string_view()); }
+
+    uint32_t intern(std::string_view s)
+    {
+        auto it = ids.find(s);
+        if (it != ids.end()) return it->second;
+        const std::string_view stored = pool.emplace_back(s);
+        const uint32_t id = static_cast<uint32_t>(strings.size());
+        strings.push_back(stored);
+        ids.emplace(stored, id);
+        return id;
+    }
+
+    std::string_view string(uint32_t id) const { return strings[id]; }
+    std::string_view slice(uint32_t first, uint32_t length) const { return std::string_view(text).substr(first, length); }
+
+    // appends to `text`, returns where it starts
+    uint32_t store(std::string_view s)
+    {
+        if (text.size() + s.size() > none) throw parser_error("compact_document: more than 4 GiB of text");
+        const uint32_t first = static_cast<uint32_t>(text.size());
+        text.append(s);
+        return first;
+    }
+
+    std::string_view lookup(uint32_t scope, std::string_view prefix) const
+    {
+        for (; scope != none; scope = scopes[scope].parent) {
+            if (string(scopes[scope].prefix) == prefix) return string(scopes[scope].uri);
+        }
+        return prefix == "xml" ? std::string_view("http://www.w3.org/XML/1998/namespace") : std::string_view();
+    }
+};
+
+// compact_node
+
+node::Type compact_node::type() const
+{
+    return store_->nodes[index_].type;
+}
+
+bool compact_node::is_cdata() const
+{
+    return (store_->nodes[index_].flags & flag_cdata) != 0;
+}
+
+std::string_view compact_node::qualifiedName() const
+{
+    const auto& rec = store_->nodes[index_];
+    return rec.type == node::Type::Element || rec.type == node::Type::ProcessingInstruction ? store_->string(rec.name) : std::string_view();
+}
+
+std::string_view compact_node::localName() const
+{
+    const std::string_view qname = qualifiedName();
+    const size_t colon = qname.find(':');
+    return colon == std::string_view::npos ? qname : qname.substr(colon + 1);
+}
+
+std::string_view compact_node::prefix() const
+{
+    const std::string_view qname = qualifiedName();
+    const size_t colon = qname.find(':');
+    return colon == std::string_view::npos ? std::string_view() : qname.substr(0, colon);
+}
+
+std::string_view compact_node::namespaceUri() const
+{
+    return store_->string(store_->nodes[index_].xmlns);
+}
+
+bool compact_node::hasAttribute(std::string_view qname) const
+{
+    const auto& rec = store_->nodes[index_];
+    if (rec.type != node::Type::Element) return false;
+    for (uint32_t i = rec.first; i < rec.first + rec.count; ++i) {
+        if (store_->string(store_->attributes[i].name) == qname) return true;
+    }
+    return false;
+}
+
+std::string_view compact_node::getAttribute(std::string_view qname, std::string_view default_value) const
+{
+    const auto& rec = store_->nodes[index_];
+    if (rec.type != node::Type::Element) return default_value;
+    for (uint32_t i = rec.first; i < rec.first + rec.count; ++i) {
+        const auto& a = store_->attributes[i];
+        if (store_->string(a.name) == qname) return store_->slice(a.value, a.length);
+    }
+    return default_value;
+}
+
+size_t compact_node::attributeCount() const
+{
+    const auto& rec = store_->nodes[index_];
+    return rec.type == node::Type::Element ? rec.count : 0;
+}
+
+std::generator<compact_attribute> compact_node::attributes() const
+{
+    const auto& rec = store_->nodes[index_];
+    if (rec.type != node::Type::Element) co_return;
+    for (uint32_t i = rec.first; i < rec.first + rec.count; ++i) {
+        const auto& a = store_->attributes[i];
+        co_yield compact_attribute{ store_->string(a.name), store_->string(a.xmlns), store_->slice(a.value, a.length) };
+    }
+}
+
+std::string_view compact_node::lookupNamespace(std::string_view prefix) const
+{
+    return store_->lookup(store_->nodes[index_].scope, prefix);
+}
+
+std::vector<xnamespace> compact_node::getDeclaredNamespaces() const
+{
+    const auto& rec = store_->nodes[index_];
+    std::vector<xnamespace> result;
+    if (rec.type != node::Type::Element) return result;
+
+    const uint32_t outer = rec.parent == none ? none : store_->nodes[rec.parent].scope;
+    for (uint32_t scope = rec.scope; scope != outer; scope = store_->scopes[scope].parent) {
+        const auto& decl = store_->scopes[scope];
+        xnamespace ns;
+        if (decl.prefix != 0) ns.prefix = std::string(store_->string(decl.prefix));
+        ns.uri = store_->string(decl.uri);
+        result.push_back(std::move(ns));
+    }
+    std::reverse(result.begin(), result.end()); // document order
+    return result;
+}
+
+std::string compact_node::getTextContent() const
+{
+    const auto& rec = store_->nodes[index_];
+    if (rec.type != node::Type::Element) return std::string(text());
+
+    std::string result;
+    for (uint32_t child = rec.first_child; child != none; child = store_->nodes[child].next_sibling) {
+        const auto& c = store_->nodes[child];
+        if (c.type == node::Type::Text) result += store_->slice(c.first, c.count);
+    }
+    return result;
+}
+
+std::string_view compact_node::text() const
+{
+    const auto& rec = store_->nodes[index_];
+    return rec.type == node::Type::Element ? std::string_view() : store_->slice(rec.first, rec.count);
+}
+
+compact_node compact_node::parent() const
+{
+    const uint32_t parent = store_->nodes[index_].parent;
+    return parent == none ? compact_node() : compact_node(store_, parent);
+}
+
+compact_node compact_node::firstChild() const
+{
+    const uint32_t child = store_->nodes[index_].first_child;
+    return child == none ? compact_node() : compact_node(store_, child);
+}
+
+compact_node compact_node::nextSibling() const
+{
+    const uint32_t sibling = store_->nodes[index_].next_sibling;
+    return sibling == none ? compact_node() : compact_node(store_, sibling);
+}
+
+bool compact_node::isSelfClosing() const
+{
+    return (store_->nodes[index_].flags & flag_self_closing) != 0;
+}
+
+std::generator<compact_node> compact_node::childNodes() const
+{
+    for (uint32_t child = store_->nodes[index_].first_child; child != none; child = store_->nodes[child].next_sibling) {
+        co_yield compact_node(store_, child);
+    }
+}
+
+std::generator<compact_node> compact_node::elements() const
+{
+    for (uint32_t child = store_->nodes[index_].first_child; child != none; child = store_->nodes[child].next_sibling) {
+        if (store_->nodes[child].type == node::Type::Element) co_yield compact_node(store_, child);
+    }
+}
+
+compact_node compact_node::firstElement(std::string_view qname) const
+{
+    for (uint32_t child = store_->nodes[index_].first_child; child != none; child = store_->nodes[child].next_sibling) {
+        const auto& c = store_->nodes[child];
+        if (c.type == node::Type::Element && store_->string(c.name) == qname) return compact_node(store_, child);
+    }
+    return compact_node();
+}
+
+node compact_node::toNode() const
+{
+    // the declarations of all ancestors, outermost first, as xml::document records them
+    std::vector<uint32_t> ancestors;
+    for (uint32_t i = store_->nodes[index_].parent; i != none; i = store_->nodes[i].parent) ancestors.push_back(i);
+
+    std::optional<std::vector<xnamespace>> inherited;
+    for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+        std::vector<xnamespace> declared = compact_document::declaredNamespaces(*store_, *it);
+        if (declared.empty() && !inherited.has_value()) continue;
+        if (!inherited.has_value()) inherited.emplace();
+        inherited->insert(inherited->end(), declared.begin(), declared.end());
+    }
+    return compact_document::toNode(*store_, index_, inherited);
+}
+
+// compact_document
+
+compact_document::compact_document() : store_(std::make_unique<compact_storage>()) {}
+compact_document::~compact_document() = default;
+compact_document::compact_document(compact_document&&) noexcept = default;
+compact_document& compact_document::operator=(compact_document&&) noexcept = default;
+
+compact_document compact_document::parse(std::string_view xml_text)
+{
+    reader r(xml_text);
+    return build(r);
+}
+
+compact_document compact_document::fromStream(std::istream &input)
+{
+    reader r(input);
+    return build(r);
+}
+
+compact_document compact_document::build(reader &r)
+{
+    compact_document doc;
+    compact_storage& s = *doc.store_;
+
+    std::vector<uint32_t> open;       // open elements
+    std::vector<uint32_t> last_child; // of each open element
+    std::string qname;
+
+    auto add = [&](node::Type type) {
+        if (s.nodes.size() >= none) throw parser_error("compact_document: too many nodes");
+        const uint32_t index = static_cast<uint32_t>(s.nodes.size());
+        const uint32_t parent = open.empty() ? none : open.back();
+        s.nodes.push_back(compact_storage::record{ type, 0, parent, none, none, 0, 0,
+                                                   parent == none ? none : s.nodes[parent].scope, 0, 0 });
+        if (parent != none) {
+            uint32_t& last = last_child.back();
+            if (last == none) s.nodes[parent].first_child = index;
+            else s.nodes[last].next_sibling = index;
+            last = index;
+        }
+        return index;
+    };
+    auto store_text = [&](uint32_t index, std::string_view text) {
+        s.nodes[index].first = s.store(text);
+        s.nodes[index].count = static_cast<uint32_t>(text.size());
+    };
+
+    for (event e = r.next(); e != event::end_of_input; e = r.next()) {
+        switch (e) {
+        case event::need_input:
+            r.finish(); // only when fed by hand, which build() never is
+            break;
+
+        case event::start_element: {
+            const uint32_t index = add(node::Type::Element);
+            uint32_t scope = s.nodes[index].scope;
+            for (const auto& decl : r.declarations()) {
+                s.scopes.push_back(compact_storage::scope_record{ s.intern(decl.prefix.value_or("")), s.intern(decl.uri), scope });
+                scope = static_cast<uint32_t>(s.scopes.size() - 1);
+            }
+
+            const qualified_name& name = r.name();
+            qname.clear();
+            if (name.prefix.has_value()) {
+                qname += name.prefix.value();
+                qname += ':';
+            }
+            qname += name.local_name;
+
+            auto& rec = s.nodes[index];
+            rec.name = s.intern(qname);
+            rec.xmlns = r.xmlns() != nullptr ? s.intern(r.xmlns()->uri) : 0;
+            rec.scope = scope;
+            rec.flags = r.isSelfClosing() ? flag_self_closing : 0;
+            rec.first = static_cast<uint32_t>(s.attributes.size());
+            rec.count = static_cast<uint32_t>(r.attributes().size());
+            for (const auto& a : r.attributes()) {
+                qname.clear();
+                if (a.name.prefix.has_value()) {
+                    qname += a.name.prefix.value();
+                    qname += ':';
+                }
+                qname += a.name.local_name;
+                s.attributes.push_back(compact_storage::attribute_record{
+                    s.intern(qname), a.xmlns != nullptr ? s.intern(a.xmlns->uri) : 0,
+                    s.store(a.value), static_cast<uint32_t>(a.value.size()) });
+            }
+
+            open.push_back(index);
+            last_child.push_back(none);
+            break;
+        }
+
+        case event::end_element:
+            open.pop_back();
+            last_child.pop_back();
+            break;
+
+        case event::text:
+        case event::cdata:
+        case event::comment: {
+            if (open.empty()) break; // comments around the root are not kept, like in xml::document
+            const uint32_t index = add(e == event::comment ? node::Type::Comment : node::Type::Text);
+            if (e == event::cdata) s.nodes[index].flags = flag_cdata;
+            store_text(index, r.text());
+            break;
+        }
+
+        case event::processing_instruction: {
+            if (open.empty()) break;
+            const uint32_t index = add(node::Type::ProcessingInstruction);
+            s.nodes[index].name = s.intern(r.target());
+            store_text(index, r.text());
+            break;
+        }
+
+        case event::end_of_input:
+            break;
+        }
+    }
+
+    s.xml_declaration = r.getXmlDeclaration();
+    s.doctype_declaration = r.getDoctypeDeclaration();
+
+    // the builder's slack is not needed any more
+    s.nodes.shrink_to_fit();
+    s.attributes.shrink_to_fit();
+    s.scopes.shrink_to_fit();
+    s.text.shrink_to_fit();
+    return doc;
+}
+
+compact_node compact_document::getRootNode() const
+{
+    return store_->nodes.empty() ? compact_node() : compact_node(store_.get(), 0);
+}
+
+std::optional<std::string> compact_document::getXmlDeclaration() const
+{
+    return store_->xml_declaration;
+}
+
+std::optional<std::string> compact_document::getDoctypeDeclaration() const
+{
+    return store_->doctype_declaration;
+}
+
+size_t compact_document::nodeCount() const
+{
+    return store_->nodes.size();
+}
+
+size_t compact_document::memoryUsage() const
+{
+    const compact_storage& s = *store_;
+    size_t bytes = sizeof(compact_storage)
+                 + s.nodes.capacity() * sizeof(compact_storage::record)
+                 + s.attributes.capacity() * sizeof(compact_storage::attribute_record)
+                 + s.scopes.capacity() * sizeof(compact_storage::scope_record)
+                 + s.text.capacity()
+                 + s.strings.capacity() * sizeof(std::string_view)
+                 + s.ids.bucket_count() * sizeof(void*)
+                 + s.ids.size() * (sizeof(std::pair<std::string_view, uint32_t>) + 2 * sizeof(void*));
+    for (const auto& str : s.pool) bytes += sizeof(std::string) + (str.capacity() > 15 ? str.capacity() + 1 : 0);
+    return bytes;
+}
+
+document compact_document::toDocument() const
+{
+    document doc;
+    if (!store_->nodes.empty()) {
+        doc.root_node = toNode(*store_, 0, std::nullopt);
+    }
+    doc.xml_declaration = store_->xml_declaration;
+    doc.doctype_declaration = store_->doctype_declaration;
+    return doc;
+}
+
+std::vector<xnamespace> compact_document::declaredNamespaces(const compact_storage &s, uint32_t index)
+{
+    // in prefix order, a repeated prefix keeps its last uri, like parser does
+    const auto& rec = s.nodes[index];
+    const uint32_t outer = rec.parent == none ? none : s.nodes[rec.parent].scope;
+    std::vector<xnamespace> declared;
+    for (uint32_t scope = rec.scope; scope != outer; scope = s.scopes[scope].parent) {
+        const auto& decl = s.scopes[scope];
+        const std::string_view prefix = s.string(decl.prefix);
+        auto same = [&](const xnamespace& ns) { return ns.prefix.value() == prefix; };
+        if (std::none_of(declared.begin(), declared.end(), same)) { // walking backwards, the first one is the last declared
+            declared.push_back(xnamespace{ std::string(prefix), std::string(s.string(decl.uri)) });
+        }
+    }
+    std::stable_sort(declared.begin(), declared.end(),
+        [](const xnamespace& a, const xnamespace& b) { return a.prefix.value() < b.prefix.value(); });
+    return declared;
+}
+
+node compact_document::toNode(const compact_storage &s, uint32_t index, const std::optional<std::vector<xnamespace>> &inherited)
+{
+    const auto& rec = s.nodes[index];
+    switch (rec.type) {
+    case node::Type::Text:
+        return node::create_text(std::string(s.slice(rec.first, rec.count)));
+    case node::Type::Comment:
+        return node::create_comment(std::string(s.slice(rec.first, rec.count)));
+    case node::Type::ProcessingInstruction:
+        return node::create_processing_instruction(std::string(s.string(rec.name)), std::string(s.slice(rec.first, rec.count)));
+    case node::Type::Element:
+        break;
+    }
+
+    node n;
+    n.inherited_xmlns = inherited;
+    std::vector<xnamespace> declared = declaredNamespaces(s, index);
+    if (!declared.empty()) n.decl_xmlns = std::move(declared);
+
+    const std::string_view qname = s.string(rec.name);
+    const size_t colon = qname.find(':');
+    if (colon != std::string_view::npos) {
+        n.name = std::string(qname.substr(colon + 1));
+        n.xmlns = xnamespace{ std::string(qname.substr(0, colon)), std::string(s.string(rec.xmlns)) };
+    } else {
+        n.name = std::string(qname);
+    }
+
+    for (uint32_t i = rec.first; i < rec.first + rec.count; ++i) {
+        const auto& a = s.attributes[i];
+        n.attributes[qualified_name(s.string(a.name))] = std::string(s.slice(a.value, a.length));
+    }
+    n.self_closing = (rec.flags & flag_self_closing) != 0;
+
+    if (rec.first_child == none) return n;
+
+    // what the children inherit: ours plus our declarations
+    std::optional<std::vector<xnamespace>> child_inherited;
+    if (n.inherited_xmlns.has_value() || n.decl_xmlns.has_value()) {
+        child_inherited.emplace(n.inherited_xmlns.value_or(std::vector<xnamespace>()));
+        if (n.decl_xmlns.has_value()) {
+            child_inherited->insert(child_inherited->end(), n.decl_xmlns->begin(), n.decl_xmlns->end());
+        }
+    }
+
+    // text runs become text_content (the last one wins, as in xml::document), CDATA sections text nodes
+    bool after_self_closing = false;
+    for (uint32_t child = rec.first_child; child != none; child = s.nodes[child].next_sibling) {
+        const auto& c = s.nodes[child];
+        const bool self_closing = (c.flags & flag_self_closing) != 0;
+        if (c.type == node::Type::Text && (c.flags & flag_cdata) == 0) {
+            std::string_view run = s.slice(c.first, c.count);
+            if (after_self_closing) {
+                // xml::document drops whitespace behind a self-closing child, even when preserving
+                run.remove_prefix(std::min(run.find_first_not_of(" \t\n\r"), run.size()));
+                if (run.empty()) continue;
+            }
+            n.text_content = std::string(run);
+            after_self_closing = false;
+            continue;
+        }
+        after_self_closing = self_closing;
+        if (!n.children.has_value()) n.children = std::vector<node>();
+        n.children->push_back(toNode(s, child, child_inherited));
+    }
+    return n;
+}
+
+} // namespace xml
@@ -0,0 +1,706 @@
+/*
+    XML path query implementation file,
+    As part of SharedCppLib2 project.
+*/
+#include "xml_query.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace xml
+{
+
+namespace {
+
+struct string_hash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+template <typename T>
+using string_map = std::unordered_map<std::string, T, string_hash, std::equal_to<>>;
+
+bool isNameStart(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool isNameChar(char c)
+{
+    return isNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+}
+
+// Recursive descent over the expression, one character of lookahead.
+class path_parser
+{
+public:
+    explicit path_parser(std::string_view text) : s_(text) {}
+
+    // returns whether the path is absolute
+    bool parse(std::vector<xpath::step>& steps)
+    {
+        ws();
+        bool absolute = false;
+        xpath::axis next = xpath::axis::child;
+        if (eat("//")) {
+            absolute = true;
+            next = xpath::axis::descendant;
+        } else if (eat("/")) {
+            absolute = true;
+        }
+        while (true) {
+            ws();
+            steps.push_back(step(next));
+            ws();
+            if (i_ == s_.size()) break;
+            if (eat("//")) next = xpath::axis::descendant;
+            else if (eat("/")) next = xpath::axis::child;
+            else fail("expected '/' or the end of the path");
+        }
+        return absolute;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& what) const
+    {
+        throw parsing_error("Invalid path \"" + std::string(s_) + "\" at offset " + std::to_string(i_) + ": " + what);
+    }
+
+    void ws()
+    {
+        while (i_ < s_.size() && (s_[i_] == ' ' || s_[i_] == '\t' || s_[i_] == '\n' || s_[i_] == '\r')) ++i_;
+    }
+
+    bool eat(std::string_view token)
+    {
+        if (s_.substr(i_).starts_with(token)) {
+            i_ += token.size();
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        ws();
+        if (i_ >= s_.size() || s_[i_] != c) fail(std::string("expected '") + c + "'");
+        ++i_;
+    }
+
+    std::string_view ncname()
+    {
+        size_t start = i_;
+        if (i_ >= s_.size() || !isNameStart(s_[i_])) fail("expected a name");
+        while (i_ < s_.size() && isNameChar(s_[i_])) ++i_;
+        return s_.substr(start, i_ - start);
+    }
+
+    qualified_name qname()
+    {
+        qualified_name result;
+        std::string_view first = ncname();
+        if (i_ + 1 < s_.size() && s_[i_] == ':' && s_[i_ + 1] != ':') {
+            ++i_;
+            result.prefix = std::string(first);
+            result.local_name = ncname();
+        } else {
+            result.local_name = first;
+        }
+        return result;
+    }
+
+    std::string literal()
+    {
+        ws();
+        if (i_ >= s_.size() || (s_[i_] != '\'' && s_[i_] != '"')) fail("expected a quoted string");
+        char quote = s_[i_++];
+        size_t end = s_.find(quote, i_);
+        if (end == std::string_view::npos) fail("unterminated string");
+        std::string value(s_.substr(i_, end - i_));
+        i_ = end + 1;
+        return value;
+    }
+
+    xpath::step step(xpath::axis direction)
+    {
+        xpath::step result;
+        result.direction = direction;
+        if (eat("..")) fail("'..' is not supported");
+        if (eat(".")) {
+            result.direction = direction == xpath::axis::descendant ? xpath::axis::descendant_or_self : xpath::axis::self;
+            result.local = "*";
+            return result; // no predicates after an abbreviated step
+        }
+        if (eat("*")) {
+            result.local = "*";
+        } else {
+            std::string_view first = ncname();
+            if (eat("::")) fail("axes other than '/' and '//' are not supported");
+            if (eat(":")) {
+                result.prefix = first;
+                result.local = eat("*") ? std::string_view("*") : ncname();
+            } else {
+                result.local = first;
+            }
+        }
+        ws();
+        while (eat("[")) {
+            ws();
+            result.predicates.push_back(predicate());
+            expect(']');
+            ws();
+        }
+        return result;
+    }
+
+    xpath::predicate predicate()
+    {
+        xpath::predicate p;
+        if (i_ < s_.size() && s_[i_] >= '0' && s_[i_] <= '9') {
+            size_t n = 0;
+            while (i_ < s_.size() && s_[i_] >= '0' && s_[i_] <= '9') n = n * 10 + static_cast<size_t>(s_[i_++] - '0');
+            if (n == 0) fail("positions start at 1");
+            p.type = xpath::predicate::kind::position;
+            p.position = n;
+            return p;
+        }
+        if (eat("last()")) {
+            p.type = xpath::predicate::kind::last;
+            return p;
+        }
+        return test();
+    }
+
+    xpath::predicate test()
+    {
+        ws();
+        xpath::predicate p;
+        if (eat("not(")) {
+            p = test();
+            p.negate = !p.negate;
+            expect(')');
+            return p;
+        }
+        bool contains = eat("contains(");
+        if (contains || eat("starts-with(")) {
+            p.type = contains ? xpath::predicate::kind::contains : xpath::predicate::kind::starts_with;
+            ws();
+            if (eat("text()")) p.on_text = true;
+            else if (eat("@")) p.name = qname();
+            else fail("expected @attribute or text()");
+            expect(',');
+            p.value = literal();
+            expect(')');
+            return p;
+        }
+        if (eat("text()")) {
+            p.type = xpath::predicate::kind::text;
+        } else if (eat("@")) {
+            p.type = xpath::predicate::kind::attribute;
+            p.name = qname();
+        } else {
+            p.type = xpath::predicate::kind::child;
+            p.name = qname();
+        }
+        ws();
+        if (eat("!=")) {
+            p.op = xpath::predicate::compare::not_equal;
+            p.value = literal();
+        } else if (eat("=")) {
+            p.op = xpath::predicate::compare::equal;
+            p.value = literal();
+        }
+        return p;
+    }
+
+    std::string_view s_;
+    size_t i_ = 0;
+};
+
+bool isPositional(const xpath::step& s)
+{
+    return std::ranges::any_of(s.predicates, [](const xpath::predicate& p) {
+        return p.type == xpath::predicate::kind::position || p.type == xpath::predicate::kind::last;
+    });
+}
+
+// the id index answers [@id='v'] and [@xml:id='v'] as a first predicate
+const xpath::predicate* idPredicate(const xpath::step& s)
+{
+    if (s.predicates.empty()) return nullptr;
+    const xpath::predicate& p = s.predicates.front();
+    if (p.type != xpath::predicate::kind::attribute || p.op != xpath::predicate::compare::equal || p.negate) return nullptr;
+    if (p.name.local_name != "id") return nullptr;
+    if (p.name.prefix.has_value() && p.name.prefix != "xml") return nullptr;
+    return &p;
+}
+
+} // namespace
+
+struct query_index {
+    std::vector<const node*> order;                   // elements in document order
+    std::vector<uint32_t> end;                        // per element: one past its last descendant
+    std::unordered_map<const node*, uint32_t> number; // element to its position in `order`
+    string_map<std::vector<uint32_t>> names;          // qualified name to elements, ascending
+    bool has_ids = false;
+    string_map<std::vector<uint32_t>> ids;            // id and xml:id values to elements, ascending
+};
+
+struct query::evaluator {
+    const query& q;
+    const query_index* index; // nullptr: walk the tree
+
+    // In here, a context of nullptr is the document node: the parent of q.roots_.
+
+    static std::string_view prefixOf(const node& n)
+    {
+        return n.xmlns.has_value() && n.xmlns->prefix.has_value() ? std::string_view(*n.xmlns->prefix) : std::string_view();
+    }
+
+    static bool matches(const node& n, std::string_view prefix, std::string_view local)
+    {
+        if (!n.is_element()) return false;
+        if (local == "*") return prefix.empty() || prefixOf(n) == prefix;
+        return n.name == local && prefixOf(n) == prefix;
+    }
+
+    static bool matches(const node& n, const qualified_name& name)
+    {
+        return matches(n, name.prefix.has_value() ? std::string_view(*name.prefix) : std::string_view(), name.local_name);
+    }
+
+    static std::string qualifiedName(const node& n)
+    {
+        std::string_view prefix = prefixOf(n);
+        return prefix.empty() ? n.name : std::string(prefix) + ":" + n.name;
+    }
+
+    static bool compare(xpath::predicate::compare op, std::string_view actual, std::string_view expected)
+    {
+        switch (op) {
+        case xpath::predicate::compare::exists: return true;
+        case xpath::predicate::compare::equal: return actual == expected;
+        case xpath::predicate::compare::not_equal: return actual != expected;
+        }
+        return false;
+    }
+
+    static bool test(const xpath::predicate& p, const node& n, size_t position, size_t size)
+    {
+        using kind = xpath::predicate::kind;
+        bool result = false;
+        switch (p.type) {
+        case kind::position:
+            result = position == p.position;
+            break;
+        case kind::last:
+            result = position == size;
+            break;
+        case kind::attribute: {
+            auto it = n.attributes.find(p.name);
+            result = it != n.attributes.end() && compare(p.op, it->second, p.value);
+            break;
+        }
+        case kind::child:
+            if (n.children.has_value()) {
+                for (const node& child : *n.children) {
+                    if (matches(child, p.name) && compare(p.op, child.text_content.value_or(""), p.value)) {
+                        result = true;
+                        break;
+                    }
+                }
+            }
+            break;
+        case kind::text:
+            result = p.op == xpath::predicate::compare::exists
+                ? n.text_content.has_value() && !n.text_content->empty()
+                : compare(p.op, n.text_content.value_or(""), p.value);
+            break;
+        case kind::contains:
+        case kind::starts_with: {
+            std::string_view subject;
+            if (p.on_text) {
+                if (!n.text_content.has_value()) break;
+                subject = *n.text_content;
+            } else {
+                auto it = n.attributes.find(p.name);
+                if (it == n.attributes.end()) break;
+                subject = it->second;
+            }
+            result = p.type == kind::contains ? subject.find(p.value) != std::string_view::npos : subject.starts_with(p.value);
+            break;
+        }
+        }
+        return result != p.negate;
+    }
+
+    // keep the candidates passing every predicate, in turn
+    static void filter(std::vector<const node*>& candidates, const std::vector<xpath::predicate>& predicates)
+    {
+        for (const xpath::predicate& p : predicates) {
+            size_t size = candidates.size(), kept = 0;
+            for (size_t i = 0; i < size; ++i) {
+                if (test(p, *candidates[i], i + 1, size)) candidates[kept++] = candidates[i];
+            }
+            candidates.resize(kept);
+        }
+    }
+
+    template <typename F>
+    void forEachChild(const node* context, F&& f) const
+    {
+        if (context == nullptr) {
+            for (const node* root : q.roots_) f(*root);
+        } else if (context->children.has_value()) {
+            for (const node& child : *context->children) {
+                if (child.is_element()) f(child);
+            }
+        }
+    }
+
+    // enter() and leave() for every element below `top` in document order. Open
+    // elements are kept on an explicit stack, so deep documents that the parser
+    // accepts don't overflow the call stack here either.
+    template <typename Enter, typename Leave>
+    static void walk(const node& top, Enter&& enter, Leave&& leave)
+    {
+        struct frame { const node* parent; size_t next; };
+        std::vector<frame> stack{frame{&top, 0}};
+        while (!stack.empty()) {
+            frame& f = stack.back();
+            if (!f.parent->children.has_value() || f.next == f.parent->children->size()) {
+                if (stack.size() > 1) leave(*f.parent);
+                stack.pop_back();
+                continue;
+            }
+            const node& child = (*f.parent->children)[f.next++];
+            if (!child.is_element()) continue;
+            enter(child);
+            stack.push_back(frame{&child, 0});
+        }
+    }
+
+    // every element below `context` in document order
+    template <typename F>
+    void forEachDescendant(const node* context, F&& f) const
+    {
+        auto leave = [](const node&) {};
+        if (context != nullptr) {
+            walk(*context, f, leave);
+            return;
+        }
+        for (const node* root : q.roots_) {
+            f(*root);
+            walk(*root, f, leave);
+        }
+    }
+
+    // [first, last) in index->order of the descendants of `context`
+    std::pair<uint32_t, uint32_t> range(const node* context) const
+    {
+        if (context == nullptr) return {0, static_cast<uint32_t>(index->order.size())};
+        uint32_t n = index->number.at(context);
+        return {n + 1, index->end[n]};
+    }
+
+    void children(const xpath::step& s, const node* context, std::vector<const node*>& out) const
+    {
+        std::vector<const node*> candidates;
+        forEachChild(context, [&](const node& child) {
+            if (matches(child, s.prefix, s.local)) candidates.push_back(&child);
+        });
+        filter(candidates, s.predicates);
+        out.insert(out.end(), candidates.begin(), candidates.end());
+    }
+
+    void descendants(const xpath::step& s, const node* context, std::vector<const node*>& out) const
+    {
+        std::vector<const node*> candidates;
+        if (index == nullptr) {
+            forEachDescendant(context, [&](const node& n) {
+                if (matches(n, s.prefix, s.local)) candidates.push_back(&n);
+            });
+        } else {
+            auto [first, last] = range(context);
+            const std::vector<uint32_t>* list = nullptr;
+            if (const xpath::predicate* id = idPredicate(s)) {
+                const query_index& ids = q.idIndex();
+                auto it = ids.ids.find(id->value);
+                if (it == ids.ids.end()) return;
+                list = &it->second;
+            } else if (s.local != "*") {
+                auto it = index->names.find(s.prefix.empty() ? s.local : s.prefix + ":" + s.local);
+                if (it == index->names.end()) return;
+                list = &it->second;
+            }
+            if (list != nullptr) {
+                auto lo = std::ranges::lower_bound(*list, first);
+                auto hi = std::ranges::lower_bound(lo, list->end(), last);
+                for (auto it = lo; it != hi; ++it) {
+                    const node* n = index->order[*it];
+                    if (matches(*n, s.prefix, s.local)) candidates.push_back(n);
+                }
+            } else {
+                for (uint32_t i = first; i < last; ++i) {
+                    if (matches(*index->order[i], s.prefix, s.local)) candidates.push_back(index->order[i]);
+                }
+            }
+        }
+        filter(candidates, s.predicates);
+        out.insert(out.end(), candidates.begin(), candidates.end());
+    }
+
+    // document order, without duplicates
+    void normalize(std::vector<const node*>& nodes) const
+    {
+        if (index != nullptr) {
+            std::vector<uint32_t> numbers;
+            numbers.reserve(nodes.size());
+            for (const node* n : nodes) numbers.push_back(index->number.at(n));
+            std::ranges::sort(numbers);
+            auto [tail, _] = std::ranges::unique(numbers);
+            numbers.erase(tail, numbers.end());
+            nodes.clear();
+            for (uint32_t n : numbers) nodes.push_back(index->order[n]);
+            return;
+        }
+        std::unordered_set<const node*> pending(nodes.begin(), nodes.end());
+        nodes.clear();
+        forEachDescendant(nullptr, [&](const node& n) {
+            if (pending.erase(&n)) nodes.push_back(&n);
+        });
+    }
+
+    std::vector<const node*> run(const xpath& path, const node* context) const
+    {
+        std::vector<const node*> current{path.isAbsolute() ? nullptr : context};
+        bool nested = false; // some contexts may be inside others
+        for (const xpath::step& s : path.steps()) {
+            std::vector<const node*> next;
+            bool reorder = current.size() > 1 && nested;
+            switch (s.direction) {
+            case xpath::axis::self:
+                next = std::move(current);
+                break;
+            case xpath::axis::child:
+                for (const node* c : current) children(s, c, next);
+                break;
+            case xpath::axis::descendant:
+                if (isPositional(s)) {
+                    // [n] counts among siblings: //b[1] is the first b child of every node
+                    for (const node* c : current) {
+                        children(s, c, next);
+                        if (index != nullptr) {
+                            auto [first, last] = range(c);
+                            for (uint32_t i = first; i < last; ++i) children(s, index->order[i], next);
+                        } else {
+                            forEachDescendant(c, [&](const node& n) { children(s, &n, next); });
+                        }
+                    }
+                    reorder = true;
+                } else {
+                    for (const node* c : current) descendants(s, c, next);
+                }
+                nested = true;
+                break;
+            case xpath::axis::descendant_or_self:
+                for (const node* c : current) {
+                    if (c != nullptr) next.push_back(c);
+                    descendants(s, c, next);
+                }
+                nested = true;
+                break;
+            }
+            if (reorder && !next.empty()) normalize(next);
+            current = std::move(next);
+            if (current.empty()) break;
+        }
+        std::erase(current, nullptr); // '.' at the document node
+        return current;
+    }
+
+    bool contains(const node& n) const
+    {
+        if (index != nullptr) return index->number.contains(&n);
+        if (std::ranges::find(q.roots_, &n) != q.roots_.end()) return true;
+        bool found = false;
+        forEachDescendant(nullptr, [&](const node& d) { found = found || &d == &n; });
+        return found;
+    }
+
+    static void build(query_index& ix, const std::vector<const node*>& roots)
+    {
+        std::vector<uint32_t> open;
+        auto enter = [&](const node& n) {
+            uint32_t number = static_cast<uint32_t>(ix.order.size());
+            ix.order.push_back(&n);
+            ix.end.push_back(0);
+            ix.number.emplace(&n, number);
+            ix.names[qualifiedName(n)].push_back(number);
+            open.push_back(number);
+        };
+        auto leave = [&](const node&) {
+            ix.end[open.back()] = static_cast<uint32_t>(ix.order.size());
+            open.pop_back();
+        };
+        for (const node* root : roots) {
+            enter(*root);
+            walk(*root, enter, leave);
+            leave(*root);
+        }
+    }
+
+    static void buildIds(query_index& ix)
+    {
+        static const qualified_name id("id"), xml_id("xml:id");
+        for (uint32_t i = 0; i < ix.order.size(); ++i) {
+            const auto& attributes = ix.order[i]->attributes;
+            auto it = attributes.find(id);
+            if (it != attributes.end()) ix.ids[it->second].push_back(i);
+            it = attributes.find(xml_id);
+            if (it != attributes.end() && (ix.ids[it->second].empty() || ix.ids[it->second].back() != i)) {
+                ix.ids[it->second].push_back(i);
+            }
+        }
+        ix.has_ids = true;
+    }
+};
+
+// xpath
+
+xpath::xpath(std::string_view expression)
+    : expression_(expression)
+{
+    absolute_ = path_parser(expression_).parse(steps_);
+}
+
+std::vector<const node*> xpath::select(const node& root) const
+{
+    query q(root, false);
+    return q.select(*this, root);
+}
+
+std::vector<const node*> xpath::select(const document& doc) const
+{
+    return select(doc.getRootNode());
+}
+
+const node* xpath::selectFirst(const node& root) const
+{
+    auto result = select(root);
+    return result.empty() ? nullptr : result.front();
+}
+
+const node* xpath::selectFirst(const document& doc) const
+{
+    return selectFirst(doc.getRootNode());
+}
+
+// query
+
+query::query(const document& doc, bool indexed)
+    : query(doc.getRootNode(), indexed)
+{
+}
+
+query::query(const node& root, bool indexed)
+    : roots_{&root}, indexed_(indexed)
+{
+}
+
+query::query(std::vector<const node*> roots, bool indexed)
+    : roots_(std::move(roots)), indexed_(indexed)
+{
+}
+
+query::~query() = default;
+query::query(query&&) noexcept = default;
+query& query::operator=(query&&) noexcept = default;
+
+const query_index& query::index() const
+{
+    if (!index_) {
+        auto ix = std::make_unique<query_index>();
+        evaluator::build(*ix, roots_);
+        index_ = std::move(ix);
+    }
+    return *index_;
+}
+
+const query_index& query::idIndex() const
+{
+    const query_index& ix = index();
+    if (!ix.has_ids) evaluator::buildIds(*index_);
+    return ix;
+}
+
+std::vector<const node*> query::select(const xpath& path) const
+{
+    evaluator e{*this, indexed_ ? &index() : nullptr};
+    return e.run(path, nullptr);
+}
+
+std::vector<const node*> query::select(const xpath& path, const node& context) const
+{
+    evaluator e{*this, indexed_ ? &index() : nullptr};
+    if (!e.contains(context)) {
+        throw parser_error("query context node is not part of the queried document");
+    }
+    return e.run(path, &context);
+}
+
+const node* query::selectFirst(const xpath& path) const
+{
+    auto result = select(path);
+    return result.empty() ? nullptr : result.front();
+}
+
+const node* query::getElementById(std::string_view id) const
+{
+    if (!indexed_) {
+        static const qualified_name id_name("id"), xml_id("xml:id");
+        const node* found = nullptr;
+        evaluator{*this, nullptr}.forEachDescendant(nullptr, [&](const node& n) {
+            if (found != nullptr) return;
+            for (const qualified_name* key : {&id_name, &xml_id}) {
+                auto it = n.attributes.find(*key);
+                if (it != n.attributes.end() && it->second == id) {
+                    found = &n;
+                    return;
+                }
+            }
+        });
+        return found;
+    }
+    const query_index& ix = idIndex();
+    auto it = ix.ids.find(id);
+    return it == ix.ids.end() || it->second.empty() ? nullptr : ix.order[it->second.front()];
+}
+
+std::vector<const node*> query::getElementsByName(std::string_view qname) const
+{
+    if (qname == "*") return select(xpath("//*"));
+    std::vector<const node*> result;
+    if (!indexed_) {
+        qualified_name name(qname);
+        evaluator{*this, nullptr}.forEachDescendant(nullptr, [&](const node& n) {
+            if (evaluator::matches(n, name)) result.push_back(&n);
+        });
+        return result;
+    }
+    const query_index& ix = index();
+    auto it = ix.names.find(qname);
+    if (it != ix.names.end()) {
+        for (uint32_t n : it->second) result.push_back(ix.order[n]);
+    }
+    return result;
+}
+
+void query::invalidate()
+{
+    index_.reset();
+}
+
+} // namespace xml
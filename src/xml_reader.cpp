@@ -0,0 +1,486 @@
+/*
+    XML Reader implementation file,
+    As part of SharedCppLib2 project.
+*/
+#include "xml_reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace xml
+{
+
+namespace {
+
+// bound without a declaration, see Namespaces in XML 1.0, section 3
+const xnamespace xml_namespace{ "xml", "http://www.w3.org/XML/1998/namespace" };
+
+inline bool xis_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline std::string_view xtrim(std::string_view s)
+{
+    while (!s.empty() && xis_space(s.front())) s.remove_prefix(1);
+    while (!s.empty() && xis_space(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+inline bool same_name(const qualified_name& a, const qualified_name& b)
+{
+    return a.prefix == b.prefix && a.local_name == b.local_name;
+}
+
+} // namespace
+
+reader::reader(std::istream& input, size_t chunk_size)
+    : stream_(&input), chunk_size_(std::max<size_t>(chunk_size, 1))
+{
+}
+
+reader::reader(std::string_view input)
+    : external_(input), in_place_(true), finished_(true)
+{
+}
+
+void reader::feed(std::string_view chunk)
+{
+    if (finished_) throw parser_error("reader::feed: input already finished");
+    compact();
+    buffer_.append(chunk);
+}
+
+void reader::finish()
+{
+    finished_ = true;
+}
+
+void reader::compact()
+{
+    // drop the consumed part once it is at least half of the buffer
+    if (pos_ != 0 && pos_ >= buffer_.size() / 2) {
+        buffer_.erase(0, pos_);
+        consumed_ += pos_;
+        scan_ = scan_ > pos_ ? scan_ - pos_ : 0;
+        pos_ = 0;
+    }
+}
+
+bool reader::pull()
+{
+    compact();
+    const size_t old_size = buffer_.size();
+    buffer_.resize(old_size + chunk_size_);
+    stream_->read(buffer_.data() + old_size, static_cast<std::streamsize>(chunk_size_));
+    buffer_.resize(old_size + static_cast<size_t>(stream_->gcount()));
+    return buffer_.size() != old_size;
+}
+
+event reader::next()
+{
+    while (true) {
+        const event ev = nextEvent();
+        if (ev == event::need_input && stream_ != nullptr && !finished_) {
+            if (!pull()) finish();
+            continue;
+        }
+        if (skip_depth_ != 0 && ev != event::need_input && ev != event::end_of_input) {
+            if (ev != event::end_element || stack_.size() != skip_depth_) continue;
+            skip_depth_ = 0;
+        }
+        last_ = ev;
+        return ev;
+    }
+}
+
+bool reader::dispatch(event_handler &handler)
+{
+    while (true) {
+        switch (next()) {
+        case event::need_input:
+            return true;
+        case event::end_of_input:
+            return false;
+        case event::start_element:
+            handler.on_start_element(name_, xmlns_, attributes_);
+            break;
+        case event::end_element:
+            handler.on_end_element(name_, xmlns_);
+            break;
+        case event::text:
+            handler.on_text(text_, false);
+            break;
+        case event::cdata:
+            handler.on_text(text_, true);
+            break;
+        case event::comment:
+            handler.on_comment(text_);
+            break;
+        case event::processing_instruction:
+            handler.on_processing_instruction(target_, text_);
+            break;
+        }
+    }
+}
+
+void reader::skip()
+{
+    if (last_ != event::start_element) throw parser_error("reader::skip: the last event is not start_element");
+    skip_depth_ = stack_.size();
+}
+
+bool reader::hasAttribute(const qualified_name &key) const
+{
+    return std::any_of(attributes_.begin(), attributes_.end(),
+        [&](const attribute& a) { return same_name(a.name, key); });
+}
+
+std::string reader::getAttribute(const qualified_name &key, const std::string &default_value) const
+{
+    for (const auto& a : attributes_) {
+        if (same_name(a.name, key)) return a.value;
+    }
+    return default_value;
+}
+
+const xnamespace* reader::lookupNamespace(std::string_view prefix) const
+{
+    for (auto it = bindings_.rbegin(); it != bindings_.rend(); ++it) {
+        const bool match = prefix.empty() ? !it->prefix.has_value()
+                                          : it->prefix.has_value() && it->prefix.value() == prefix;
+        if (match) {
+            // xmlns="" undeclares the default namespace
+            return it->uri.empty() ? nullptr : &*it;
+        }
+    }
+    return prefix == "xml" ? &xml_namespace : nullptr;
+}
+
+const xnamespace* reader::resolve(std::string_view prefix) const
+{
+    const xnamespace* ns = lookupNamespace(prefix);
+    if (ns == nullptr) throw parsing_error("Namespace prefix '" + std::string(prefix) + "' not declared");
+    return ns;
+}
+
+std::string reader::path() const
+{
+    std::string result;
+    for (const auto& element : stack_) {
+        result += '/';
+        result += element.qname;
+    }
+    return result;
+}
+
+void reader::reset()
+{
+    *this = reader();
+}
+
+event reader::nextEvent()
+{
+    if (close_pending_) {
+        close_pending_ = false;
+        closeElement();
+        return event::end_element;
+    }
+    if (pop_pending_) {
+        pop_pending_ = false;
+        bindings_.resize(stack_.back().bindings);
+        stack_.pop_back();
+        // they described the element just closed, its binding may be gone now
+        name_ = qualified_name();
+        xmlns_ = nullptr;
+    }
+
+    const std::string_view in = input();
+    while (true) {
+        if (pos_ >= in.size()) {
+            return finished_ ? endOfInput() : event::need_input;
+        }
+        const std::optional<event> ev = in[pos_] == '<' ? markup(in) : textRun(in);
+        if (ev.has_value()) return ev.value();
+    }
+}
+
+std::optional<event> reader::incomplete(const char *what) const
+{
+    if (!finished_) return event::need_input;
+    throw parsing_error(std::string("Unclosed ") + what);
+}
+
+std::optional<event> reader::markup(std::string_view in)
+{
+    const std::string_view rest = in.substr(pos_);
+    if (rest.size() < 2) return incomplete("markup");
+
+    if (rest[1] == '/') {
+        const size_t end = findClose(in, ">", 2);
+        if (end == std::string_view::npos) return incomplete("end tag");
+        const std::string_view tag = in.substr(pos_, end + 1 - pos_);
+        consume(end + 1);
+        return endTag(tag);
+    }
+
+    if (rest[1] == '?') {
+        const size_t end = findClose(in, "?>", 2);
+        if (end == std::string_view::npos) return incomplete("processing instruction");
+        const std::string_view whole = in.substr(pos_, end + 2 - pos_);
+        const std::string_view body = in.substr(pos_ + 2, end - pos_ - 2);
+        consume(end + 2);
+
+        size_t target_end = 0;
+        while (target_end < body.size() && !xis_space(body[target_end])) ++target_end;
+        if (target_end == 0) throw parsing_error("Processing instruction target is missing");
+        const std::string_view target = body.substr(0, target_end);
+
+        if (target == "xml" && !root_seen_ && !xml_declaration_.has_value() && !doctype_declaration_.has_value()) {
+            xml_declaration_ = std::string(whole);
+            return std::nullopt;
+        }
+        target_.assign(target);
+        text_.assign(xtrim(body.substr(target_end)));
+        return event::processing_instruction;
+    }
+
+    if (rest[1] == '!') {
+        if (rest.starts_with("<!--")) {
+            const size_t end = findClose(in, "-->", 4);
+            if (end == std::string_view::npos) return incomplete("comment");
+            text_.assign(in.substr(pos_ + 4, end - pos_ - 4));
+            consume(end + 3);
+            return event::comment;
+        }
+        if (rest.starts_with("<![CDATA[")) {
+            if (stack_.empty()) throw parsing_error("CDATA section outside the root element");
+            const size_t end = findClose(in, "]]>", 9);
+            if (end == std::string_view::npos) return incomplete("CDATA section");
+            text_.assign(in.substr(pos_ + 9, end - pos_ - 9));
+            consume(end + 3);
+            return event::cdata;
+        }
+        if (rest.starts_with("<!DOCTYPE")) {
+            if (root_seen_) throw parsing_error("DOCTYPE declaration after the root element");
+            const size_t end = findDoctypeEnd(in);
+            if (end == std::string_view::npos) return incomplete("DOCTYPE declaration");
+            doctype_declaration_ = std::string(in.substr(pos_, end + 1 - pos_));
+            consume(end + 1);
+            return std::nullopt;
+        }
+        // not enough input yet to tell which one it is
+        if (!finished_ && rest.size() < 9) {
+            for (std::string_view opener : { "<!--", "<![CDATA[", "<!DOCTYPE" }) {
+                if (opener.starts_with(rest)) return event::need_input;
+            }
+        }
+        throw parsing_error("Unknown markup declaration");
+    }
+
+    const size_t end = findTagEnd(in);
+    if (end == std::string_view::npos) return incomplete("start tag");
+    const std::string_view tag = in.substr(pos_, end + 1 - pos_);
+    consume(end + 1);
+    return startTag(tag);
+}
+
+std::optional<event> reader::textRun(std::string_view in)
+{
+    const size_t from = std::max(pos_, scan_);
+    const void* lt = std::memchr(in.data() + from, '<', in.size() - from);
+    size_t end = in.size();
+    if (lt != nullptr) {
+        end = static_cast<size_t>(static_cast<const char*>(lt) - in.data());
+    } else if (!finished_) {
+        scan_ = in.size();
+        return event::need_input;
+    }
+
+    const std::string_view raw = in.substr(pos_, end - pos_);
+    consume(end);
+
+    if (stack_.empty()) {
+        if (!xtrim(raw).empty()) throw parsing_error("Text outside the root element");
+        return std::nullopt;
+    }
+    const std::string_view run = stack_.back().preserve ? raw : xtrim(raw);
+    if (run.empty()) return std::nullopt;
+
+    if (skip_depth_ == 0) {
+        unescapeTextContent(text_, run);
+    }
+    return event::text;
+}
+
+event reader::startTag(std::string_view tag)
+{
+    if (stack_.empty() && root_seen_) throw parsing_error("More than one root element");
+
+    tag.remove_suffix(1); // '>'
+    const bool self_closing = tag.size() > 1 && tag.back() == '/';
+    if (self_closing) tag.remove_suffix(1);
+
+    size_t p = 1;
+    while (p < tag.size() && !xis_space(tag[p])) ++p;
+    const std::string_view qname = tag.substr(1, p - 1);
+    if (qname.empty()) throw parsing_error("Node name is missing");
+
+    // declarations first: they apply to the names of this very tag
+    const size_t bindings = bindings_.size();
+    declarations_.clear();
+    raw_attributes_.clear();
+    while (true) {
+        while (p < tag.size() && xis_space(tag[p])) ++p;
+        if (p >= tag.size()) break;
+
+        const size_t name_start = p;
+        while (p < tag.size() && tag[p] != '=' && !xis_space(tag[p])) ++p;
+        const std::string_view attr_name = tag.substr(name_start, p - name_start);
+        while (p < tag.size() && xis_space(tag[p])) ++p;
+        if (p >= tag.size() || tag[p] != '=') {
+            throw parsing_error("Expected '=' after attribute name '" + std::string(attr_name) + "'");
+        }
+        ++p;
+        while (p < tag.size() && xis_space(tag[p])) ++p;
+        if (p >= tag.size() || (tag[p] != '"' && tag[p] != '\'')) {
+            throw parsing_error("Attribute value must start with a quote");
+        }
+        const size_t close = tag.find(tag[p], p + 1);
+        if (close == std::string_view::npos) {
+            throw parsing_error("Unterminated value of attribute '" + std::string(attr_name) + "'");
+        }
+        const std::string_view value = tag.substr(p + 1, close - p - 1);
+        p = close + 1;
+
+        if (attr_name == "xmlns" || attr_name.starts_with("xmlns:")) {
+            xnamespace ns;
+            if (attr_name.size() > 5) ns.prefix = std::string(attr_name.substr(6));
+            unescapeTextContent(ns.uri, value);
+            bindings_.push_back(ns);
+            declarations_.push_back(std::move(ns));
+        } else {
+            raw_attributes_.emplace_back(attr_name, value);
+        }
+    }
+
+    bool preserve = !stack_.empty() && stack_.back().preserve;
+    attributes_.clear();
+    for (const auto& [attr_name, value] : raw_attributes_) {
+        attribute& a = attributes_.emplace_back();
+        a.name = qualified_name(attr_name);
+        if (a.name.prefix.has_value()) a.xmlns = lookupNamespace(a.name.prefix.value()); // lenient, like document
+        unescapeTextContent(a.value, value);
+        if (attr_name == "xml:space") preserve = a.value == "preserve";
+    }
+
+    name_ = qualified_name(qname);
+    xmlns_ = name_.prefix.has_value() ? resolve(name_.prefix.value()) : lookupNamespace("");
+    self_closing_ = self_closing;
+    close_pending_ = self_closing;
+    root_seen_ = true;
+    stack_.push_back(open_element{ std::string(qname), name_, xmlns_, bindings, preserve });
+    return event::start_element;
+}
+
+event reader::endTag(std::string_view tag)
+{
+    std::string_view qname = tag.substr(2, tag.size() - 3);
+    while (!qname.empty() && xis_space(qname.back())) qname.remove_suffix(1);
+
+    if (stack_.empty()) {
+        throw parsing_error("Unexpected end tag </" + std::string(qname) + ">");
+    }
+    if (qname != stack_.back().qname) {
+        throw parsing_error("End tag </" + stack_.back().qname + "> not found, got </" + std::string(qname) + ">");
+    }
+    self_closing_ = false;
+    closeElement();
+    return event::end_element;
+}
+
+void reader::closeElement()
+{
+    // popped on the next call, so xmlns() stays valid during end_element
+    name_ = stack_.back().name;
+    xmlns_ = stack_.back().xmlns;
+    attributes_.clear();
+    declarations_.clear();
+    pop_pending_ = true;
+}
+
+event reader::endOfInput() const
+{
+    if (!stack_.empty()) {
+        throw parsing_error("End tag </" + stack_.back().qname + "> not found");
+    }
+    if (!root_seen_) throw parsing_error("No root element");
+    return event::end_of_input;
+}
+
+size_t reader::findClose(std::string_view in, std::string_view close, size_t skip)
+{
+    const size_t from = std::max(pos_ + skip, scan_);
+    const size_t at = in.find(close, from);
+    if (at == std::string_view::npos) {
+        // resume where a terminator split by the chunk boundary could start
+        scan_ = in.size() >= close.size() ? std::max(from, in.size() - close.size() + 1) : from;
+    }
+    return at;
+}
+
+size_t reader::findTagEnd(std::string_view in)
+{
+    size_t i = std::max(pos_ + 1, scan_);
+    char quote = quote_;
+    while (i < in.size()) {
+        if (quote != 0) {
+            const void* q = std::memchr(in.data() + i, quote, in.size() - i);
+            if (q == nullptr) {
+                i = in.size();
+                break;
+            }
+            i = static_cast<size_t>(static_cast<const char*>(q) - in.data()) + 1;
+            quote = 0;
+            continue;
+        }
+        const char c = in[i];
+        if (c == '>') return i;
+        if (c == '"' || c == '\'') quote = c;
+        ++i;
+    }
+    scan_ = i;
+    quote_ = quote;
+    return std::string_view::npos;
+}
+
+size_t reader::findDoctypeEnd(std::string_view in)
+{
+    // small enough to be scanned again from the start when incomplete
+    int depth = 0;
+    char quote = 0;
+    for (size_t i = pos_ + 9; i < in.size(); ++i) {
+        const char c = in[i];
+        if (quote != 0) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '[') {
+            ++depth;
+        } else if (c == ']') {
+            --depth;
+        } else if (c == '>' && depth <= 0) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+void reader::consume(size_t end)
+{
+    pos_ = end;
+    scan_ = 0;
+    quote_ = 0;
+}
+
+} // namespace xml
@@ -0,0 +1,196 @@
+/*
+    XML writer implementation file,
+    As part of SharedCppLib2 project.
+*/
+#include "xml_writer.hpp"
+
+#include <algorithm>
+
+namespace xml
+{
+
+void writer::write(const node &n, int alignDepth)
+{
+    child(n, alignDepth);
+    drainAll();
+}
+
+void writer::write(const node &n, std::span<const node* const> children, int alignDepth)
+{
+    element(n, &children, alignDepth);
+    drainAll();
+}
+
+void writer::write(const document &doc)
+{
+    prolog(doc);
+    child(doc.root_node, 0);
+    drainAll();
+}
+
+void writer::write(const document &doc, std::span<const node* const> root_children)
+{
+    prolog(doc);
+    element(doc.root_node, &root_children, 0);
+    drainAll();
+}
+
+void writer::prolog(const document &doc)
+{
+    if (doc.xml_declaration.has_value()) {
+        buffer_ += *doc.xml_declaration;
+        buffer_ += '\n';
+    }
+    if (doc.doctype_declaration.has_value()) {
+        buffer_ += *doc.doctype_declaration;
+        buffer_ += '\n';
+    }
+}
+
+void writer::child(const node &n, int depth)
+{
+    switch (n.type()) {
+    case node::Type::Comment:
+        indent(depth);
+        buffer_ += "<!--";
+        if (n.text_content.has_value()) buffer_ += *n.text_content;
+        buffer_ += "-->";
+        break;
+    case node::Type::Text:
+        if (n.text_content.has_value()) escapeTextContent(buffer_, *n.text_content);
+        break;
+    case node::Type::ProcessingInstruction:
+        indent(depth);
+        buffer_ += "<?";
+        buffer_ += n.pi_target_;
+        buffer_ += ' ';
+        buffer_ += n.pi_data_;
+        buffer_ += "?>";
+        break;
+    case node::Type::Element:
+        element(n, nullptr, depth);
+        break;
+    }
+    drain();
+}
+
+// Same layout as node::serialize() always had, see there.
+void writer::element(const node &n, const std::span<const node* const>* children, int depth)
+{
+    bool has_children = children != nullptr ? !children->empty() : n.hasChildren();
+    bool has_text = n.text_content.has_value() && !n.text_content->empty();
+    bool full_tag = !n.attributes.empty() || n.hasTextContent() || has_children
+        ? true
+        : n.self_closing.value_or(!has_text && !has_children);
+
+    auto qualified = [&] {
+        if (n.xmlns.has_value() && !n.xmlns->isDefault()) {
+            buffer_ += n.xmlns->prefix.value_or("");
+            buffer_ += ':';
+        }
+        buffer_ += n.name;
+    };
+
+    indent(depth);
+    buffer_ += '<';
+    qualified();
+    if (!full_tag) {
+        buffer_ += " />";
+        return;
+    }
+
+    for (const auto &[key, value] : n.attributes) {
+        buffer_ += ' ';
+        if (key.prefix.has_value()) {
+            buffer_ += *key.prefix;
+            buffer_ += ':';
+        }
+        buffer_ += key.local_name;
+        buffer_ += "=\"";
+        escapeTextContent(buffer_, value);
+        buffer_ += '"';
+    }
+
+    // only namespaces declared here that are not already inherited
+    if (n.decl_xmlns.has_value()) {
+        for (const auto &ns : *n.decl_xmlns) {
+            if (n.inherited_xmlns.has_value()) {
+                bool inherited = std::ranges::any_of(*n.inherited_xmlns, [&](const xnamespace &inh) {
+                    return ns.prefix == inh.prefix && ns.uri == inh.uri;
+                });
+                if (inherited) continue;
+            }
+            buffer_ += " xmlns";
+            if (ns.prefix.has_value()) {
+                buffer_ += ':';
+                buffer_ += *ns.prefix;
+            }
+            buffer_ += "=\"";
+            escapeTextContent(buffer_, ns.uri);
+            buffer_ += '"';
+        }
+    }
+
+    buffer_ += '>';
+
+    // short single line text stays on the tag's line
+    if (n.text_content.has_value()) {
+        std::string_view text = *n.text_content;
+        bool multiline = text.find('\n') != std::string_view::npos;
+        if (!multiline && text.size() <= 60) {
+            // escaped aside: whether it still fits decides what goes in front of it
+            scratch_.clear();
+            escapeTextContent(scratch_, text);
+            if (scratch_.size() > 60) {
+                buffer_ += '\n';
+                indent(depth + 1);
+                buffer_ += scratch_;
+                buffer_ += '\n';
+                indent(depth);
+            } else {
+                buffer_ += scratch_;
+            }
+        } else {
+            buffer_ += '\n';
+            indent(depth + 1);
+            escapeTextContent(buffer_, text);
+            buffer_ += '\n';
+            indent(depth);
+        }
+    }
+
+    if (children != nullptr || n.children.has_value()) {
+        buffer_ += '\n';
+        if (children != nullptr) {
+            for (const node* c : *children) {
+                child(*c, depth + 1);
+                buffer_ += '\n';
+            }
+        } else {
+            for (const node &c : *n.children) {
+                child(c, depth + 1);
+                buffer_ += '\n';
+            }
+        }
+        indent(depth);
+    }
+
+    buffer_ += "</";
+    qualified();
+    buffer_ += '>';
+}
+
+void writer::drain()
+{
+    if (buffer_.size() >= chunk_size) drainAll();
+}
+
+void writer::drainAll()
+{
+    if (buffer_.empty()) return;
+    out_.write(buffer_.data(), buffer_.size());
+    written_ += buffer_.size();
+    buffer_.clear();
+}
+
+} // namespace xml
@@ -1,12 +1,17 @@
 /*
     [SCL_STANDALONE_MODULE]
-    version: 0.1.0
+    version: 0.3.0
 */
 
 #include "yaml.hpp"
 
 #include <stdexcept>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <utility>
 
 namespace scl2::yaml {
 
@@ -275,16 +280,59 @@ bool parser::parseNext(std::istream &input, document &out)
     if (input.eof())
         return false;
 
+    beginDocument();
+    bool started = std::exchange(_doc_open, false);
+    if (started && !_line.empty()) {
+        parseLine(); // left over from "--- value" that ended the previous document
+    }
+
+    while (readLine(input)) {
+        if (feat.multi_doc) {
+            if (isMarker(_line, "---")) {
+                // "--- value": the rest of the line is the first line of the document
+                size_t rest = _line.find_first_not_of(" \t\r", 3);
+                _line.erase(0, rest == std::string::npos ? _line.size() : rest);
+                if (started) {
+                    _doc_open = true; // the marker belongs to the next document
+                    break;
+                }
+                started = true;
+                if (_line.empty()) continue;
+            } else if (isMarker(_line, "...")) {
+                if (started) break;
+                continue;
+            } else if (!started && hasContent(_line, feat)) {
+                started = true;
+            }
+        }
+        parseLine();
+    }
+
+    if (feat.multi_doc && !started)
+        return false;
+
+    out = finishDocument();
+    return true;
+}
+
+void parser::beginDocument()
+{
+    // Every document picks its own indent unit; the parser is reused across
+    // documents (parseNext, fromStringAll workers), so nothing may carry over.
+    _line_pos = 0;
+    _line_num = 0;
+    _indent_level = 0;
+    _indent_unit = 0;
+
     // Push root frame
     _stack.clear();
     _anchors.clear();
     _pending_aliases.clear();
     _stack.push_back({0, value(), false});
+}
 
-    while (readLine(input)) {
-        parseLine();
-    }
-
+document parser::finishDocument()
+{
     // Pop all remaining frames so parent containers receive their children
     while (_stack.size() > 1) {
         popIndent();
@@ -302,11 +350,120 @@ bool parser::parseNext(std::istream &input, document &out)
         }
     }
 
-    if (!_stack.empty()) {
-        out = document(std::move(_stack[0].container));
-        return true;
+    return document(std::move(_stack[0].container));
+}
+
+void parser::parseText(std::string_view text, document &out)
+{
+    beginDocument();
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const char* nl = static_cast<const char*>(std::memchr(text.data() + pos, '\n', text.size() - pos));
+        const size_t end = nl ? static_cast<size_t>(nl - text.data()) : text.size();
+        _line.assign(text.substr(pos, end - pos));
+        _line_num += 1;
+        _line_pos = 0;
+        parseLine();
+        pos = end + 1;
+    }
+    out = finishDocument();
+}
+
+bool parser::isMarker(std::string_view line, std::string_view marker)
+{
+    return line.starts_with(marker)
+        && (line.size() == marker.size() || line[marker.size()] == ' ' || line[marker.size()] == '\t' || line[marker.size()] == '\r');
+}
+
+bool parser::hasContent(std::string_view line, const features &feat)
+{
+    const size_t first = line.find_first_not_of(" \t\r");
+    return first != std::string_view::npos && !(feat.comments && line[first] == '#');
+}
+
+std::vector<std::string_view> parser::splitDocuments(std::string_view input, features feat)
+{
+    std::vector<std::string_view> docs;
+    size_t begin = 0;
+    bool started = false; // opened by ---
+    bool content = false;
+
+    auto close = [&](size_t end) {
+        if (started || content) docs.push_back(input.substr(begin, end - begin));
+        started = false;
+        content = false;
+    };
+
+    size_t pos = 0;
+    while (pos < input.size()) {
+        const char* nl = static_cast<const char*>(std::memchr(input.data() + pos, '\n', input.size() - pos));
+        const size_t end = nl ? static_cast<size_t>(nl - input.data()) : input.size();
+        const std::string_view line = input.substr(pos, end - pos);
+
+        // markers only ever start at column 0, so most lines are decided by one character
+        if (!line.empty() && line[0] == '-' && isMarker(line, "---")) {
+            close(pos);
+            started = true;
+            size_t rest = line.find_first_not_of(" \t\r", 3);
+            begin = rest == std::string_view::npos ? end + 1 : pos + rest;
+            if (begin > input.size()) begin = input.size();
+        } else if (!line.empty() && line[0] == '.' && isMarker(line, "...")) {
+            close(pos);
+            begin = std::min(end + 1, input.size());
+        } else if (!content && hasContent(line, feat)) {
+            content = true;
+        }
+        pos = end + 1;
     }
-    return false;
+    close(input.size());
+    return docs;
+}
+
+std::vector<document> parser::fromStringAll(std::string_view input, features feat, unsigned threads)
+{
+    const std::vector<std::string_view> chunks = splitDocuments(input, feat);
+    std::vector<document> docs(chunks.size());
+    std::vector<std::optional<std::string>> errors(chunks.size());
+
+    // workers take the next unparsed document, each writes only its own slot
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        parser p;
+        p.feat = feat;
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < chunks.size();) {
+            try {
+                p.parseText(chunks[i], docs[i]);
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        }
+    };
+
+    size_t count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    count = std::min(count, chunks.size());
+    if (count <= 1) {
+        work();
+    } else {
+        std::vector<std::jthread> pool;
+        pool.reserve(count - 1);
+        for (size_t t = 1; t < count; ++t) pool.emplace_back(work);
+        work();
+    } // joined here
+
+    for (size_t i = 0; i < errors.size(); ++i) {
+        if (!errors[i]) continue;
+        std::string_view what = *errors[i];
+        if (what.starts_with("yaml: ")) what.remove_prefix(6);
+        throw yaml_exception("document " + std::to_string(i + 1) + ": " + std::string(what));
+    }
+    return docs;
+}
+
+std::vector<document> parser::fromStreamAll(std::istream &input, features feat, unsigned threads)
+{
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+    return fromStringAll(buffer.view(), feat, threads);
 }
 
 document document::fromStream(std::istream& input, features feat)
@@ -319,6 +476,16 @@ document document::fromString(const std::string& input, features feat)
     return parser::fromString(input, feat);
 }
 
+std::vector<document> document::fromStreamAll(std::istream& input, features feat, unsigned threads)
+{
+    return parser::fromStreamAll(input, feat, threads);
+}
+
+std::vector<document> document::fromStringAll(std::string_view input, features feat, unsigned threads)
+{
+    return parser::fromStringAll(input, feat, threads);
+}
+
 std::string document::toString(yaml_exporter::config cfg) const
 {
     return yaml_exporter().toString(*this, cfg);
@@ -467,9 +634,7 @@ void parser::dispatch_scalar(std::string text)
     if (isNull(text)) {
         addValue(value(nullptr));
     } else if (isBool(text)) {
-        addValue(value(text == "true" || text == "True" || text == "TRUE"
-                    || text == "yes" || text == "Yes" || text == "YES"
-                    || text == "on" || text == "On" || text == "ON"));
+        addValue(value(isTrue(text)));
     } else if (isInteger(text)) {
         addValue(value(std::stoll(text)));
     } else if (isDouble(text)) {
@@ -513,25 +678,32 @@ void parser::dispatch_sequence_entry()
     }
 }
 
-bool parser::isNull(const std::string &s)
+bool parser::isNull(std::string_view s)
 {
     return (s == "null" || s == "Null" || s == "NULL" || s == "~");
 }
 
-bool parser::isBool(const std::string &s)
+bool parser::isBool(std::string_view s)
 {
     return (s == "true" || s == "True" || s == "TRUE" || s == "false" || s == "False" || s == "FALSE"
             || s == "yes" || s == "Yes" || s == "YES" || s == "no" || s == "No" || s == "NO"
             || s == "on" || s == "On" || s == "ON" || s == "off" || s == "Off" || s == "OFF");
 }
 
-bool parser::isInteger(const std::string &s)
+bool parser::isTrue(std::string_view s)
+{
+    return (s == "true" || s == "True" || s == "TRUE"
+            || s == "yes" || s == "Yes" || s == "YES"
+            || s == "on" || s == "On" || s == "ON");
+}
+
+bool parser::isInteger(std::string_view s)
 {
     ///TODO: consider switching to regex.
     return !s.empty() && (s[0] == '-' || s[0] == '+' || isdigit(s[0])) && std::all_of(s.begin() + 1, s.end(), ::isdigit);
 }
 
-bool parser::isDouble(const std::string &s)
+bool parser::isDouble(std::string_view s)
 {
     if (s.empty()) return false;
     size_t i = 0;
@@ -557,7 +729,7 @@ bool parser::isDouble(const std::string &s)
     return has_dot; // must have a dot (or exponent) to be a double
 }
 
-std::string parser::processDoubleQuotedEscapes(const std::string &s)
+std::string parser::processDoubleQuotedEscapes(std::string_view s)
 {
     // we get the string without quotes here.
 
@@ -593,7 +765,7 @@ std::string parser::processDoubleQuotedEscapes(const std::string &s)
                 if (pos + 4 >= s.size()) {
                     throw yaml_exception("Incomplete Unicode escape in string");
                 }
-                std::string hex = s.substr(pos + 1, 4);
+                std::string hex(s.substr(pos + 1, 4));
                 uint32_t codepoint = std::stoul(hex, nullptr, 16);
                 // Encode as UTF-8
                 if (codepoint <= 0x7F) {
@@ -614,7 +786,7 @@ std::string parser::processDoubleQuotedEscapes(const std::string &s)
                 if (pos + 8 >= s.size()) {
                     throw yaml_exception("Incomplete Unicode escape in string");
                 }
-                std::string hex = s.substr(pos + 1, 8);
+                std::string hex(s.substr(pos + 1, 8));
                 uint32_t codepoint = std::stoul(hex, nullptr, 16);
                 // Encode as UTF-8
                 if (codepoint <= 0x7F) {
@@ -640,7 +812,7 @@ std::string parser::processDoubleQuotedEscapes(const std::string &s)
                 if (pos + 2 >= s.size()) {
                     throw yaml_exception("Incomplete hex escape in string");
                 }
-                std::string hex = s.substr(pos + 1, 2);
+                std::string hex(s.substr(pos + 1, 2));
                 result += static_cast<char>(std::stoi(hex, nullptr, 16));
                 pos += 2;
                 break;
@@ -0,0 +1,533 @@
+/*
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: yaml
+*/
+#include "yaml_arena.hpp"
+#include "yaml_lexer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+#include <unordered_set>
+#include <utility>
+
+namespace scl2::yaml {
+
+arena::arena(size_t block_size)
+    : block_size_(block_size)
+{
+}
+
+arena::arena(arena &&other) noexcept
+    : blocks_(std::move(other.blocks_)),
+      cur_(std::exchange(other.cur_, nullptr)),
+      left_(std::exchange(other.left_, 0)),
+      block_size_(other.block_size_),
+      used_(std::exchange(other.used_, 0)),
+      reserved_(std::exchange(other.reserved_, 0))
+{
+    other.blocks_.clear();
+}
+
+arena &arena::operator=(arena &&other) noexcept
+{
+    if (this != &other) {
+        blocks_ = std::move(other.blocks_);
+        other.blocks_.clear();
+        cur_ = std::exchange(other.cur_, nullptr);
+        left_ = std::exchange(other.left_, 0);
+        block_size_ = other.block_size_;
+        used_ = std::exchange(other.used_, 0);
+        reserved_ = std::exchange(other.reserved_, 0);
+    }
+    return *this;
+}
+
+void *arena::allocate(size_t size, size_t align)
+{
+    size_t pad = (align - reinterpret_cast<uintptr_t>(cur_) % align) % align;
+    if (pad + size > left_) {
+        grow(size + align);
+        pad = (align - reinterpret_cast<uintptr_t>(cur_) % align) % align;
+    }
+    std::byte* p = cur_ + pad;
+    cur_ = p + size;
+    left_ -= pad + size;
+    used_ += size;
+    return p;
+}
+
+std::string_view arena::store(std::string_view str)
+{
+    if (str.empty()) return {};
+    char* p = static_cast<char*>(allocate(str.size(), 1));
+    std::memcpy(p, str.data(), str.size());
+    return std::string_view(p, str.size());
+}
+
+void arena::reserve(size_t size)
+{
+    if (left_ < size) grow(size);
+}
+
+void arena::release()
+{
+    blocks_.clear();
+    cur_ = nullptr;
+    left_ = 0;
+    used_ = 0;
+    reserved_ = 0;
+}
+
+void arena::grow(size_t min_size)
+{
+    constexpr size_t max_block_size = 1024 * 1024;
+
+    // oversized requests get a block of their own, the rest grows geometrically
+    size_t size = std::max(block_size_, min_size);
+    blocks_.push_back(block{std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+    cur_ = blocks_.back().data.get();
+    left_ = size;
+    reserved_ += size;
+    if (block_size_ < max_block_size) block_size_ *= 2;
+}
+
+std::string_view node::alias_name() const
+{
+    if (!is_alias()) throw yaml_exception("node::alias_name: not an alias");
+    return data_.alias->name;
+}
+
+const node &node::resolve() const
+{
+    if (!is_alias()) throw yaml_exception("node::resolve: not an alias");
+    return *data_.alias->target; // chains are collapsed while parsing
+}
+
+bool node::as_bool() const
+{
+    const node& n = target();
+    if (n.type_ != yaml::type::boolean) throw yaml_exception("node::as_bool: not a boolean");
+    return n.data_.boolean;
+}
+
+int64_t node::as_int() const
+{
+    const node& n = target();
+    if (n.type_ != yaml::type::integer) throw yaml_exception("node::as_int: not an integer");
+    return n.data_.integer;
+}
+
+double node::as_double() const
+{
+    const node& n = target();
+    if (n.type_ == yaml::type::floating) return n.data_.floating;
+    if (n.type_ == yaml::type::integer) return static_cast<double>(n.data_.integer);
+    throw yaml_exception("node::as_double: not a number");
+}
+
+std::string_view node::as_string() const
+{
+    const node& n = target();
+    if (n.type_ != yaml::type::string) throw yaml_exception("node::as_string: not a string");
+    return std::string_view(n.data_.string, n.size_);
+}
+
+std::span<const node> node::elements() const
+{
+    const node& n = target();
+    if (n.type_ != yaml::type::array) throw yaml_exception("node::elements: not an array");
+    return std::span<const node>(n.data_.elements, n.size_);
+}
+
+const node &node::operator[](size_t index) const
+{
+    std::span<const node> items = elements();
+    if (index >= items.size()) throw std::out_of_range("node::operator[]: index out of range");
+    return items[index];
+}
+
+std::span<const member> node::members() const
+{
+    const node& n = target();
+    if (n.type_ != yaml::type::object) throw yaml_exception("node::members: not an object");
+    return std::span<const member>(n.data_.members, n.size_);
+}
+
+const uint32_t *node::sorted_index() const
+{
+    // stored right behind the member array, see arena_document::builder::close()
+    return reinterpret_cast<const uint32_t*>(data_.members + size_);
+}
+
+const node *node::find(std::string_view key) const
+{
+    const node& n = target();
+    if (n.type_ != yaml::type::object) throw yaml_exception("node::find: not an object");
+
+    const member* m = n.data_.members;
+    if (n.size_ <= indexed_object_size) {
+        for (uint32_t i = n.size_; i-- > 0;)
+            if (m[i].key == key) return &m[i].value;
+        return nullptr;
+    }
+
+    const uint32_t* order = n.sorted_index();
+    const uint32_t* it = std::upper_bound(order, order + n.size_, key,
+        [m](std::string_view k, uint32_t i) { return k < m[i].key; });
+    // the index is stable, so the last of equal keys is right before upper_bound
+    if (it != order && m[*(it - 1)].key == key) return &m[*(it - 1)].value;
+    return nullptr;
+}
+
+const node &node::operator[](std::string_view key) const
+{
+    const node* n = find(key);
+    if (!n) throw std::out_of_range("node::operator[]: key not found: " + std::string(key));
+    return *n;
+}
+
+size_t node::size() const
+{
+    const node& n = target();
+    if (n.type_ == yaml::type::array || n.type_ == yaml::type::object || n.type_ == yaml::type::string)
+        return n.size_;
+    return 0;
+}
+
+value node::to_value() const
+{
+    std::vector<const node*> open;
+    return toValue(open);
+}
+
+value node::toValue(std::vector<const node*>& open) const
+{
+    const node& n = target();
+    switch (n.type_) {
+    case yaml::type::boolean:  return value(n.data_.boolean);
+    case yaml::type::integer:  return value(n.data_.integer);
+    case yaml::type::floating: return value(n.data_.floating);
+    case yaml::type::string:   return value(std::string(n.data_.string, n.size_));
+    case yaml::type::array:
+    case yaml::type::object: {
+        // an alias to one of its own ancestors would expand forever
+        if (std::find(open.begin(), open.end(), &n) != open.end())
+            throw yaml_exception("node::to_value: recursive alias");
+        open.push_back(&n);
+        value result;
+        if (n.type_ == yaml::type::array) {
+            std::vector<value> arr;
+            arr.reserve(n.size_);
+            for (const node& e : n.elements()) arr.push_back(e.toValue(open));
+            result = value(std::move(arr));
+        } else {
+            std::map<std::string, value> obj;
+            for (const member& m : n.members())
+                obj.insert_or_assign(std::string(m.key), m.value.toValue(open)); // last one wins, like yaml::parser
+            result = value(std::move(obj));
+        }
+        open.pop_back();
+        return result;
+    }
+    default:
+        return value(nullptr);
+    }
+}
+
+/*
+    Block parser writing straight into the arena, the lines are split by block_lexer.
+
+    Entries of the open containers are collected on one scratch stack and
+    copied into the arena when their container closes, so every sequence and
+    mapping ends up contiguous. The value being filled is always the last
+    entry. Anchors are recorded against scratch slots and get their final
+    address at that point, aliases are resolved at the end of their document.
+*/
+class arena_document::builder : public block_handler {
+public:
+    builder(arena& mem, std::string_view text, features feat)
+        : mem(mem), text(text), lexer(feat) {}
+
+    std::span<const part> build()
+    {
+        // one block for the common case: nodes are far smaller than the text
+        mem.reserve(text.size() / 2 + 256);
+
+        size_t pos = 0;
+        while (pos < text.size()) {
+            const char* nl = static_cast<const char*>(std::memchr(text.data() + pos, '\n', text.size() - pos));
+            const size_t end = nl ? static_cast<size_t>(nl - text.data()) : text.size();
+            lexer.line(text.substr(pos, end - pos), *this);
+            pos = end + 1;
+        }
+        lexer.finish(*this);
+
+        part* stored = mem.allocate<part>(parts.size());
+        std::copy(parts.begin(), parts.end(), stored);
+        return std::span<const part>(stored, parts.size());
+    }
+
+private:
+    struct frame {
+        bool mapping;
+        size_t start; // first entry in `entries`
+        size_t slot;  // entry this container becomes the value of
+    };
+
+    struct pending_anchor {
+        std::string_view name;
+        size_t slot;
+        size_t order; // definitions in document order
+    };
+
+    void on_start_document() override
+    {
+        entries.push_back(member{}); // the root value
+    }
+
+    // stores the root, anchors do not reach into the next document
+    void on_end_document() override
+    {
+        node* root = mem.allocate<node>(1);
+        *root = entries[0].value;
+        while (!pending_anchors.empty()) {
+            defineAnchor(pending_anchors.back(), root);
+            pending_anchors.pop_back();
+        }
+        parts.push_back(part{root, resolveAliases()});
+
+        entries.clear();
+        defined.clear();
+        aliases.clear();
+    }
+
+    void on_open(bool mapping) override
+    {
+        frames.push_back(frame{mapping, entries.size(), entries.size() - 1});
+    }
+
+    void on_entry() override
+    {
+        entries.push_back(member{});
+    }
+
+    void on_key(const scalar_token& key) override
+    {
+        entries.push_back(member{intern(key.literal() ? key.text : mem.store(key.decode())), node()});
+    }
+
+    void on_anchor(std::string_view name) override
+    {
+        pending_anchors.push_back(pending_anchor{name, entries.size() - 1, anchor_count++});
+    }
+
+    void on_scalar(const scalar_token& s) override
+    {
+        node& n = entries.back().value;
+        n = node();
+        switch (s.type) {
+        case yaml::type::boolean:
+            n.type_ = yaml::type::boolean;
+            n.data_.boolean = s.data.boolean;
+            break;
+        case yaml::type::integer:
+            n.type_ = yaml::type::integer;
+            n.data_.integer = s.data.integer;
+            break;
+        case yaml::type::floating:
+            n.type_ = yaml::type::floating;
+            n.data_.floating = s.data.floating;
+            break;
+        case yaml::type::string: {
+            const std::string_view str = s.literal() ? s.text : mem.store(s.decode());
+            n.type_ = yaml::type::string;
+            n.size_ = static_cast<uint32_t>(str.size());
+            n.data_.string = str.data();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void on_alias(std::string_view name) override
+    {
+        anchor_entry* alias = mem.allocate<anchor_entry>(1);
+        *alias = anchor_entry{name, nullptr};
+        aliases.push_back(std::make_pair(anchor_count, alias));
+        node& n = entries.back().value;
+        n = node();
+        n.type_ = yaml::type::alias;
+        n.data_.alias = alias;
+    }
+
+    void on_close(bool) override
+    {
+        const frame f = frames.back();
+        frames.pop_back();
+
+        const size_t count = entries.size() - f.start;
+        node n;
+        n.size_ = static_cast<uint32_t>(count);
+        node* values = nullptr;
+        member* members = nullptr;
+
+        if (f.mapping) {
+            // larger mappings carry a sorted index of their members right behind them
+            const bool indexed = count > node::indexed_object_size;
+            const size_t bytes = count * sizeof(member) + (indexed ? count * sizeof(uint32_t) : 0);
+            members = static_cast<member*>(mem.allocate(bytes, alignof(member)));
+            std::copy(entries.begin() + f.start, entries.end(), members);
+            if (indexed) {
+                uint32_t* order = reinterpret_cast<uint32_t*>(members + count);
+                std::iota(order, order + count, 0u);
+                std::stable_sort(order, order + count,
+                    [members](uint32_t a, uint32_t b) { return members[a].key < members[b].key; });
+            }
+            n.type_ = yaml::type::object;
+            n.data_.members = members;
+        } else {
+            values = mem.allocate<node>(count);
+            for (size_t i = 0; i < count; ++i) values[i] = entries[f.start + i].value;
+            n.type_ = yaml::type::array;
+            n.data_.elements = values;
+        }
+
+        // anchored entries have their final address now
+        while (!pending_anchors.empty() && pending_anchors.back().slot >= f.start) {
+            const size_t i = pending_anchors.back().slot - f.start;
+            defineAnchor(pending_anchors.back(), f.mapping ? &members[i].value : &values[i]);
+            pending_anchors.pop_back();
+        }
+
+        entries.resize(f.start);
+        entries[f.slot].value = n;
+    }
+
+    std::string_view intern(std::string_view key)
+    {
+        return *keys.insert(key).first;
+    }
+
+    void defineAnchor(const pending_anchor& a, const node* target)
+    {
+        defined.push_back(std::make_pair(a.order, anchor_entry{a.name, target}));
+    }
+
+    std::span<const anchor_entry> resolveAliases()
+    {
+        std::sort(defined.begin(), defined.end(), [](const auto& a, const auto& b) {
+            return a.second.name != b.second.name ? a.second.name < b.second.name : a.first < b.first;
+        });
+        std::vector<anchor_entry> table;
+        table.reserve(defined.size());
+        for (size_t i = 0; i < defined.size(); ++i) {
+            if (i + 1 < defined.size() && defined[i + 1].second.name == defined[i].second.name) continue;
+            table.push_back(defined[i].second);
+        }
+
+        anchor_entry* stored = mem.allocate<anchor_entry>(table.size());
+        std::copy(table.begin(), table.end(), stored);
+        std::span<const anchor_entry> result(stored, table.size());
+
+        // an alias binds to the latest definition before it, `defined` is
+        // sorted by name and then by order; forward references are rejected
+        for (auto [seen, alias] : aliases) {
+            auto it = std::lower_bound(defined.begin(), defined.end(), std::make_pair(alias->name, seen),
+                [](const auto& d, const auto& key) {
+                    return d.second.name != key.first ? d.second.name < key.first : d.first < key.second;
+                });
+            if (it == defined.begin() || std::prev(it)->second.name != alias->name)
+                throw yaml_exception("unresolved alias: *" + std::string(alias->name));
+            alias->target = std::prev(it)->second.target;
+        }
+        // collapse alias -> alias chains, so resolve() is a single step
+        for (const auto& entry : aliases) {
+            anchor_entry* alias = entry.second;
+            const node* target = alias->target;
+            for (size_t steps = 0; target->type_ == yaml::type::alias; ++steps) {
+                if (steps > aliases.size()) throw yaml_exception("recursive alias: *" + std::string(alias->name));
+                target = target->data_.alias->target;
+            }
+            alias->target = target;
+        }
+        return result;
+    }
+
+    arena& mem;
+    std::string_view text;
+    block_lexer lexer;
+    std::vector<part> parts;
+
+    std::vector<member> entries; // entries[0] holds the root value, sequence entries have no key
+    std::vector<frame> frames;
+    std::unordered_set<std::string_view> keys;
+
+    std::vector<pending_anchor> pending_anchors;
+    size_t anchor_count = 0;
+    std::vector<std::pair<size_t, anchor_entry>> defined;
+    std::vector<std::pair<size_t, anchor_entry*>> aliases; // anchor_count when seen, alias
+};
+
+const node arena_document::null_node;
+
+arena_document arena_document::parse(std::string_view text, features feat)
+{
+    arena_document doc;
+    builder b(doc.arena_, text, feat);
+    doc.parts_ = b.build();
+    return doc;
+}
+
+arena_document arena_document::parse(std::string &&text, features feat)
+{
+    arena_document doc;
+    doc.owned_ = std::make_unique<std::string>(std::move(text));
+    builder b(doc.arena_, *doc.owned_, feat);
+    doc.parts_ = b.build();
+    return doc;
+}
+
+arena_document arena_document::fromStream(std::istream &input, features feat)
+{
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+    return parse(std::move(buffer).str(), feat);
+}
+
+const node &arena_document::root(size_t document) const
+{
+    if (document < parts_.size()) return *parts_[document].root;
+    if (document == 0) return null_node;
+    throw std::out_of_range("arena_document::root: document index out of range");
+}
+
+std::span<const anchor_entry> arena_document::anchors(size_t document) const
+{
+    if (document < parts_.size()) return parts_[document].anchors;
+    if (document == 0) return {};
+    throw std::out_of_range("arena_document::anchors: document index out of range");
+}
+
+const node *arena_document::anchor(std::string_view name, size_t document) const
+{
+    std::span<const anchor_entry> table = anchors(document);
+    auto it = std::lower_bound(table.begin(), table.end(), name,
+        [](const anchor_entry& e, std::string_view n) { return e.name < n; });
+    if (it == table.end() || it->name != name) return nullptr;
+    return it->target;
+}
+
+void arena_document::clear()
+{
+    arena_.release();
+    owned_.reset();
+    parts_ = {};
+}
+
+} // namespace scl2::yaml
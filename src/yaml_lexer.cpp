@@ -0,0 +1,333 @@
+/*
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: yaml
+*/
+#include "yaml_lexer.hpp"
+
+#include <charconv>
+#include <cstdlib>
+
+namespace scl2::yaml {
+
+std::string scalar_token::decode() const
+{
+    if (quote == '"') return parser::processDoubleQuotedEscapes(text);
+
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        result += text[i];
+        if (quote == '\'' && text[i] == '\'' && i + 1 < text.size() && text[i + 1] == '\'') ++i;
+    }
+    return result;
+}
+
+void block_lexer::line(std::string_view raw, block_handler &h)
+{
+    ++line_;
+    if (!raw.empty() && raw.back() == '\r') raw.remove_suffix(1);
+
+    size_t column = 0;
+    while (column < raw.size() && raw[column] == ' ') ++column;
+    if (column < raw.size() && raw[column] == '\t') {
+        if (raw.find_first_not_of(" \t", column) == std::string_view::npos) return;
+        fail("tabs are not allowed for indentation");
+    }
+
+    std::string_view t = raw.substr(column);
+    if (feat_.comments) t = stripComment(t);
+    while (!t.empty() && (t.back() == ' ' || t.back() == '\t')) t.remove_suffix(1);
+    if (t.empty()) return;
+
+    if (column == 0 && parser::isMarker(t, "...")) {
+        endDocument(h);
+        return;
+    }
+    if (column == 0 && parser::isMarker(t, "---")) {
+        endDocument(h);
+        startDocument(h);
+        t.remove_prefix(3);
+        while (!t.empty() && t.front() == ' ') t.remove_prefix(1);
+        if (t.empty()) return;
+        column = static_cast<size_t>(t.data() - raw.data());
+    }
+
+    if (!in_document_) startDocument(h);
+    content(column, t, h);
+}
+
+std::string_view block_lexer::stripComment(std::string_view t) const
+{
+    if (t.front() == '#') return {};
+    char quote = 0;
+    for (size_t i = 0; i < t.size(); ++i) {
+        const char c = t[i];
+        if (quote) {
+            if (c == '\\' && quote == '"') ++i;
+            else if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            // only a quote at the start of a token opens a quoted scalar ("it's" does not)
+            if (i == 0 || t[i - 1] == ' ') quote = c;
+        } else if (c == '#' && t[i - 1] == ' ') {
+            return t.substr(0, i);
+        }
+    }
+    return t;
+}
+
+void block_lexer::content(size_t column, std::string_view t, block_handler &h)
+{
+    const bool dash = isDash(t);
+
+    if (awaiting_) {
+        awaiting_ = false;
+        const bool nested = column > awaiting_indent_ || (column == awaiting_indent_ && awaiting_key_ && dash);
+        if (nested) {
+            block(column, t, dash, column == awaiting_indent_, h);
+            return;
+        }
+        h.on_scalar(scalar_token{}); // nothing nested: the value is null
+    }
+
+    while (!frames_.empty()) {
+        const frame& f = frames_.back();
+        if (f.indent > column || (f.indent == column && f.at_key && !dash)) close(h);
+        else break;
+    }
+
+    if (frames_.empty()) {
+        if (root_set_) fail("unexpected content after the end of the document");
+        root_set_ = true;
+        block(column, t, dash, false, h);
+        return;
+    }
+
+    const frame& f = frames_.back();
+    if (column != f.indent) fail("bad indentation");
+    if (dash) {
+        if (f.mapping) fail("expected a mapping key, but got a sequence entry");
+        sequenceEntry(column, t, h);
+    } else {
+        if (!f.mapping) fail("expected '- ' for a sequence entry");
+        mappingEntry(column, t, h);
+    }
+}
+
+// the first line of a block value
+void block_lexer::block(size_t column, std::string_view t, bool dash, bool at_key, block_handler &h)
+{
+    scalar_token key;
+    size_t after = 0;
+    if (dash) {
+        open(column, false, at_key, h);
+        sequenceEntry(column, t, h);
+    } else if (splitKey(t, key, after)) {
+        open(column, true, false, h);
+        mappingEntry(column, t, h);
+    } else {
+        inlineValue(column, t, column, false, h);
+    }
+}
+
+void block_lexer::sequenceEntry(size_t column, std::string_view t, block_handler &h)
+{
+    h.on_entry();
+    size_t off = 1;
+    while (off < t.size() && t[off] == ' ') ++off;
+    inlineValue(column + off, t.substr(off), column, false, h);
+}
+
+void block_lexer::mappingEntry(size_t column, std::string_view t, block_handler &h)
+{
+    scalar_token key;
+    size_t after = 0;
+    if (!splitKey(t, key, after)) fail("expected a mapping key");
+
+    h.on_key(key);
+    while (after < t.size() && t[after] == ' ') ++after;
+    inlineValue(column + after, t.substr(after), column, true, h);
+}
+
+// the rest of a line after "key:" or "- "
+void block_lexer::inlineValue(size_t column, std::string_view t, size_t owner_indent, bool from_key, block_handler &h)
+{
+    if (feat_.anchors && !t.empty() && t.front() == '&') {
+        size_t end = t.find(' ');
+        std::string_view name = t.substr(1, end == std::string_view::npos ? std::string_view::npos : end - 1);
+        if (name.empty()) fail("empty anchor name");
+        h.on_anchor(name);
+        if (end == std::string_view::npos) {
+            t = {};
+        } else {
+            while (end < t.size() && t[end] == ' ') ++end;
+            column += end;
+            t.remove_prefix(end);
+        }
+    }
+
+    if (t.empty()) {
+        awaiting_ = true;
+        awaiting_indent_ = owner_indent;
+        awaiting_key_ = from_key;
+        return;
+    }
+
+    // compact forms: "- key: value", "- - value"
+    if (!from_key) {
+        scalar_token key;
+        size_t after = 0;
+        if (isDash(t)) {
+            open(column, false, false, h);
+            sequenceEntry(column, t, h);
+            return;
+        }
+        if (splitKey(t, key, after)) {
+            open(column, true, false, h);
+            mappingEntry(column, t, h);
+            return;
+        }
+    }
+
+    scalar(t, h);
+}
+
+void block_lexer::scalar(std::string_view t, block_handler &h) const
+{
+    scalar_token s;
+    if (t.size() >= 2 && ((t.front() == '"' && t.back() == '"') || (t.front() == '\'' && t.back() == '\''))) {
+        s.type = yaml::type::string;
+        s.quote = t.front();
+        s.text = t.substr(1, t.size() - 2);
+        s.literal_ = s.text.find(s.quote == '"' ? std::string_view("\\") : std::string_view("''")) == std::string_view::npos;
+        h.on_scalar(s);
+        return;
+    }
+
+    if (feat_.anchors && t.size() >= 2 && t.front() == '*' && t[1] != ' ') {
+        h.on_alias(t.substr(1));
+        return;
+    }
+
+    // empty flow collections
+    if (t == "[]" || t == "{}") {
+        const bool mapping = t == "{}";
+        h.on_open(mapping);
+        h.on_close(mapping);
+        return;
+    }
+
+    if (parser::isNull(t)) {
+        h.on_scalar(s);
+        return;
+    }
+    if (parser::isBool(t)) {
+        s.type = yaml::type::boolean;
+        s.data.boolean = parser::isTrue(t);
+        h.on_scalar(s);
+        return;
+    }
+
+    std::string_view number = t.front() == '+' ? t.substr(1) : t;
+    if (!number.empty() && number != "-" && parser::isInteger(t)) {
+        auto [ptr, ec] = std::from_chars(number.data(), number.data() + number.size(), s.data.integer);
+        if (ec == std::errc() && ptr == number.data() + number.size()) {
+            s.type = yaml::type::integer;
+            h.on_scalar(s);
+            return;
+        }
+        // too large for int64_t, fall through to double
+    }
+    if (parser::isDouble(t) || parser::isInteger(t)) {
+        double d = 0;
+        auto [ptr, ec] = std::from_chars(number.data(), number.data() + number.size(), d);
+        if (ec == std::errc::result_out_of_range) d = std::strtod(std::string(number).c_str(), nullptr);
+        if (ec == std::errc() || ec == std::errc::result_out_of_range) {
+            s.type = yaml::type::floating;
+            s.data.floating = d;
+            h.on_scalar(s);
+            return;
+        }
+    }
+
+    s.type = yaml::type::string;
+    s.text = t;
+    h.on_scalar(s);
+}
+
+// "key: value" / "key:" / "\"quoted key\": value"; `after` is the position behind the colon
+bool block_lexer::splitKey(std::string_view t, scalar_token &key, size_t &after) const
+{
+    key.type = yaml::type::string;
+    if (t.front() == '"' || t.front() == '\'') {
+        const char q = t.front();
+        size_t close = 1;
+        bool literal = true;
+        for (; close < t.size(); ++close) {
+            if (q == '"' && t[close] == '\\') { ++close; literal = false; continue; }
+            if (t[close] == q) {
+                if (q == '\'' && close + 1 < t.size() && t[close + 1] == '\'') { ++close; literal = false; continue; }
+                break;
+            }
+        }
+        if (close >= t.size()) return false;
+        size_t p = close + 1;
+        while (p < t.size() && t[p] == ' ') ++p;
+        if (p >= t.size() || t[p] != ':' || (p + 1 < t.size() && t[p + 1] != ' ')) return false;
+        key.quote = q;
+        key.text = t.substr(1, close - 1);
+        key.literal_ = literal;
+        after = p + 1;
+        return true;
+    }
+
+    for (size_t i = 0; i < t.size(); ++i) {
+        if (t[i] != ':' || (i + 1 < t.size() && t[i + 1] != ' ')) continue;
+        key.text = t.substr(0, i);
+        while (!key.text.empty() && key.text.back() == ' ') key.text.remove_suffix(1);
+        after = i + 1;
+        return true;
+    }
+    return false;
+}
+
+void block_lexer::startDocument(block_handler &h)
+{
+    h.on_start_document();
+    in_document_ = true;
+    root_set_ = false;
+}
+
+void block_lexer::endDocument(block_handler &h)
+{
+    if (!in_document_) return;
+    if (awaiting_) {
+        awaiting_ = false;
+        h.on_scalar(scalar_token{});
+    }
+    while (!frames_.empty()) close(h);
+    if (!root_set_) h.on_scalar(scalar_token{}); // an empty document is null
+    h.on_end_document();
+    in_document_ = false;
+    root_set_ = false;
+}
+
+void block_lexer::open(size_t column, bool mapping, bool at_key, block_handler &h)
+{
+    h.on_open(mapping);
+    frames_.push_back(frame{column, mapping, at_key});
+}
+
+void block_lexer::close(block_handler &h)
+{
+    h.on_close(frames_.back().mapping);
+    frames_.pop_back();
+}
+
+void block_lexer::fail(const std::string &message) const
+{
+    throw yaml_exception("line " + std::to_string(line_) + ": " + message);
+}
+
+} // namespace scl2::yaml
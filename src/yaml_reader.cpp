@@ -0,0 +1,201 @@
+/*
+    [SCL_STANDALONE_MODULE]
+    version: 1.0.0
+    cpp_generation: cxx20 - cxx23
+    standalone_dependency: yaml
+*/
+#include "yaml_reader.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace scl2::yaml {
+
+reader::reader(features feat)
+    : feat_(feat), lexer_(feat)
+{
+}
+
+void reader::feed(std::string_view chunk)
+{
+    if (finished_) throw yaml_exception("reader::feed: input already finished");
+
+    // drop the consumed part once it is at least half of the buffer
+    if (offset_ != 0 && offset_ >= buffer_.size() / 2) {
+        buffer_.erase(0, offset_);
+        offset_ = 0;
+    }
+    buffer_.append(chunk);
+}
+
+void reader::finish()
+{
+    finished_ = true;
+}
+
+event reader::next()
+{
+    while (true) {
+        while (queue_head_ == queue_.size()) {
+            queue_.clear();
+            queue_head_ = 0;
+            if (ended_) return event::end_of_input;
+
+            std::string_view text;
+            if (takeLine(text)) {
+                lexer_.line(text, *this);
+            } else if (finished_) {
+                lexer_.finish(*this);
+                ended_ = true;
+            } else {
+                return event::need_input;
+            }
+        }
+
+        item& it = queue_[queue_head_++];
+        const event ev = it.type;
+
+        // the consumer side path, independent of how far the producer got
+        if (ev == event::scalar || ev == event::alias || ev == event::start_mapping || ev == event::start_sequence) {
+            if (!path_.empty() && !path_.back().mapping) ++path_.back().count;
+        }
+        last_start_ = false;
+        switch (ev) {
+        case event::start_mapping:
+        case event::start_sequence:
+            path_.push_back(segment{ev == event::start_mapping, 0, {}});
+            last_start_ = true;
+            anchor_ = std::move(it.anchor);
+            break;
+        case event::end_mapping:
+        case event::end_sequence:
+            path_.pop_back();
+            break;
+        case event::key:
+            key_ = std::move(it.text);
+            path_.back().key = key_;
+            break;
+        case event::scalar:
+            scalar_ = std::move(it.scalar);
+            anchor_ = std::move(it.anchor);
+            break;
+        case event::alias:
+            alias_ = std::move(it.text);
+            break;
+        default:
+            break;
+        }
+
+        if (skip_depth_ == 0) return ev;
+        if ((ev == event::end_mapping || ev == event::end_sequence) && path_.size() < skip_depth_) {
+            skip_depth_ = 0;
+            return ev;
+        }
+    }
+}
+
+bool reader::dispatch(event_handler &handler)
+{
+    while (true) {
+        switch (next()) {
+        case event::need_input:     return true;
+        case event::end_of_input:   return false;
+        case event::start_document: handler.on_start_document(); break;
+        case event::end_document:   handler.on_end_document(); break;
+        case event::start_mapping:  handler.on_start_mapping(anchor_); break;
+        case event::end_mapping:    handler.on_end_mapping(); break;
+        case event::start_sequence: handler.on_start_sequence(anchor_); break;
+        case event::end_sequence:   handler.on_end_sequence(); break;
+        case event::key:            handler.on_key(key_); break;
+        case event::scalar:         handler.on_scalar(scalar_, anchor_); break;
+        case event::alias:          handler.on_alias(alias_); break;
+        }
+    }
+}
+
+void reader::skip()
+{
+    if (!last_start_)
+        throw yaml_exception("reader::skip: not at the start of a mapping or sequence");
+    skip_depth_ = path_.size();
+}
+
+std::string reader::path() const
+{
+    std::string result;
+    const size_t n = path_.size() - (last_start_ ? 1 : 0);
+    for (size_t i = 0; i < n; ++i) {
+        result += '/';
+        if (!path_[i].mapping) {
+            result += std::to_string(path_[i].count - 1);
+            continue;
+        }
+        for (char c : path_[i].key) {
+            if (c == '~') result += "~0";
+            else if (c == '/') result += "~1";
+            else result += c;
+        }
+    }
+    return result;
+}
+
+void reader::reset()
+{
+    *this = reader(feat_);
+}
+
+bool reader::takeLine(std::string_view &line)
+{
+    const char* begin = buffer_.data() + offset_;
+    const size_t left = buffer_.size() - offset_;
+    const char* nl = static_cast<const char*>(std::memchr(begin, '\n', left));
+    if (nl) {
+        line = std::string_view(begin, static_cast<size_t>(nl - begin));
+        offset_ += line.size() + 1;
+        return true;
+    }
+    if (finished_ && left != 0) {
+        line = std::string_view(begin, left);
+        offset_ = buffer_.size();
+        return true;
+    }
+    return false;
+}
+
+void reader::on_key(const scalar_token &key)
+{
+    emit(event::key, key.literal() ? std::string(key.text) : key.decode());
+}
+
+void reader::on_scalar(const scalar_token &scalar)
+{
+    switch (scalar.type) {
+    case yaml::type::boolean:  emit(event::scalar, {}, value(scalar.data.boolean)); break;
+    case yaml::type::integer:  emit(event::scalar, {}, value(scalar.data.integer)); break;
+    case yaml::type::floating: emit(event::scalar, {}, value(scalar.data.floating)); break;
+    case yaml::type::string:
+        emit(event::scalar, {}, value(scalar.literal() ? std::string(scalar.text) : scalar.decode()));
+        break;
+    default:
+        emit(event::scalar);
+        break;
+    }
+}
+
+void reader::on_alias(std::string_view name)
+{
+    pending_anchor_.clear(); // an alias node cannot carry an anchor
+    emit(event::alias, std::string(name));
+}
+
+void reader::emit(event type, std::string text, value scalar)
+{
+    item& it = queue_.emplace_back();
+    it.type = type;
+    it.text = std::move(text);
+    it.scalar = std::move(scalar);
+    if (type == event::scalar || type == event::start_mapping || type == event::start_sequence)
+        it.anchor = std::exchange(pending_anchor_, {});
+}
+
+} // namespace scl2::yaml